@@ -1,10 +1,10 @@
-#include <TFT_eSPI.h>
+#include "display.h"
 #include <WiFi.h>
-#include <WiFiUdp.h>
-#include <Preferences.h>
 
-#include "touch.h"
+#include "input.h"
+#include "mirror.h"
 #include "keyboard.h"
+#include "kinetic_scroll.h"
 
 #include "desktop.h"
 #include "chat_app.h"
@@ -18,43 +18,56 @@
 #include "settings_store.h"
 #include "system_ui.h"
 #include "trash_state.h"
+#include "config.h"
+#include "persist.h"
+#include "app_arena.h"
+#include "text_metrics.h"
 
 #include "welcome.h"
 
-TFT_eSPI tft;
-WiFiUDP mouseUdp;
-static bool mouseUdpStarted = false;
+Display tft;
 
-enum AppState { APP_DESKTOP, APP_CHAT, APP_PAINT, APP_WIFI, APP_INTERNET, APP_NOTES, APP_TRASH, APP_SETTINGS };
+enum AppState { APP_DESKTOP, APP_CHAT, APP_PAINT, APP_WIFI, APP_INTERNET, APP_NOTES, APP_TRASH, APP_SETTINGS, APP_COUNT };
 static AppState app = APP_DESKTOP;
 
 static bool autoConnectStarted = false;
 static uint32_t autoConnectStartMs = 0;
 
-// Mouse bridge (UDP)
-static const uint16_t MOUSE_UDP_PORT = 4210;
-static bool mouseActive = false;
-static bool mousePressed = false;
+// The pointer as the apps see it, rebuilt from input events. While one
+// source holds it down, events from the other are ignored.
+static bool lastPressed = false;
+static bool pointerDown = false;
+static InputSource pointerSource = INPUT_SRC_TOUCH;
+static int pointerX = 0;
+static int pointerY = 0;
+
+// The UDP mouse counts as in use (cursor shown, desktop in mouse mode)
+// while the bridge is connected.
 static int  mouseX = 0;
 static int  mouseY = 0;
-static uint32_t mouseActiveUntil = 0;
-static int  mouseWheel = 0;
-static bool mouseDebug = false;
 static int lastDrawX = -1;
 static int lastDrawY = -1;
 
+static void cursor_restore();
+static void cursor_draw(int x, int y);
+
 static void cursor_reset() {
   cursor_restore();
   lastDrawX = -1;
   lastDrawY = -1;
 }
 
+static bool mouse_active() {
+  return input_mouse_connected();
+}
+
 static void mouse_cursor_update() {
+  bool active = mouse_active();
   // Debug indicator: small dot in top-left when UDP mouse is active
-  if (mouseDebug) {
+  if (active) {
     tft.fillRect(2, 2, 4, 4, TFT_WHITE);
   }
-  if (mouseActive && millis() < mouseActiveUntil) {
+  if (active) {
     if (mouseX != lastDrawX || mouseY != lastDrawY) {
       cursor_restore();
       cursor_draw(mouseX, mouseY);
@@ -77,6 +90,8 @@ static uint16_t cursorBuf[CUR_W * CUR_H];
 
 static void cursor_restore() {
   if (cursorX < 0 || cursorY < 0) return;
+  DisplayScope prevScope = display_stats_scope();
+  display_stats_set_scope(DS_SCOPE_CURSOR);
   int idx = 0;
   for (int yy = 0; yy < CUR_H; yy++) {
     for (int xx = 0; xx < CUR_W; xx++) {
@@ -90,6 +105,7 @@ static void cursor_restore() {
   }
   cursorX = -1;
   cursorY = -1;
+  display_stats_set_scope(prevScope);
 }
 
 static void cursor_draw(int x, int y) {
@@ -100,6 +116,9 @@ static void cursor_draw(int x, int y) {
   if (ox + CUR_W > 320) ox = 320 - CUR_W;
   if (oy + CUR_H > 240) oy = 240 - CUR_H;
 
+  DisplayScope prevScope = display_stats_scope();
+  display_stats_set_scope(DS_SCOPE_CURSOR);
+
   // Save background
   int idx = 0;
   for (int yy = 0; yy < CUR_H; yy++) {
@@ -144,33 +163,7 @@ static void cursor_draw(int x, int y) {
       tft.drawPixel(ox + xx, oy + yy, edge ? TFT_BLACK : TFT_WHITE);
     }
   }
-}
-
-static void mouse_udp_poll() {
-  int packetSize = mouseUdp.parsePacket();
-  if (packetSize <= 0) return;
-
-  char buf[64];
-  int len = mouseUdp.read(buf, sizeof(buf) - 1);
-  if (len <= 0) return;
-  buf[len] = 0;
-
-  int x = 0, y = 0, p = 0, w = 0;
-  int n = sscanf(buf, "%d,%d,%d,%d", &x, &y, &p, &w);
-  if (n >= 3) {
-    if (x < 0) x = 0;
-    if (y < 0) y = 0;
-    if (x > 319) x = 319;
-    if (y > 239) y = 239;
-    mouseX = x;
-    mouseY = y;
-    mousePressed = (p != 0);
-    mouseWheel = (n == 4) ? w : 0;
-    mouseActive = true;
-    mouseActiveUntil = millis() + 1000;
-    mouseDebug = true;
-    // no serial spam
-  }
+  display_stats_set_scope(prevScope);
 }
 
 static inline bool inRect(int x,int y,int rx,int ry,int rw,int rh){
@@ -184,39 +177,136 @@ static void show_welcome(uint32_t ms = 800) {
 }
 
 static void startAutoConnectNonBlocking() {
-  Preferences p;
-  p.begin("wifi", true);
-  String ssid = p.getString("ssid", "");
-  String pass = p.getString("pass", "");
-  p.end();
-
-  ssid.trim();
-  pass.trim();
-  if (ssid.length() == 0) return;
+  const char* ssid = config_get_wifi_ssid();
+  const char* pass = config_get_wifi_pass();
+  if (!ssid[0]) return;
 
   WiFi.mode(WIFI_STA);
   WiFi.setSleep(false);
 
-  if (pass.length() == 0) WiFi.begin(ssid.c_str());
-  else WiFi.begin(ssid.c_str(), pass.c_str());
+  if (!pass[0]) WiFi.begin(ssid);
+  else WiFi.begin(ssid, pass);
 
   autoConnectStarted = true;
   autoConnectStartMs = millis();
 }
 
+// ---------- Apps ----------
+// Each app is one row of APPS: loop() only ticks the app in front (and
+// the few marked background), and opening, closing, pointer, wheel and
+// key input all go through the same few calls below.
+struct AppDesc {
+  const char* name;
+  DisplayScope scope;       // draw stats are charged here
+  void (*open)();           // draws it; called when it comes to the front
+  void (*tick)();
+  // One pointer state; returns false once the app has closed itself.
+  bool (*handleInput)(bool pressed, bool lastPressed, int x, int y);
+  void (*release)();        // the pointer was lifted
+  void (*close)();          // another app comes to the front
+  void (*wheel)(int steps);
+  void (*keys)(const char* keys, int n);
+  bool background;          // ticked even when not in front
+};
+
+static void open_app(AppState a);
+
+static AppState appForAction(DesktopAction a) {
+  switch (a) {
+    case DESKTOP_OPEN_CHAT:     return APP_CHAT;
+    case DESKTOP_OPEN_PAINT:    return APP_PAINT;
+    case DESKTOP_OPEN_WIFI:     return APP_WIFI;
+    case DESKTOP_OPEN_INTERNET: return APP_INTERNET;
+    case DESKTOP_OPEN_NOTES:    return APP_NOTES;
+    case DESKTOP_OPEN_TRASH:    return APP_TRASH;
+    case DESKTOP_OPEN_SETTINGS: return APP_SETTINGS;
+    default:                    return APP_DESKTOP;
+  }
+}
+
+static bool desktopInput(bool pressed, bool lastPressed, int x, int y) {
+  desktop_set_mouse_mode(mouse_active());
+  AppState next = appForAction(desktop_handleTouch(pressed, lastPressed, x, y));
+  if (next != APP_DESKTOP) open_app(next);
+  return true;
+}
+
+static void chatOpen() {
+  keyboard_clear();
+  chat_draw();
+}
+
+static bool chatInput(bool pressed, bool lastPressed, int x, int y) {
+  if (pressed && !lastPressed && inRect(x, y, 260, 4, 52, 17)) return false;
+  chat_handleTouch(pressed, lastPressed, x, y);
+  return true;
+}
+
+static void chatRelease() {
+  keyboard_release();
+  chat_release();
+}
+
+static bool paintInput(bool pressed, bool lastPressed, int x, int y) {
+  if (pressed && !lastPressed && x >= 320 - 16 - 6 && x < 320 - 6 && y >= 2 && y < 16) return false;
+  return !pressed || paint_handleTouch(x, y);
+}
+
+static const AppDesc APPS[APP_COUNT] = {
+  // name        scope              open               tick               handleInput               release           close             wheel                   keys            bg
+  { "Desktop",   DS_SCOPE_DESKTOP,  desktop_draw,      desktop_tick,      desktopInput,             nullptr,          desktop_close,    nullptr,                nullptr,        false },
+  // A reply still streaming when the window is closed lands in the history.
+  { "Chat",      DS_SCOPE_CHAT,     chatOpen,          chat_tick,         chatInput,                chatRelease,      chat_close,       chat_scroll_steps,      chat_keys,      true  },
+  { "Paint",     DS_SCOPE_PAINT,    paint_open,        paint_tick,        paintInput,               paint_release,    paint_close,      nullptr,                nullptr,        false },
+  // Connecting and rescanning carry on after the window is closed.
+  { "Wi-Fi",     DS_SCOPE_WIFI,     wifi_app_open,     wifi_app_tick,     wifi_app_handleTouch,     nullptr,          nullptr,          nullptr,                wifi_app_keys,  true  },
+  { "Internet",  DS_SCOPE_INTERNET, internet_app_open, internet_app_tick, internet_app_handleTouch, nullptr,          kinetic_release,  nullptr,                nullptr,        false },
+  { "Notes",     DS_SCOPE_NOTES,    notes_app_open,    notes_app_tick,    notes_app_handleTouch,    keyboard_release, notes_app_close,  notes_app_scroll_steps, notes_app_keys, false },
+  { "Trash",     DS_SCOPE_TRASH,    trash_app_open,    trash_app_tick,    trash_app_handleTouch,    nullptr,          nullptr,          nullptr,                nullptr,        false },
+  { "Settings",  DS_SCOPE_SETTINGS, settings_app_open, settings_app_tick, settings_app_handleTouch, nullptr,          nullptr,          nullptr,                nullptr,        false },
+};
+
+// Brings app a to the front: the old one is closed and a is opened. The
+// app arena is handed over empty.
+static void open_app(AppState a) {
+  if (a != app) {
+    if (APPS[app].close) APPS[app].close();
+    // Whatever the old app left dirty goes to flash before the next one opens.
+    persist_flush();
+  }
+  app_arena_reset();
+  app = a;
+  display_stats_set_scope(APPS[a].scope);
+  cursor_reset();
+  APPS[a].open();
+}
+
+// Hands one pointer state to the foreground app; lastPressed is what the
+// previous call saw. A press that opens or closes an app is used up.
+static void dispatch(bool pressed, int x, int y) {
+  if (!pressed && lastPressed && APPS[app].release) APPS[app].release();
+
+  AppState before = app;
+  if (!APPS[app].handleInput(pressed, lastPressed, x, y)) open_app(APP_DESKTOP);
+  lastPressed = app != before ? true : pressed;
+}
+
 void setup() {
   Serial.begin(115200);
 
   tft.init();
   tft.setRotation(1);
+  mirror_init(&tft);
+  // Wrapping and caret placement trust the width tables; say so if the
+  // fonts in this build disagree.
+  text_metrics_check(&tft);
 
   show_welcome(800);
 
-  settings_store_init();
+  config_init();
   settings_apply_brightness();
-  trash_state_init();
 
-  touch_init();
+  input_init();
   keyboard_init(&tft);
 
   paint_init(&tft);
@@ -231,7 +321,7 @@ void setup() {
   desktop_init(&tft);
   chat_init(&tft);
 
-  desktop_draw();
+  open_app(APP_DESKTOP);
 
   if (settings_get_autoconnect()) {
     startAutoConnectNonBlocking();
@@ -239,20 +329,21 @@ void setup() {
 }
 
 void loop() {
-  static bool lastPressed = false;
-  static int lastX = 0;
-  static int lastY = 0;
-
-  wifi_app_tick();
-  internet_app_tick();
-  notes_app_tick();
-  trash_app_tick();
-  settings_app_tick();
-  if (app == APP_DESKTOP) desktop_tick();
-  if (app == APP_CHAT) chat_tick();
-  if (app == APP_PAINT) paint_tick();
+  // Background ticks may draw while another app is in front; charge their
+  // pixels to the app that owns them.
+  for (int a = 0; a < APP_COUNT; a++) {
+    if (a == app || !APPS[a].background) continue;
+    display_stats_set_scope(APPS[a].scope);
+    APPS[a].tick();
+  }
+  display_stats_set_scope(APPS[app].scope);
+  APPS[app].tick();
   ai_pollSerial();
 
+  // Deferred flash writes go out between gestures, never in the middle
+  // of a drag or a key repeat.
+  if (!lastPressed) persist_idle();
+
   if (autoConnectStarted) {
     wl_status_t st = WiFi.status();
     if (st == WL_CONNECTED) {
@@ -264,234 +355,45 @@ void loop() {
     }
   }
 
-  if (!mouseUdpStarted && WiFi.status() == WL_CONNECTED) {
-    mouseUdp.begin(MOUSE_UDP_PORT);
-    mouseUdpStarted = true;
-    Serial.println("UDP mouse listener started");
-  }
-
-  mouse_udp_poll();
-
-  int x = lastX, y = lastY;
-  bool pressed = false;
-
-  if (mouseActive && millis() < mouseActiveUntil) {
-    x = mouseX;
-    y = mouseY;
-    pressed = mousePressed;
-  } else {
-    mouseActive = false;
-    mouseDebug = false;
-    pressed = touch_is_pressed();
-    if (pressed) {
-      if (!touch_get(x, y)) {
-        lastPressed = pressed;
-        return;
-      }
-      lastX = x;
-      lastY = y;
-    }
-  }
-
-  if (mouseActive && mouseWheel != 0) {
-    if (app == APP_NOTES) {
-      notes_app_scroll_steps(mouseWheel);
-    }
-    mouseWheel = 0;
-  }
-
-  if (!pressed && lastPressed) {
-    keyboard_release();
-    paint_release();
-    if (app == APP_CHAT) chat_release();
-  }
-
-  if (app == APP_WIFI) {
-    bool keepOpen = wifi_app_handleTouch(pressed, lastPressed, x, y);
-    if (!keepOpen) {
-      app = APP_DESKTOP;
-      cursor_reset();
-      desktop_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
-  }
-
-  if (app == APP_INTERNET) {
-    bool keepOpen = internet_app_handleTouch(pressed, lastPressed, x, y);
-    if (!keepOpen) {
-      app = APP_DESKTOP;
-      cursor_reset();
-      desktop_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
-  }
-
-  if (app == APP_NOTES) {
-    bool keepOpen = notes_app_handleTouch(pressed, lastPressed, x, y);
-    if (!keepOpen) {
-      app = APP_DESKTOP;
-      cursor_reset();
-      desktop_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
-  }
-
-  if (app == APP_TRASH) {
-    bool keepOpen = trash_app_handleTouch(pressed, lastPressed, x, y);
-    if (!keepOpen) {
-      app = APP_DESKTOP;
-      cursor_reset();
-      desktop_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
-  }
-
-  if (app == APP_SETTINGS) {
-    bool keepOpen = settings_app_handleTouch(pressed, lastPressed, x, y);
-    if (!keepOpen) {
-      app = APP_DESKTOP;
-      cursor_reset();
-      desktop_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
-  }
-
-  if (app == APP_DESKTOP) {
-    desktop_set_mouse_mode(mouseActive && millis() < mouseActiveUntil);
-    DesktopAction a = desktop_handleTouch(pressed, lastPressed, x, y);
-
-    if (a == DESKTOP_OPEN_CHAT) {
-      app = APP_CHAT;
-      keyboard_clear();
-      cursor_reset();
-      chat_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    else if (a == DESKTOP_OPEN_PAINT) {
-      app = APP_PAINT;
-      cursor_reset();
-      paint_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    else if (a == DESKTOP_OPEN_WIFI) {
-      app = APP_WIFI;
-      cursor_reset();
-      wifi_app_open();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    else if (a == DESKTOP_OPEN_INTERNET) {
-      app = APP_INTERNET;
-      cursor_reset();
-      internet_app_open();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    else if (a == DESKTOP_OPEN_NOTES) {
-      app = APP_NOTES;
-      cursor_reset();
-      notes_app_open();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
+  // Every queued event reaches the app, in order; passes without input
+  // still give it one call so holds (key repeat, drags) keep going.
+  InputEvent ev;
+  bool any = false;
+  while (input_poll(&ev)) {
+    any = true;
+    if (ev.source == INPUT_SRC_MOUSE) {
+      mouseX = ev.x;
+      mouseY = ev.y;
     }
-    else if (a == DESKTOP_OPEN_TRASH) {
-      app = APP_TRASH;
-      cursor_reset();
-      trash_app_open();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
+    if (ev.type == INPUT_WHEEL) {
+      if (APPS[app].wheel) APPS[app].wheel(ev.wheel);
+      continue;
     }
-    else if (a == DESKTOP_OPEN_SETTINGS) {
-      app = APP_SETTINGS;
-      cursor_reset();
-      settings_app_open();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
+    if (pointerDown && ev.source != pointerSource) continue;
+    if (ev.type == INPUT_DOWN) {
+      pointerDown = true;
+      pointerSource = ev.source;
+    } else if (ev.type == INPUT_UP) {
+      pointerDown = false;
     }
-
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
+    pointerX = ev.x;
+    pointerY = ev.y;
+    input_set_time(ev.ms);
+    dispatch(pointerDown, pointerX, pointerY);
   }
-
-  if (app == APP_CHAT) {
-    if (pressed && !lastPressed && inRect(x, y, 260, 4, 52, 17)) {
-      app = APP_DESKTOP;
-      cursor_reset();
-      desktop_draw();
-      lastPressed = true;
-      mouse_cursor_update();
-      return;
-    }
-    chat_handleTouch(pressed, lastPressed, x, y);
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
+  if (!any) {
+    input_set_time(millis());
+    dispatch(pointerDown, pointerX, pointerY);
   }
 
-  if (app == APP_PAINT) {
-    if (pressed && !lastPressed) {
-      if (x >= 320 - 16 - 6 && x < 320 - 6 && y >= 2 && y < 16) {
-        app = APP_DESKTOP;
-        cursor_reset();
-        desktop_draw();
-        lastPressed = true;
-        mouse_cursor_update();
-        return;
-      }
-    }
-
-    if (pressed) {
-      bool keepOpen = paint_handleTouch(x, y);
-      if (!keepOpen) {
-        app = APP_DESKTOP;
-        cursor_reset();
-        desktop_draw();
-        lastPressed = true;
-        mouse_cursor_update();
-        return;
-      }
-    }
-
-    lastPressed = pressed;
-    mouse_cursor_update();
-    return;
+  // Keys typed on the bridge go to the foreground app's text field; a
+  // paste arrives as one batch.
+  static char keys[512];
+  int keyCount;
+  while ((keyCount = input_poll_keys(keys, sizeof(keys))) > 0) {
+    if (APPS[app].keys) APPS[app].keys(keys, keyCount);
   }
 
-  lastPressed = pressed;
   mouse_cursor_update();
+  mirror_flush();
 }
@@ -1,58 +1,59 @@
 #include "ai_client.h"
+#include "display.h"
+#include "config.h"
+#include "input.h"
+#include "app_arena.h"
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <Preferences.h>
 
 static const char* OLLAMA_URL = "https://<your-worker-name>.<your-username>.workers.dev/api/generate";
 
 static const char* MODEL_NAME = "@cf/meta/llama-3.2-1b-instruct";
 
-static const char* NVS_NS  = "cfg";
-static const char* NVS_KEY = "auth";
-
-static String gToken;
-static bool   gTokenLoaded = false;
-
-static String nvsLoadToken()
-{
-  Preferences prefs;
-  prefs.begin(NVS_NS, true);
-  String tok = prefs.getString(NVS_KEY, "");
-  prefs.end();
-  tok.trim();
-  return tok;
-}
-
-static void nvsSaveToken(const String& tok)
-{
-  Preferences prefs;
-  prefs.begin(NVS_NS, false);
-  prefs.putString(NVS_KEY, tok);
-  prefs.end();
-}
-
-static void nvsClearToken()
-{
-  Preferences prefs;
-  prefs.begin(NVS_NS, false);
-  prefs.remove(NVS_KEY);
-  prefs.end();
-}
-
-static void ensureTokenLoaded()
+// Async worker
+static const int AI_PROMPT_MAX = 256;
+static const int AI_QUEUE_LEN  = 2;
+static const int AI_EVENT_QUEUE_LEN = 16;
+static const uint32_t AI_TASK_STACK = 8192;
+static const uint32_t AI_STREAM_IDLE_MS = 20000;   // give up if no bytes for this long
+
+struct AiRequest { char text[AI_PROMPT_MAX]; };
+
+static QueueHandle_t aiRequests = nullptr;
+static QueueHandle_t aiEvents   = nullptr;
+static TaskHandle_t  aiTask     = nullptr;
+static int           aiInFlight = 0;   // UI side only
+
+// One long-lived TLS connection to the worker, kept open between chat
+// turns (HTTP keep-alive) so follow-ups skip the handshake. Closed after
+// AI_IDLE_CLOSE_MS without use to give the TLS buffers back to the heap.
+static const uint32_t AI_IDLE_CLOSE_MS = 30000;
+
+static WiFiClientSecure  aiTls;
+static HTTPClient        aiHttp;
+static SemaphoreHandle_t aiConnLock = nullptr;
+static uint32_t          aiLastUseMs = 0;
+static char              aiHost[96];
+
+struct AiTiming {
+  uint32_t startMs;
+  uint32_t connectMs;
+  uint32_t ttfbMs;
+  bool     reused;
+};
+
+// The token lives in the config blob (config.h), loaded at boot.
+static bool haveToken()
 {
-  if (gTokenLoaded) return;
-  gToken = nvsLoadToken();
-  gTokenLoaded = true;
+  return config_get_ai_token()[0] != 0;
 }
 
 static void provisionTokenFromSerialBlocking()
 {
 
-  ensureTokenLoaded();
-  if (gToken.length() > 0) {
+  if (haveToken()) {
     Serial.println("AI token loaded from NVS.");
     return;
   }
@@ -71,78 +72,279 @@ static void provisionTokenFromSerialBlocking()
     return;
   }
 
-  nvsSaveToken(tok);
-  gToken = tok;
+  if (tok.length() > CONFIG_TOKEN_MAX) {
+    Serial.println("Token too long (max 128 characters). Not saved.");
+    return;
+  }
+  if (!config_set_ai_token(tok.c_str())) {
+    Serial.println("Could not write token to NVS. Not saved.");
+    return;
+  }
   Serial.println("Saved token to NVS ");
 }
 
-void ai_begin()
+// ------------------------------------------------------------
+// Streaming response reader
+// ------------------------------------------------------------
+// The worker answers with one event per token, either as SSE
+// ("data: {...}" lines, "data: [DONE]" at the end) or NDJSON ({...} lines
+// with "done":true). Cloudflare sends it chunked, and HTTPClient hands
+// out the raw socket, so the chunk framing is stripped here.
+struct StreamReader {
+  WiFiClient* client;
+  bool chunked;
+  long chunkLeft;        // bytes left in the current chunk, -1 = read size line
+  long bodyLeft;         // Content-Length countdown, -1 = unknown
+  bool eof;
+  bool complete;         // body ended cleanly (last chunk / length reached)
+  uint32_t bytes;
+  uint32_t lastDataMs;
+  uint8_t buf[128];
+  int bufLen;
+  int bufPos;
+};
+
+// Starts reading the body of the response aiHttp just received.
+static void readerBegin(StreamReader& r)
 {
+  r.client = aiHttp.getStreamPtr();
+  r.chunked = aiHttp.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+  r.bodyLeft = r.chunked ? -1 : aiHttp.getSize();
+  r.bytes = 0;
+  r.chunkLeft = -1;
+  r.eof = false;
+  r.complete = false;
+  r.lastDataMs = millis();
+  r.bufLen = r.bufPos = 0;
+}
 
-  ensureTokenLoaded();
+static int rawRead(StreamReader& r)
+{
+  while (r.bufPos >= r.bufLen) {
+    int n = r.client->available();
+    if (n > 0) {
+      r.bufLen = r.client->read(r.buf, min(n, (int)sizeof(r.buf)));
+      r.bufPos = 0;
+      if (r.bufLen > 0) {
+        r.lastDataMs = millis();
+        r.bytes += r.bufLen;
+        break;
+      }
+      r.bufLen = 0;
+    }
+    if (!r.client->connected()) return -1;
+    if (millis() - r.lastDataMs > AI_STREAM_IDLE_MS) return -1;
+    delay(5);
+  }
+  return r.buf[r.bufPos++];
+}
 
-  if (gToken.length() == 0) {
+static bool rawReadLine(StreamReader& r, char* out, int outSize)
+{
+  int len = 0;
+  for (;;) {
+    int c = rawRead(r);
+    if (c < 0) { out[len] = 0; return len > 0; }
+    if (c == '\n') break;
+    if (c != '\r' && len < outSize - 1) out[len++] = (char)c;
+  }
+  out[len] = 0;
+  return true;
+}
 
-    provisionTokenFromSerialBlocking();
+static int streamRead(StreamReader& r)
+{
+  if (r.eof) return -1;
+  if (!r.chunked) {
+    if (r.bodyLeft == 0) { r.eof = r.complete = true; return -1; }
+    int c = rawRead(r);
+    if (c < 0) { r.eof = true; r.complete = (r.bodyLeft < 0); return c; }
+    if (r.bodyLeft > 0) r.bodyLeft--;
+    return c;
   }
+
+  if (r.chunkLeft <= 0) {
+    char sizeLine[20];
+    if (r.chunkLeft == 0 && !rawReadLine(r, sizeLine, sizeof(sizeLine))) { r.eof = true; return -1; }  // CRLF after data
+    if (!rawReadLine(r, sizeLine, sizeof(sizeLine))) { r.eof = true; return -1; }
+    r.chunkLeft = strtol(sizeLine, nullptr, 16);
+    if (r.chunkLeft <= 0) {
+      rawReadLine(r, sizeLine, sizeof(sizeLine));   // trailer terminator
+      r.eof = r.complete = true;
+      return -1;
+    }
+  }
+
+  int c = rawRead(r);
+  if (c < 0) { r.eof = true; return -1; }
+  r.chunkLeft--;
+  return c;
 }
 
-void ai_pollSerial()
+// Pulls the top-level "response" string out of each JSON object in the
+// body as it streams in, one byte at a time, whatever the framing between
+// objects ("data: " prefixes, "[DONE]", newlines are all outside any
+// object and skipped). Other keys and values (nested or not) are skipped
+// without being stored, so memory use is the output buffer plus a few
+// bytes of state however long an event line is. The caller takes the
+// text out whenever the buffer is full or an object has ended.
+struct JsonResponseScanner {
+  char* out;
+  size_t outSize;
+  size_t outLen;
+  bool objectEnded;     // a top-level object closed with the last byte
+
+  int depth;
+  bool inString;
+  bool escape;
+  int unicodeLeft;      // hex digits of a \uXXXX still to skip
+  bool stringIsKey;
+  bool capture;         // inside the value of "response"
+  bool expectKey;       // next string at depth 1 is a key
+  bool afterKeyMatch;   // saw "response" and its ':' is next
+  char key[12];
+  int keyLen;
+};
+
+static void scannerBegin(JsonResponseScanner& j, char* out, size_t outSize)
 {
+  memset(&j, 0, sizeof(j));
+  j.out = out;
+  j.outSize = outSize;
+  if (outSize) out[0] = 0;
+}
 
-  if (!Serial.available()) return;
+static bool scannerFull(const JsonResponseScanner& j)
+{
+  return j.outLen + 1 >= j.outSize;
+}
 
-  String line = Serial.readStringUntil('\n');
-  line.trim();
-  if (line.length() == 0) return;
+// Hands the text scanned so far back to the caller and starts over.
+static void scannerTake(JsonResponseScanner& j)
+{
+  j.outLen = 0;
+  j.out[0] = 0;
+}
 
-  if (line == "CLEAR_TOKEN") {
-    nvsClearToken();
-    gToken = "";
-    gTokenLoaded = true;
-    Serial.println("Token cleared from NVS ✅");
-    return;
+// One byte is at most one character out, so a caller that takes the text
+// whenever scannerFull() never loses any.
+static void scannerEmit(JsonResponseScanner& j, char c)
+{
+  if (j.outLen + 1 < j.outSize) {
+    j.out[j.outLen++] = c;
+    j.out[j.outLen] = 0;
   }
+}
 
-  const String prefix = "SET_TOKEN ";
-  if (line.startsWith(prefix)) {
-    String tok = line.substring(prefix.length());
-    tok.trim();
-    if (tok.length() == 0) {
-      Serial.println("SET_TOKEN needs a value.");
+static void scannerFeed(JsonResponseScanner& j, char c)
+{
+  j.objectEnded = false;
+  // Between objects: only the start of the next one matters.
+  if (j.depth == 0 && !j.inString && c != '{') return;
+
+  if (j.inString) {
+    if (j.unicodeLeft > 0) {
+      if (--j.unicodeLeft == 0 && j.capture) scannerEmit(j, '?');
       return;
     }
-    nvsSaveToken(tok);
-    gToken = tok;
-    gTokenLoaded = true;
-    Serial.println("Token saved to NVS ✅");
+    if (j.escape) {
+      j.escape = false;
+      char d = c;
+      if (c == 'n') d = '\n';
+      else if (c == 't') d = ' ';
+      else if (c == 'r' || c == 'b' || c == 'f') d = 0;
+      else if (c == 'u') { j.unicodeLeft = 4; return; }
+      if (j.capture && d) scannerEmit(j, d);
+      else if (j.stringIsKey && d && j.keyLen < (int)sizeof(j.key) - 1) j.key[j.keyLen++] = d;
+      return;
+    }
+    if (c == '\\') { j.escape = true; return; }
+    if (c == '"') {
+      j.inString = false;
+      if (j.capture) {
+        j.capture = false;
+      } else if (j.stringIsKey) {
+        j.key[j.keyLen] = 0;
+        j.afterKeyMatch = (strcmp(j.key, "response") == 0);
+      }
+      return;
+    }
+    if (j.capture) scannerEmit(j, c);
+    else if (j.stringIsKey && j.keyLen < (int)sizeof(j.key) - 1) j.key[j.keyLen++] = c;
     return;
   }
 
-  Serial.println("Unknown command. Use CLEAR_TOKEN or SET_TOKEN <token>");
+  switch (c) {
+    case '{':
+      j.depth++;
+      j.expectKey = (j.depth == 1);
+      j.afterKeyMatch = false;
+      break;
+    case '[':
+      j.depth++;
+      j.afterKeyMatch = false;
+      break;
+    case '}':
+    case ']':
+      j.depth--;
+      j.objectEnded = (j.depth == 0);
+      break;
+    case ',':
+      if (j.depth == 1) j.expectKey = true;
+      j.afterKeyMatch = false;
+      break;
+    case ':':
+      break;
+    case '"':
+      j.inString = true;
+      j.stringIsKey = (j.depth == 1 && j.expectKey);
+      j.keyLen = 0;
+      if (j.stringIsKey) {
+        j.expectKey = false;
+      } else if (j.depth == 1 && j.afterKeyMatch) {
+        j.capture = true;
+      }
+      j.afterKeyMatch = false;
+      break;
+    default:
+      if (c != ' ' && c != '\n' && c != '\r' && c != '\t') j.afterKeyMatch = false;
+      break;
+  }
 }
 
-String ai_sendMessage(const String& userMessage)
+static void postEvent(AiEventType type, const char* text)
 {
-  if (WiFi.status() != WL_CONNECTED) return "WiFi not connected";
-
-  ensureTokenLoaded();
-  if (gToken.length() == 0) {
-    return "No token. Open Serial and run ai_begin() once.";
-  }
-
-  WiFiClientSecure client;
-
-  client.setInsecure();
+  AiEvent ev;
+  ev.type = type;
+  strncpy(ev.text, text ? text : "", AI_EVENT_TEXT_MAX - 1);
+  ev.text[AI_EVENT_TEXT_MAX - 1] = 0;
+  xQueueSend(aiEvents, &ev, portMAX_DELAY);
+}
 
-  HTTPClient http;
-  if (!http.begin(client, OLLAMA_URL)) {
-    return "HTTP begin failed";
+// Error text for a non-200 answer: the status plus the start of the body.
+// The rest of the body is read and dropped, never buffered.
+static String requestError(int code)
+{
+  if (code == 401) return "401 Unauthorized (token?)";
+
+  char head[81];
+  int len = 0;
+  StreamReader r;
+  readerBegin(r);
+  int c;
+  while ((c = streamRead(r)) >= 0) {
+    if (len < (int)sizeof(head) - 1 && c >= ' ') head[len++] = (char)c;
   }
+  head[len] = 0;
+  if (!r.complete) aiTls.stop();
 
-  http.addHeader("Content-Type", "application/json");
-  http.addHeader("X-Auth", gToken);
+  String err = "HTTP " + String(code);
+  if (len > 0) err += " " + String(head);
+  return err;
+}
 
+static String buildPayload(const String& userMessage)
+{
   String prompt =
     "Reply in 1 short sentence. No lists.\n"
     "User: " + userMessage + "\nAssistant:";
@@ -150,31 +352,268 @@ String ai_sendMessage(const String& userMessage)
   StaticJsonDocument<1024> req;
   req["model"] = MODEL_NAME;
   req["prompt"] = prompt;
-  req["stream"] = false;
+  req["stream"] = true;
 
   String payload;
   serializeJson(req, payload);
+  return payload;
+}
+
+static const char* workerHost()
+{
+  if (aiHost[0]) return aiHost;
+  const char* p = strstr(OLLAMA_URL, "://");
+  p = p ? p + 3 : OLLAMA_URL;
+  int n = 0;
+  while (p[n] && p[n] != '/' && p[n] != ':' && n < (int)sizeof(aiHost) - 1) n++;
+  memcpy(aiHost, p, n);
+  aiHost[n] = 0;
+  return aiHost;
+}
+
+static bool lockConnection()
+{
+  if (!aiConnLock) aiConnLock = xSemaphoreCreateMutex();
+  return aiConnLock && xSemaphoreTake(aiConnLock, portMAX_DELAY) == pdTRUE;
+}
+
+static void unlockConnection()
+{
+  xSemaphoreGive(aiConnLock);
+}
+
+// Sends the request on the kept-alive connection, opening it first if
+// needed. A reused socket the server has meanwhile dropped gets one fresh
+// retry. Returns the HTTP status (negative for transport errors).
+static int postOnConnection(const String& payload, AiTiming& t)
+{
+  t.startMs = millis();
+  t.reused = aiTls.connected();
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (!aiTls.connected()) {
+      t.reused = false;
+      aiTls.setInsecure();
+      if (!aiTls.connect(workerHost(), 443)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    t.connectMs = millis() - t.startMs;
+
+    aiHttp.setReuse(true);
+    if (!aiHttp.begin(aiTls, OLLAMA_URL)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    aiHttp.addHeader("Content-Type", "application/json");
+    aiHttp.addHeader("X-Auth", config_get_ai_token());
+    const char* keys[] = { "Transfer-Encoding" };
+    aiHttp.collectHeaders(keys, 1);
+
+    int code = aiHttp.POST(payload);
+    t.ttfbMs = millis() - t.startMs - t.connectMs;
+    if (code > 0 || !t.reused) return code;
+
+    aiTls.stop();
+  }
+  return HTTPC_ERROR_CONNECTION_LOST;
+}
 
-  int code = http.POST(payload);
+// Returns the connection to the idle pool and logs where the time went.
+static void finishOnConnection(const AiTiming& t, uint32_t bytes)
+{
+  uint32_t total = millis() - t.startMs;
+  aiHttp.end();
+  aiLastUseMs = millis();
+
+  Serial.printf("AI: %s %lu ms, TTFB %lu ms, transfer %lu ms, %lu bytes\n",
+                t.reused ? "reused" : "connect", (unsigned long)t.connectMs,
+                (unsigned long)t.ttfbMs, (unsigned long)(total - t.connectMs - t.ttfbMs),
+                (unsigned long)bytes);
+}
+
+static void closeIfIdle()
+{
+  if (!aiTls.connected()) return;
+  if (millis() - aiLastUseMs < AI_IDLE_CLOSE_MS) return;
+  if (!lockConnection()) return;
+  aiTls.stop();
+  unlockConnection();
+  Serial.println("AI: idle, connection closed");
+}
+
+// Runs one streamed request on the worker, posting AI_EVENT_TEXT per token
+// and a final AI_EVENT_DONE or AI_EVENT_ERROR.
+static void streamRequest(const char* userMessage)
+{
+  if (WiFi.status() != WL_CONNECTED) { postEvent(AI_EVENT_ERROR, "WiFi not connected"); return; }
+
+  if (!haveToken()) {
+    postEvent(AI_EVENT_ERROR, "No token. Open Serial and run ai_begin() once.");
+    return;
+  }
+
+  if (!lockConnection()) { postEvent(AI_EVENT_ERROR, "Busy"); return; }
+
+  AiTiming timing;
+  int code = postOnConnection(buildPayload(String(userMessage)), timing);
   if (code != 200) {
-    String err = "HTTP " + String(code);
-    String body = http.getString();
-    http.end();
+    String err = code > 0 ? requestError(code) : "Connect failed";
+    aiHttp.end();
+    if (code <= 0) aiTls.stop();
+    unlockConnection();
+    postEvent(AI_EVENT_ERROR, err.c_str());
+    return;
+  }
 
-    if (code == 401) return "401 Unauthorized (token?)";
-    if (body.length() > 0) return err + " " + body;
-    return err;
+  // Each event's text goes out as it completes, and a token longer than
+  // one AiEvent is split over several, so nothing is cut.
+  StreamReader r;
+  readerBegin(r);
+  char token[AI_EVENT_TEXT_MAX];
+  JsonResponseScanner j;
+  scannerBegin(j, token, sizeof(token));
+  bool any = false;
+
+  int c;
+  while ((c = streamRead(r)) >= 0) {
+    scannerFeed(j, (char)c);
+    if (!j.objectEnded && !scannerFull(j)) continue;
+    // Drop leading whitespace of the first token.
+    const char* t = token;
+    if (!any) while (*t == ' ' || *t == '\n') t++;
+    if (*t) {
+      postEvent(AI_EVENT_TEXT, t);
+      any = true;
+    }
+    scannerTake(j);
   }
+  // The body is read to its end either way ("[DONE]" or "done": true come
+  // last), so the connection can carry the next request.
+  if (!r.complete) aiTls.stop();
 
-  String body = http.getString();
-  http.end();
+  finishOnConnection(timing, r.bytes);
+  unlockConnection();
 
-  StaticJsonDocument<4096> resp;
-  if (deserializeJson(resp, body)) return "JSON error";
+  if (!any) postEvent(AI_EVENT_ERROR, r.eof ? "Empty reply" : "Connection lost");
+  else postEvent(AI_EVENT_DONE, nullptr);
+}
 
-  String out = resp["response"].as<String>();
-  out.trim();
+static void aiWorker(void*)
+{
+  AiRequest req;
 
-  if (out.length() > 120) out = out.substring(0, 120) + "...";
-  return out;
+  for (;;) {
+    if (xQueueReceive(aiRequests, &req, pdMS_TO_TICKS(1000)) != pdTRUE) {
+      closeIfIdle();
+      continue;
+    }
+    streamRequest(req.text);
+  }
+}
+
+static bool ensureWorker()
+{
+  if (aiTask) return true;
+
+  aiRequests = xQueueCreate(AI_QUEUE_LEN, sizeof(AiRequest));
+  aiEvents   = xQueueCreate(AI_EVENT_QUEUE_LEN, sizeof(AiEvent));
+  if (!aiRequests || !aiEvents) return false;
+
+  // loop() runs on core 1; the TLS work goes to core 0.
+  if (xTaskCreatePinnedToCore(aiWorker, "ai", AI_TASK_STACK, nullptr, 1, &aiTask, 0) != pdPASS) {
+    aiTask = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void ai_begin()
+{
+
+  ensureWorker();
+
+  if (!haveToken()) {
+
+    provisionTokenFromSerialBlocking();
+  }
+}
+
+void ai_pollSerial()
+{
+
+  if (!Serial.available()) return;
+
+  String line = Serial.readStringUntil('\n');
+  line.trim();
+  if (line.length() == 0) return;
+
+  if (line == "CLEAR_TOKEN") {
+    if (!config_set_ai_token("")) {
+      Serial.println("Could not write NVS. Token not cleared.");
+      return;
+    }
+    Serial.println("Token cleared from NVS ✅");
+    return;
+  }
+
+  if (line == "STATS") {
+    display_stats_print(Serial);
+    uint32_t lost, stale;
+    input_mouse_stats(&lost, &stale);
+    Serial.printf("input: %u dropped, mouse packets %u lost, %u stale\n",
+                  (unsigned)input_dropped(), (unsigned)lost, (unsigned)stale);
+    Serial.printf("app arena: %u of %u bytes in use, peak %u\n", (unsigned)app_arena_used(),
+                  (unsigned)APP_ARENA_BYTES, (unsigned)app_arena_peak());
+    return;
+  }
+
+  if (line == "STATS RESET") {
+    display_stats_reset();
+    Serial.println("Display stats reset.");
+    return;
+  }
+
+  const String prefix = "SET_TOKEN ";
+  if (line.startsWith(prefix)) {
+    String tok = line.substring(prefix.length());
+    tok.trim();
+    if (tok.length() == 0) {
+      Serial.println("SET_TOKEN needs a value.");
+      return;
+    }
+    if (tok.length() > CONFIG_TOKEN_MAX) {
+      Serial.println("Token too long (max 128 characters).");
+      return;
+    }
+    if (!config_set_ai_token(tok.c_str())) {
+      Serial.println("Could not write token to NVS.");
+      return;
+    }
+    Serial.println("Token saved to NVS ✅");
+    return;
+  }
+
+  Serial.println("Unknown command. Use CLEAR_TOKEN, SET_TOKEN <token>, STATS or STATS RESET");
+}
+
+bool ai_requestAsync(const String& userMessage)
+{
+  if (!ensureWorker()) return false;
+
+  AiRequest req;
+  strncpy(req.text, userMessage.c_str(), AI_PROMPT_MAX - 1);
+  req.text[AI_PROMPT_MAX - 1] = 0;
+
+  if (xQueueSend(aiRequests, &req, 0) != pdTRUE) return false;
+  aiInFlight++;
+  return true;
+}
+
+bool ai_pollEvent(AiEvent& ev)
+{
+  if (!aiEvents) return false;
+  if (xQueueReceive(aiEvents, &ev, 0) != pdTRUE) return false;
+  if (ev.type != AI_EVENT_TEXT && aiInFlight > 0) aiInFlight--;
+  return true;
+}
+
+bool ai_isBusy()
+{
+  return aiInFlight > 0;
 }
@@ -3,4 +3,24 @@
 
 void ai_begin();
 void ai_pollSerial();
-String ai_sendMessage(const String& userMessage);
+// Requests. ai_requestAsync() hands the prompt to a worker task on the
+// other core and returns at once (false if the queue is full).
+// The answer is streamed back: ai_pollEvent() yields one AI_EVENT_TEXT per
+// token, then AI_EVENT_DONE, or AI_EVENT_ERROR with a message instead.
+// Call it from the UI tick; requests complete in the order they were made.
+enum AiEventType : uint8_t {
+  AI_EVENT_TEXT,
+  AI_EVENT_DONE,
+  AI_EVENT_ERROR
+};
+
+static const int AI_EVENT_TEXT_MAX = 64;
+
+struct AiEvent {
+  AiEventType type;
+  char text[AI_EVENT_TEXT_MAX];
+};
+
+bool ai_requestAsync(const String& userMessage);
+bool ai_pollEvent(AiEvent& ev);
+bool ai_isBusy();
@@ -0,0 +1,19 @@
+#include "app_arena.h"
+
+static uint32_t arena[APP_ARENA_BYTES / sizeof(uint32_t)];
+static size_t used = 0;
+static size_t peak = 0;
+
+void* app_arena_alloc(size_t bytes) {
+  size_t n = (bytes + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+  if (n > sizeof(arena) - used) return nullptr;
+  void* p = (uint8_t*)arena + used;
+  used += n;
+  if (used > peak) peak = used;
+  return p;
+}
+
+void app_arena_reset() { used = 0; }
+
+size_t app_arena_used() { return used; }
+size_t app_arena_peak() { return peak; }
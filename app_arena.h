@@ -0,0 +1,29 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Scratch memory for the app in front.
+//
+// Only one app is open at a time, so the large buffers that are only
+// needed while an app is open (Paint's fill stacks and selection, the
+// note's text and the notes and article line tables) all come from this
+// one block instead of each being resident or malloc'd. The app takes what it needs in its
+// open call; the sketch resets the arena whenever the foreground app
+// changes, so every pointer into it is dead once the app has closed.
+//
+// The block is static, so allocation cannot fail for lack of heap: an
+// app checks its total against APP_ARENA_BYTES at compile time.
+
+// Sized exactly for the largest user, Paint: two fill stacks and a
+// selection of the whole canvas.
+#define APP_ARENA_BYTES 56700
+
+// bytes from the arena, 4-byte aligned; nullptr if it does not fit.
+void* app_arena_alloc(size_t bytes);
+
+// Releases everything allocated since the last reset.
+void app_arena_reset();
+
+// Bytes allocated now and the most ever allocated at once.
+size_t app_arena_used();
+size_t app_arena_peak();
@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+# Wire format shared by the mouse bridges (see pollMouse() in input.cpp
+# and mirror.cpp).
+#
+# Every pointer packet carries the full button state and the running
+# wheel total, so a lost packet only loses the points in it; the sender
+# repeats its state every KEEPALIVE_S even when nothing moves, which also
+# repairs a lost button release.
+#
+# A bridge can also ask for the screen: the device then sends the
+# rectangles it redraws back to the socket the request came from.
+#
+# Typing cannot be repaired by the next packet, so key packets are
+# acknowledged: one is in flight at a time and is resent until the device
+# answers; keys typed meanwhile (a paste, fast typing) go out together
+# in the next one.
+
+import random
+import socket
+import struct
+import time
+
+ESP32_PORT = 4210
+
+VERSION = 2
+PKT_ABS = 1
+PKT_REL = 2
+PKT_MIRROR = 3
+PKT_KEYS = 4
+PKT_KEYS_ACK = 5
+MIRROR_PKT_UPDATE = 16
+
+REC_FILL = 1
+REC_RLE = 2
+
+BUTTON_LEFT = 1
+BUTTON_RIGHT = 2
+BUTTON_MIDDLE = 4
+
+MAX_POINTS = 32
+KEEPALIVE_S = 0.25
+# Keys per packet (the device's KEYS_MAX) and how long to wait for an
+# acknowledgement before sending again.
+KEYS_MAX = 512
+KEYS_RESEND_S = 0.1
+KEY_BACKSPACE = "\b"
+KEY_ENTER = "\n"
+# The device stops mirroring 2 s after the last request.
+MIRROR_RENEW_S = 0.5
+
+SCREEN_W, SCREEN_H = 320, 240
+
+_HEADER = struct.Struct("<BBHBBB")
+_POINT = struct.Struct("<hh")
+_UPDATE = struct.Struct("<BBH")
+_KEYS = struct.Struct("<BBH")
+_RECORD = struct.Struct("<BhhHH")
+_COLOR = struct.Struct("<H")
+
+
+class PointerSender:
+    """Batches pointer samples and sends them as sequenced packets."""
+
+    def __init__(self, ip, port=ESP32_PORT, relative=False):
+        self.addr = (ip, port)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        # Screen updates are read from the same socket between frames.
+        self.sock.setblocking(False)
+        self.kind = PKT_REL if relative else PKT_ABS
+        # A random start keeps a restarted bridge from looking like a
+        # stream of late packets.
+        self.seq = random.randrange(0x10000)
+        self.buttons = 0
+        self.wheel_total = 0
+        self.points = []
+        self.last = (0, 0)
+        self.dirty = False
+        self.sent_at = 0.0
+
+    def move(self, x, y):
+        """Adds a position (absolute mode) or a delta (relative mode)."""
+        self.points.append((int(x), int(y)))
+        if self.kind == PKT_ABS:
+            self.last = (int(x), int(y))
+        if len(self.points) >= MAX_POINTS:
+            self.flush()
+
+    def set_buttons(self, buttons):
+        """Button changes go out at once, after the moves that led to them."""
+        if buttons == self.buttons:
+            return
+        if self.points:
+            self.flush()
+        self.buttons = buttons
+        self.dirty = True
+        self.flush()
+
+    def wheel(self, steps):
+        self.wheel_total = (self.wheel_total + int(steps)) & 0xFF
+        self.dirty = True
+
+    def pump(self):
+        """Call at the send rate: sends what is pending, or a keepalive."""
+        if self.points or self.dirty or time.monotonic() - self.sent_at >= KEEPALIVE_S:
+            self.flush()
+
+    def flush(self):
+        points = self.points
+        if not points and self.kind == PKT_ABS:
+            points = [self.last]
+        pkt = _HEADER.pack(VERSION, self.kind, self.seq, self.buttons,
+                           self.wheel_total, len(points))
+        pkt += b"".join(_POINT.pack(x, y) for x, y in points)
+        self.sock.sendto(pkt, self.addr)
+        self.seq = (self.seq + 1) & 0xFFFF
+        self.points = []
+        self.dirty = False
+        self.sent_at = time.monotonic()
+
+    def request_mirror(self, full=False):
+        """Asks for (another MIRROR_RENEW_S of) screen updates."""
+        self.sock.sendto(bytes([VERSION, PKT_MIRROR, 1 if full else 0]), self.addr)
+
+    def receive(self):
+        """Datagrams the device sent back, without waiting."""
+        while True:
+            try:
+                data, _ = self.sock.recvfrom(2048)
+            except (BlockingIOError, OSError):
+                return
+            yield data
+
+
+class KeySender:
+    """Sends typed keys reliably over a PointerSender's socket."""
+
+    def __init__(self, pointer):
+        self.sock = pointer.sock
+        self.addr = pointer.addr
+        self.seq = random.randrange(0x10000)
+        self.pending = ""
+        self.in_flight = None
+        self.sent_at = 0.0
+
+    def type(self, text):
+        """Queues text: printable ASCII, newlines as Enter, tabs as a space."""
+        for ch in text.replace("\r\n", "\n").replace("\r", "\n").replace("\t", " "):
+            if ch == KEY_ENTER or " " <= ch <= "~":
+                self.pending += ch
+
+    def backspace(self):
+        self.pending += KEY_BACKSPACE
+
+    def enter(self):
+        self.pending += KEY_ENTER
+
+    def pump(self):
+        """Call at the send rate: resends the packet in flight when its
+        acknowledgement is late, or sends the keys queued since."""
+        now = time.monotonic()
+        if self.in_flight is not None:
+            if now - self.sent_at >= KEYS_RESEND_S:
+                self.sock.sendto(self.in_flight, self.addr)
+                self.sent_at = now
+            return
+        if not self.pending:
+            return
+        keys, self.pending = self.pending[:KEYS_MAX], self.pending[KEYS_MAX:]
+        self.in_flight = _KEYS.pack(VERSION, PKT_KEYS, self.seq) + keys.encode("ascii")
+        self.sock.sendto(self.in_flight, self.addr)
+        self.sent_at = now
+
+    def handle(self, pkt):
+        """Takes an acknowledgement from the datagrams the device sent.
+        Returns False for anything else."""
+        if len(pkt) < _KEYS.size:
+            return False
+        version, kind, seq = _KEYS.unpack_from(pkt)
+        if version != VERSION or kind != PKT_KEYS_ACK:
+            return False
+        if self.in_flight is not None and seq == self.seq:
+            self.in_flight = None
+            self.seq = (self.seq + 1) & 0xFFFF
+            self.pump()
+        return True
+
+
+def _rgb(c):
+    r = (c >> 11) & 0x1F
+    g = (c >> 5) & 0x3F
+    b = c & 0x1F
+    return bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)))
+
+
+_RGB = [_rgb(c) for c in range(0x10000)]
+
+
+class MirrorFrame:
+    """The device screen rebuilt from update packets, as RGB888 rows."""
+
+    def __init__(self, width=SCREEN_W, height=SCREEN_H):
+        self.width = width
+        self.height = height
+        self.rgb = bytearray(width * height * 3)
+        self.seq = None
+        self.lost = 0
+        # Rectangles updated since the last call to take_updates().
+        self.updates = []
+
+    def apply(self, pkt):
+        """Applies one packet. Returns False when packets went missing
+        before it, so the caller should ask for a full frame."""
+        if len(pkt) < _UPDATE.size:
+            return True
+        version, kind, seq = _UPDATE.unpack_from(pkt)
+        if version != VERSION or kind != MIRROR_PKT_UPDATE:
+            return True
+        in_order = self.seq is None or seq == (self.seq + 1) & 0xFFFF
+        if not in_order:
+            self.lost += 1
+        self.seq = seq
+
+        pos = _UPDATE.size
+        while pos + _RECORD.size <= len(pkt):
+            rec, x, y, w, h = _RECORD.unpack_from(pkt, pos)
+            pos += _RECORD.size
+            if rec == REC_FILL:
+                (c,) = _COLOR.unpack_from(pkt, pos)
+                pos += 2
+                self._fill(x, y, w, h, _RGB[c] * w)
+            elif rec == REC_RLE:
+                pixels, pos = self._decode(pkt, pos, w * h)
+                self._blit(x, y, w, h, pixels)
+            else:
+                break
+            self.updates.append((x, y, w, h))
+        return in_order
+
+    def take_updates(self):
+        updates, self.updates = self.updates, []
+        return updates
+
+    def _decode(self, pkt, pos, count):
+        out = []
+        n = 0
+        while n < count and pos < len(pkt):
+            ctl = pkt[pos]
+            pos += 1
+            if ctl < 128:
+                k = ctl + 1
+                for i in range(k):
+                    out.append(_RGB[_COLOR.unpack_from(pkt, pos + 2 * i)[0]])
+                pos += 2 * k
+            else:
+                k = ctl - 126
+                out.append(_RGB[_COLOR.unpack_from(pkt, pos)[0]] * k)
+                pos += 2
+            n += k
+        return b"".join(out), pos
+
+    def _fill(self, x, y, w, h, row):
+        for yy in range(y, y + h):
+            off = (yy * self.width + x) * 3
+            self.rgb[off:off + len(row)] = row
+
+    def _blit(self, x, y, w, h, pixels):
+        stride = w * 3
+        for r in range(h):
+            off = ((y + r) * self.width + x) * 3
+            self.rgb[off:off + stride] = pixels[r * stride:(r + 1) * stride]
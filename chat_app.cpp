@@ -2,25 +2,60 @@
 #include "keyboard.h"
 #include "ai_client.h"
 #include "system_ui.h"
+#include "text_layout.h"
+#include "text_metrics.h"
+#include "gesture.h"
+#include "kinetic_scroll.h"
+#include "input.h"
 #include <Arduino.h>
 #include <cstring>
 #include <cstdio>
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 
 #define SCREEN_W 320
 #define SCREEN_H 240
 
-#define MAX_MSG 8
-#define MAX_LEN 420
+// History arena: messages are stored back to back in one byte ring as
+// "user\0ai\0". Records keep offsets and lengths, oldest first. Appending
+// evicts the oldest messages whose bytes are about to be overwritten, so
+// the number of turns kept depends on their length, not a slot count.
+// Only the newest message (the reply being streamed) ever grows.
+#define HISTORY_BYTES 4096
+#define MAX_MSG 48
+#define MAX_USER_LEN 255
+#define MAX_AI_LEN 419
+#define MAX_LEN (MAX_AI_LEN + 1)
+
+struct ChatMsg {
+  uint16_t off;
+  uint16_t userLen;
+  uint16_t aiLen;
+  uint16_t lineOff;     // first entry in lineStarts (user lines, then AI lines)
+  uint8_t userLines;
+  uint8_t aiLines;
+  bool expanded;
+};
+
+// Line-break tables: each message owns userLines + aiLines consecutive
+// line starts in a ring that runs in the same order as the records, so
+// they are filled once when the text changes and scrolling only indexes
+// them. Offsets count into the displayed text ("You: " / "AI:  " +
+// message); a line ends where the next one of the same part starts.
+#define LINE_POOL 512
+#define MAX_LINES 80
+#define LINE_CHARS 160
 
-static char chatUser[MAX_MSG][MAX_LEN];
-static char chatAI[MAX_MSG][MAX_LEN];
+static char history[HISTORY_BYTES];
+static uint16_t lineStarts[LINE_POOL];
+static ChatMsg msgs[MAX_MSG];
+static int msgFirst = 0;              // ring index of the oldest record
 static int chatCount = 0;
-static uint8_t chatUserLines[MAX_MSG];
-static uint8_t chatAILines[MAX_MSG];
 static int cachedWrapW = -1;
-static bool chatAIExpanded[MAX_MSG];
+static bool replyPending = false;     // newest message waits on the AI worker
+static bool replyStarted = false;     // first token has replaced "thinking..."
+
+static const char* AI_THINKING = "thinking...";
 
 // Full width chat
 static const int RIGHT_PANEL_X = 320;
@@ -32,6 +67,7 @@ static const int INPUT_H = 28;
 
 static int chatCursorY = 38;
 static bool kbVisible = true;
+static bool opened = false;
 static const int UI_GAP = 6;
 
 static int scrollLine = 0;
@@ -48,13 +84,16 @@ static const int AI_COLLAPSED_LINES = 3;
 static const int AI_TOGGLE_W = 14;
 static const int AI_TOGGLE_H = 14;
 
-// Forward declarations for wrapping helpers
-static void wrapLines(const char* s, int maxW);
-static int wrapAndCountLines(const char* s, int maxW);
+static const char* USER_PREFIX = "You: ";
+static const char* AI_PREFIX = "AI:  ";
+static const int PREFIX_LEN = 5;
+
 
-static bool draggingChat = false;
-static int dragStartY = 0;
-static int dragAccum = 0;
+// History drags and flings. While `scrolling` the kinetic scroller owns
+// the history view; when it comes to rest it snaps to a whole line.
+static GestureTracker gesture;
+static KineticScroll kinetic;
+static bool scrolling = false;
 static uint32_t lastStatusTick = 0;
 
 static inline bool inRect(int x,int y,int rx,int ry,int rw,int rh){
@@ -65,37 +104,178 @@ static bool inChatArea(int x, int y) {
   return (x < RIGHT_PANEL_X) && (y >= CHAT_TOP) && (y <= CHAT_BOTTOM);
 }
 
-static void pushMessage(const char* user, const char* ai) {
-  if (chatCount >= MAX_MSG) {
-    for (int i = 1; i < MAX_MSG; i++) {
-      strncpy(chatUser[i-1], chatUser[i], MAX_LEN);
-      strncpy(chatAI[i-1],   chatAI[i],   MAX_LEN);
-      chatUserLines[i-1] = chatUserLines[i];
-      chatAILines[i-1] = chatAILines[i];
-    }
-    chatCount = MAX_MSG - 1;
+static inline ChatMsg& msgAt(int i) { return msgs[(msgFirst + i) % MAX_MSG]; }
+static inline int msgBytes(const ChatMsg& m) { return m.userLen + 1 + m.aiLen + 1; }
+static inline const char* msgUser(int i) { return history + msgAt(i).off; }
+
+static const char* msgAI(int i) {
+  const ChatMsg& m = msgAt(i);
+  if (i == chatCount - 1 && replyPending && !replyStarted) return AI_THINKING;
+  return history + m.off + m.userLen + 1;
+}
+
+static void dropOldest() {
+  msgFirst = (msgFirst + 1) % MAX_MSG;
+  chatCount--;
+}
+
+// Drops the oldest messages until [off, off + len) is free. With `wrapped`
+// the write restarts at the front of the arena, so records still sitting
+// in the skipped tail (at or after `tail`) go too. The newest `keep`
+// messages are never dropped.
+static void evictForWrite(int off, int len, bool wrapped, int tail, int keep) {
+  while (chatCount > keep) {
+    const ChatMsg& m = msgAt(0);
+    bool overlaps = m.off < off + len && off < m.off + msgBytes(m);
+    if (!overlaps && !(wrapped && m.off >= tail)) break;
+    dropOldest();
   }
+}
 
-  strncpy(chatUser[chatCount], user, MAX_LEN - 1);
-  chatUser[chatCount][MAX_LEN - 1] = 0;
+static int linesBefore(int i) {
+  int n = 0;
+  for (int k = 0; k < i; k++) n += msgAt(k).userLines + msgAt(k).aiLines;
+  return n;
+}
 
-  strncpy(chatAI[chatCount], ai, MAX_LEN - 1);
-  chatAI[chatCount][MAX_LEN - 1] = 0;
+// out[0..n) already holds the first line starts of s; adds the rest and
+// returns the line count, at most cap.
+static int wrapPart(const char* s, int len, uint16_t* out, int n, int cap) {
+  int start = out[n - 1];
+  while (n < cap) {
+    start = text_layout_next(s, len, start, cachedWrapW, 2);
+    if (start < 0) break;
+    out[n++] = (uint16_t)start;
+  }
+  return n;
+}
 
-  if (cachedWrapW > 0) {
-    char u[MAX_LEN + 8];
-    char a[MAX_LEN + 8];
-    snprintf(u, sizeof(u), "You: %s", chatUser[chatCount]);
-    snprintf(a, sizeof(a), "AI:  %s", chatAI[chatCount]);
-    chatUserLines[chatCount] = (uint8_t)wrapAndCountLines(u, cachedWrapW);
-    chatAILines[chatCount] = (uint8_t)wrapAndCountLines(a, cachedWrapW);
+// Wraps message i and stores its line table right after the previous
+// message's. With `grown` the AI text was only appended to, so lines
+// before its last one cannot change and wrapping resumes there. Older
+// messages are dropped if the pool would overflow; the message's new
+// index is returned.
+static int layoutMessage(int i, bool grown = false) {
+  static uint16_t tmp[2 * MAX_LINES];
+  char text[MAX_LEN + 8];
+  const ChatMsg& m = msgAt(i);
+
+  int keep = 0;   // leading lines of the message that stay as they are
+  int nu, n;
+  if (grown) {
+    nu = m.userLines;
+    keep = nu + m.aiLines - 1;
+    tmp[0] = lineStarts[(m.lineOff + keep) % LINE_POOL];
+    int len = snprintf(text, sizeof(text), "%s%s", AI_PREFIX, msgAI(i));
+    n = wrapPart(text, len, tmp, 1, MAX_LINES - (m.aiLines - 1));
   } else {
-    chatUserLines[chatCount] = 1;
-    chatAILines[chatCount] = 1;
+    int len = snprintf(text, sizeof(text), "%s%s", USER_PREFIX, msgUser(i));
+    tmp[0] = 0;
+    nu = wrapPart(text, len, tmp, 1, MAX_LINES);
+    len = snprintf(text, sizeof(text), "%s%s", AI_PREFIX, msgAI(i));
+    tmp[nu] = 0;
+    n = nu + wrapPart(text, len, tmp + nu, 1, MAX_LINES);
   }
-  chatAIExpanded[chatCount] = false;
 
+  while (i > 0 && linesBefore(i) + keep + n > LINE_POOL) {
+    dropOldest();
+    i--;
+  }
+
+  ChatMsg& mm = msgAt(i);
+  if (i > 0 && !grown) {
+    const ChatMsg& prev = msgAt(i - 1);
+    mm.lineOff = (prev.lineOff + prev.userLines + prev.aiLines) % LINE_POOL;
+  }
+  for (int k = 0; k < n; k++) lineStarts[(mm.lineOff + keep + k) % LINE_POOL] = tmp[k];
+  mm.userLines = (uint8_t)nu;
+  mm.aiLines = (uint8_t)(keep + n - nu);
+  return i;
+}
+
+static void pushMessage(const char* user, const char* ai, bool pending = false) {
+  int ul = min((int)strlen(user), MAX_USER_LEN);
+  int al = min((int)strlen(ai), MAX_AI_LEN);
+  int need = ul + 1 + al + 1;
+
+  if (chatCount == MAX_MSG) dropOldest();
+
+  int head = 0;
+  if (chatCount > 0) {
+    const ChatMsg& last = msgAt(chatCount - 1);
+    head = last.off + msgBytes(last);
+  }
+  bool wrapped = head + need > HISTORY_BYTES;
+  int off = wrapped ? 0 : head;
+  evictForWrite(off, need, wrapped, head, 0);
+  if (chatCount == 0) msgFirst = 0;
+
+  memcpy(history + off, user, ul);
+  history[off + ul] = 0;
+  memcpy(history + off + ul + 1, ai, al);
+  history[off + ul + 1 + al] = 0;
+
+  ChatMsg& m = msgs[(msgFirst + chatCount) % MAX_MSG];
+  m.off = (uint16_t)off;
+  m.userLen = (uint16_t)ul;
+  m.aiLen = (uint16_t)al;
+  m.expanded = false;
+  m.userLines = 0;
+  m.aiLines = 0;
+  m.lineOff = 0;
   chatCount++;
+
+  replyPending = pending;
+  replyStarted = false;
+  if (cachedWrapW > 0) layoutMessage(chatCount - 1);
+}
+
+// Appends to the AI text of the newest message, moving the record to the
+// front of the arena if it would run past the end.
+static void appendToNewest(const char* text) {
+  ChatMsg& m = msgAt(chatCount - 1);
+  int n = min((int)strlen(text), MAX_AI_LEN - m.aiLen);
+  if (n <= 0) return;
+
+  int bytes = msgBytes(m);
+  if (m.off + bytes + n > HISTORY_BYTES) {
+    evictForWrite(0, bytes + n, true, m.off + bytes, 1);
+    memmove(history, history + m.off, bytes);
+    m.off = 0;
+  } else {
+    evictForWrite(m.off + bytes, n, false, 0, 1);
+  }
+
+  char* ai = history + m.off + m.userLen + 1;
+  memcpy(ai + m.aiLen, text, n);
+  m.aiLen += n;
+  ai[m.aiLen] = 0;
+}
+
+// Applies one worker event to the newest message, which is the only one
+// that can be waiting. Returns its index, or -1 if nothing changed.
+static int applyAIEvent(const AiEvent& ev) {
+  if (!replyPending || chatCount == 0) return -1;
+  int i = chatCount - 1;
+
+  bool grown = false;
+  if (ev.type == AI_EVENT_TEXT) {
+    grown = replyStarted;
+    replyStarted = true;
+    appendToNewest(ev.text);
+  } else {
+    if (ev.type == AI_EVENT_ERROR) {
+      msgAt(i).aiLen = 0;
+      history[msgAt(i).off + msgAt(i).userLen + 1] = 0;
+      appendToNewest(ev.text);
+    }
+    replyPending = false;
+  }
+
+  // Only the AI text that grew is wrapped again.
+  i = chatCount - 1;
+  if (cachedWrapW > 0) i = layoutMessage(i, grown);
+  return i;
 }
 
 static void applyLayout() {
@@ -130,15 +310,20 @@ static void clearChatArea() {
   chatCursorY = CHAT_TOP + 6;
 }
 
+static void drawSendButton() {
+  uint16_t bg = replyPending ? TFT_DARKGREY : TFT_GREEN;
+  tft->fillRoundRect(250, INPUT_Y, 66, INPUT_H, 6, bg);
+  tft->setTextColor(TFT_WHITE, bg);
+  tft->drawCentreString(replyPending ? "WAIT" : "SEND", 283, INPUT_Y + 6, 2);
+}
+
 static void drawInputBar() {
   tft->drawRect(4, INPUT_Y, 240, INPUT_H, TFT_BLACK);
 
   tft->setTextColor(TFT_BLACK, TFT_WHITE);
   tft->drawString(">", 8, INPUT_Y + 6, 2);
 
-  tft->fillRoundRect(250, INPUT_Y, 66, INPUT_H, 6, TFT_GREEN);
-  tft->setTextColor(TFT_WHITE, TFT_GREEN);
-  tft->drawCentreString("SEND", 283, INPUT_Y + 6, 2);
+  drawSendButton();
 
   // Clear toggle area to avoid ghosting
   tft->fillRect(250, INPUT_Y - TOGGLE_H - TOGGLE_GAP, 66, TOGGLE_H, TFT_WHITE);
@@ -147,16 +332,13 @@ static void drawInputBar() {
   tft->drawCentreString(kbVisible ? "HIDE" : "SHOW", 283, INPUT_Y - TOGGLE_H - TOGGLE_GAP + 4, 2);
 }
 
-static void drawInputTextClipped(const String& s) {
+// Shows the tail of the input that fits, so the cursor end stays visible.
+static void drawInputTextClipped(const char* s) {
   int maxW = 210;
-  String out = s;
-
-  while (out.length() > 0 && tft->textWidth(out, 2) > maxW) {
-    out.remove(0, 1);
-  }
+  int len = strlen(s);
 
   tft->setTextColor(TFT_BLACK, TFT_WHITE);
-  tft->drawString(out, 22, INPUT_Y + 6, 2);
+  tft->drawString(s + text_fit_tail(s, len, 2, maxW), 22, INPUT_Y + 6, 2);
 }
 
 static void updateInputText() {
@@ -167,169 +349,67 @@ static void updateInputText() {
 // ============================================================
 // Word wrapping (clean word boundaries)
 // ============================================================
-#define MAX_LINES 80
-#define LINE_MAX_CHARS 56
-static char wrapBuffer[MAX_LINES][LINE_MAX_CHARS];
-static int wrapCount = 0;
-
-static void wrapLines(const char* s, int maxW) {
-  wrapCount = 0;
-  char line[LINE_MAX_CHARS] = {0};
-  char word[LINE_MAX_CHARS] = {0};
-  int lineLen = 0;
-  int wordLen = 0;
-
-  auto pushLine = [&](const char* ln) {
-    if (wrapCount < MAX_LINES) {
-      strncpy(wrapBuffer[wrapCount], ln, LINE_MAX_CHARS - 1);
-      wrapBuffer[wrapCount][LINE_MAX_CHARS - 1] = 0;
-      wrapCount++;
-    }
-  };
-
-  auto flushWord = [&]() {
-    if (wordLen == 0) return;
-
-    if (lineLen == 0 && tft->textWidth(word, 2) > maxW) {
-      // Force split a very long word
-      char chunk[LINE_MAX_CHARS] = {0};
-      int chunkLen = 0;
-      for (int i = 0; i < wordLen; i++) {
-        if (chunkLen >= LINE_MAX_CHARS - 1) {
-          pushLine(chunk);
-          chunk[0] = 0;
-          chunkLen = 0;
-        }
-        chunk[chunkLen++] = word[i];
-        chunk[chunkLen] = 0;
-        if (tft->textWidth(chunk, 2) > maxW) {
-          chunk[chunkLen - 1] = 0;
-          pushLine(chunk);
-          chunk[0] = word[i];
-          chunk[1] = 0;
-          chunkLen = 1;
-        }
-      }
-      if (chunkLen > 0) pushLine(chunk);
-      word[0] = 0;
-      wordLen = 0;
-      return;
-    }
-
-    char test[LINE_MAX_CHARS] = {0};
-    if (lineLen == 0) {
-      strncpy(test, word, LINE_MAX_CHARS - 1);
-    } else {
-      snprintf(test, sizeof(test), "%s %s", line, word);
-    }
-
-    if (tft->textWidth(test, 2) <= maxW) {
-      strncpy(line, test, LINE_MAX_CHARS - 1);
-      line[LINE_MAX_CHARS - 1] = 0;
-      lineLen = strlen(line);
-    } else {
-      if (lineLen > 0) pushLine(line);
-      strncpy(line, word, LINE_MAX_CHARS - 1);
-      line[LINE_MAX_CHARS - 1] = 0;
-      lineLen = wordLen;
-    }
-
-    word[0] = 0;
-    wordLen = 0;
-  };
-
-  for (int i = 0; s[i] != 0; i++) {
-    char c = s[i];
-
-    if (c == '\n') {
-      flushWord();
-      if (lineLen > 0) pushLine(line);
-      line[0] = 0;
-      lineLen = 0;
-      continue;
-    }
-
-    if (c == ' ') {
-      flushWord();
-      continue;
-    }
-
-    if (wordLen >= LINE_MAX_CHARS - 1) {
-      flushWord();
-    }
-    word[wordLen++] = c;
-    word[wordLen] = 0;
-  }
-
-  flushWord();
-  if (lineLen > 0) pushLine(line);
-}
-
-static int wrapAndCountLines(const char* s, int maxW) {
-  wrapLines(s, maxW);
-  return max(1, wrapCount);
+// Re-wraps every message, e.g. after the wrap width changed.
+static void layoutAll(int maxW) {
+  cachedWrapW = maxW;
+  if (chatCount > 0) msgAt(0).lineOff = 0;
+  for (int i = 0; i < chatCount; i++) i = layoutMessage(i);
 }
 
-static void drawWrappedLineWindowLimited(const char* s, int maxW,
-                                         int firstLineToDraw, int lastLineToDraw,
-                                         int &currentLineIndex, int &y,
-                                         int maxLines) {
-  wrapLines(s, maxW);
-  int limit = wrapCount;
-  if (maxLines > 0 && maxLines < limit) limit = maxLines;
-  for (int i = 0; i < limit; i++) {
-    if (currentLineIndex >= firstLineToDraw && currentLineIndex < lastLineToDraw) {
-      if (y >= CHAT_TOP && y + LINE_H <= CHAT_BOTTOM) {
-        tft->fillRect(CHAT_X0, y, CHAT_X1 - CHAT_X0, LINE_H, TFT_WHITE);
-      }
-      tft->drawString(wrapBuffer[i], CHAT_X0, y, 2);
-      y += LINE_H;
-    }
-    currentLineIndex++;
+// Line k of message i from its cached line starts, into buf.
+static const char* cachedLineText(int i, int k, char* buf) {
+  const ChatMsg& m = msgAt(i);
+  bool user = k < m.userLines;
+  const char* prefix = user ? USER_PREFIX : AI_PREFIX;
+  const char* body = user ? msgUser(i) : msgAI(i);
+  int partEnd = user ? m.userLines : m.userLines + m.aiLines;
+
+  int start = lineStarts[(m.lineOff + k) % LINE_POOL];
+  int end = (k + 1 < partEnd) ? lineStarts[(m.lineOff + k + 1) % LINE_POOL]
+                              : PREFIX_LEN + (int)strlen(body);
+  end = min(end, start + LINE_CHARS);
+
+  for (int p = start; p < end; p++) {
+    buf[p - start] = p < PREFIX_LEN ? prefix[p] : body[p - PREFIX_LEN];
   }
+  int n = text_layout_trim(buf, 0, end - start);
+  buf[n] = 0;
+  return buf;
 }
 
+static int historyEndY = 0;      // bottom of the text drawn by the last pass
+
 static int aiVisibleLinesForIndex(int i) {
-  int full = max(1, (int)chatAILines[i]);
-  if (chatAIExpanded[i]) return full;
+  int full = max(1, (int)msgAt(i).aiLines);
+  if (msgAt(i).expanded) return full;
   return min(full, AI_COLLAPSED_LINES);
 }
 
-static void drawAIToggleAt(int x, int y, bool expanded) {
+static void drawAIToggleAt(TFT_eSPI* g, int x, int y, bool expanded) {
   uint16_t bg = TFT_LIGHTGREY;
-  tft->fillRect(x, y, AI_TOGGLE_W, AI_TOGGLE_H, bg);
-  tft->drawRect(x, y, AI_TOGGLE_W, AI_TOGGLE_H, TFT_BLACK);
+  g->fillRect(x, y, AI_TOGGLE_W, AI_TOGGLE_H, bg);
+  g->drawRect(x, y, AI_TOGGLE_W, AI_TOGGLE_H, TFT_BLACK);
   int cx = x + AI_TOGGLE_W / 2;
   int cy = y + AI_TOGGLE_H / 2;
   if (expanded) {
-    tft->fillTriangle(cx - 4, cy + 2, cx + 4, cy + 2, cx, cy - 3, TFT_BLACK);
+    g->fillTriangle(cx - 4, cy + 2, cx + 4, cy + 2, cx, cy - 3, TFT_BLACK);
   } else {
-    tft->fillTriangle(cx - 4, cy - 2, cx + 4, cy - 2, cx, cy + 3, TFT_BLACK);
+    g->fillTriangle(cx - 4, cy - 2, cx + 4, cy - 2, cx, cy + 3, TFT_BLACK);
   }
 }
 
-static void drawChatHistory() {
+// fromLine > 0 repaints only the lines from that index down, for a message
+// that is still growing at the end of the history.
+static void drawChatHistory(int fromLine = 0) {
   clearChatArea();
 
   int maxW = CHAT_X1 - CHAT_X0;
-  if (maxW != cachedWrapW) {
-    cachedWrapW = maxW;
-    for (int i = 0; i < chatCount; i++) {
-      char u[MAX_LEN + 8];
-      char a[MAX_LEN + 8];
-      snprintf(u, sizeof(u), "You: %s", chatUser[i]);
-      snprintf(a, sizeof(a), "AI:  %s", chatAI[i]);
-      chatUserLines[i] = (uint8_t)wrapAndCountLines(u, cachedWrapW);
-      chatAILines[i] = (uint8_t)wrapAndCountLines(a, cachedWrapW);
-    }
-  }
+  if (maxW != cachedWrapW) layoutAll(maxW);
   visibleLines = (CHAT_BOTTOM - chatCursorY) / LINE_H;
 
   totalLines = 0;
   for (int i = 0; i < chatCount; i++) {
-    totalLines += max(1, (int)chatUserLines[i]);
-    totalLines += aiVisibleLinesForIndex(i);
-    totalLines += BLOCK_GAP_LINES;
+    totalLines += msgAt(i).userLines + aiVisibleLinesForIndex(i) + BLOCK_GAP_LINES;
   }
 
   int maxScroll = max(0, totalLines - visibleLines);
@@ -339,62 +419,135 @@ static void drawChatHistory() {
 
   int first = scrollLine;
   int last  = scrollLine + visibleLines;
+  int line = 0;
+  char buf[LINE_CHARS + 1];
+
+  for (int i = 0; i < chatCount && line < last; i++) {
+    const ChatMsg& m = msgAt(i);
+    int shown = m.userLines + aiVisibleLinesForIndex(i);
+    if (line + shown <= first || line + shown <= fromLine) {
+      line += shown + BLOCK_GAP_LINES;
+      continue;
+    }
 
-  int currentLine = 0;
-  int y = chatCursorY;
+    for (int k = 0; k < shown; k++) {
+      int ln = line + k;
+      if (ln < first || ln < fromLine || ln >= last) continue;
+      int y = chatCursorY + (ln - first) * LINE_H;
+      tft->fillRect(CHAT_X0, y, CHAT_X1 - CHAT_X0, LINE_H, TFT_WHITE);
+      tft->drawString(cachedLineText(i, k, buf), CHAT_X0, y, 2);
+    }
 
-  for (int i = 0; i < chatCount; i++) {
-    char u[MAX_LEN + 8];
-    char a[MAX_LEN + 8];
-    snprintf(u, sizeof(u), "You: %s", chatUser[i]);
-    snprintf(a, sizeof(a), "AI:  %s", chatAI[i]);
+    int aiFirstLineIndex = line + m.userLines;
+    if (m.aiLines > AI_COLLAPSED_LINES &&
+        aiFirstLineIndex >= first && aiFirstLineIndex < last && aiFirstLineIndex >= fromLine) {
+      int ty = chatCursorY + (aiFirstLineIndex - first) * LINE_H;
+      drawAIToggleAt(tft, CHAT_X1 - AI_TOGGLE_W - 2, ty, m.expanded);
+    }
 
-    drawWrappedLineWindowLimited(u, maxW, first, last, currentLine, y, chatUserLines[i]);
-    int aiLinesToShow = aiVisibleLinesForIndex(i);
-    int aiFirstLineIndex = currentLine;
-    drawWrappedLineWindowLimited(a, maxW, first, last, currentLine, y, aiLinesToShow);
+    line += shown;
+    int gapFrom = max(line, max(first, fromLine));
+    int gapTo = min(line + BLOCK_GAP_LINES, last);
+    if (gapFrom < gapTo) {
+      tft->fillRect(CHAT_X0, chatCursorY + (gapFrom - first) * LINE_H,
+                    CHAT_X1 - CHAT_X0, (gapTo - gapFrom) * LINE_H, TFT_WHITE);
+    }
+    line += BLOCK_GAP_LINES;
+  }
 
-    if (chatAILines[i] > AI_COLLAPSED_LINES) {
-      if (aiFirstLineIndex >= first && aiFirstLineIndex < last) {
-        int ty = chatCursorY + (aiFirstLineIndex - first) * LINE_H;
-        int tx = CHAT_X1 - AI_TOGGLE_W - 2;
-        drawAIToggleAt(tx, ty, chatAIExpanded[i]);
-      }
+  // A partial repaint only has to clear what the previous pass left below.
+  int y = chatCursorY + constrain(line - first, 0, visibleLines) * LINE_H;
+  int clearTo = (fromLine > 0) ? min(historyEndY, (int)CHAT_BOTTOM) : CHAT_BOTTOM;
+  if (y < clearTo) {
+    tft->fillRect(CHAT_X0, y, CHAT_X1 - CHAT_X0, clearTo - y, TFT_WHITE);
+  }
+  historyEndY = y;
+}
+
+// History row `row` for the kinetic scroller: a text line, with the
+// expand toggle on a long reply's first line, or a gap between messages.
+static void drawHistoryRow(TFT_eSPI* g, int row, int y) {
+  int line = 0;
+  for (int i = 0; i < chatCount; i++) {
+    const ChatMsg& m = msgAt(i);
+    int shown = m.userLines + aiVisibleLinesForIndex(i);
+    if (row >= line + shown) {
+      line += shown + BLOCK_GAP_LINES;
+      continue;
     }
+    int k = row - line;
+    char buf[LINE_CHARS + 1];
+    g->setTextColor(TFT_BLACK, TFT_WHITE);
+    g->drawString(cachedLineText(i, k, buf), CHAT_X0, y, 2);
+    if (k == m.userLines && m.aiLines > AI_COLLAPSED_LINES) {
+      drawAIToggleAt(g, CHAT_X1 - AI_TOGGLE_W - 2, y, m.expanded);
+    }
+    return;
+  }
+}
+
+static void drawScrolled() {
+  KineticView v = {CHAT_X0, chatCursorY, CHAT_X1 - CHAT_X0, visibleLines * LINE_H, LINE_H,
+                   totalLines, TFT_WHITE, drawHistoryRow};
+  kinetic_render(tft, &v, kinetic.pos);
+}
+
+static void startScroll() {
+  if (scrolling) return;
+  kinetic_reset(&kinetic, scrollLine * LINE_H, max(0, totalLines - visibleLines) * LINE_H);
+  scrolling = true;
+}
 
-    currentLine += BLOCK_GAP_LINES;
-    y += BLOCK_GAP_LINES * LINE_H;
-    if (currentLine >= last) break;
+// Hands the view back to drawChatHistory() at the nearest line.
+static void settleScroll() {
+  if (!scrolling) return;
+  scrolling = false;
+  kinetic_stop(&kinetic);
+  scrollLine = (kinetic.pos + LINE_H / 2) / LINE_H;
+  drawChatHistory();
+}
+
+static void handleGesture(const GestureEvent& g) {
+  if (g.type == GESTURE_DRAG) {
+    startScroll();
+    kinetic_drag(&kinetic, g.dy);
+  } else if (g.type == GESTURE_FLING) {
+    kinetic_fling(&kinetic, g.vy, input_time());
   }
+}
 
-  if (y < CHAT_BOTTOM) {
-    tft->fillRect(CHAT_X0, y, CHAT_X1 - CHAT_X0, CHAT_BOTTOM - y, TFT_WHITE);
+// Index of the first AI line of message i in the history.
+static int aiFirstLine(int i) {
+  int line = 0;
+  for (int k = 0; k < i; k++) {
+    line += msgAt(k).userLines + aiVisibleLinesForIndex(k) + BLOCK_GAP_LINES;
   }
+  return line + msgAt(i).userLines;
 }
 
 static int hitAiToggle(int x, int y) {
   if (x < CHAT_X1 - AI_TOGGLE_W - 2 || x > CHAT_X1 - 2) return -1;
-  int maxW = CHAT_X1 - CHAT_X0;
   int first = scrollLine;
   int last  = scrollLine + visibleLines;
   int currentLine = 0;
 
   for (int i = 0; i < chatCount; i++) {
-    currentLine += max(1, (int)chatUserLines[i]);
-    if (chatAILines[i] > AI_COLLAPSED_LINES) {
+    currentLine += msgAt(i).userLines;
+    if (msgAt(i).aiLines > AI_COLLAPSED_LINES) {
       int aiFirstLineIndex = currentLine;
       if (aiFirstLineIndex >= first && aiFirstLineIndex < last) {
         int ty = chatCursorY + (aiFirstLineIndex - first) * LINE_H;
         if (y >= ty && y <= ty + AI_TOGGLE_H) return i;
       }
     }
-    currentLine += aiVisibleLinesForIndex(i);
+    currentLine += aiVisibleLinesForIndex(i) + BLOCK_GAP_LINES;
   }
   return -1;
 }
 
 void chat_scroll_steps(int steps) {
   if (!tft) return;
+  settleScroll();
   int maxScroll = max(0, totalLines - visibleLines);
   scrollLine = constrain(scrollLine - steps, 0, maxScroll);
   drawChatHistory();
@@ -402,14 +555,17 @@ void chat_scroll_steps(int steps) {
   updateInputText();
 }
 
-void chat_init(TFT_eSPI* display) {
+void chat_init(Display* display) {
   tft = display;
 
   kbVisible = true;
 }
 
 void chat_draw() {
+  opened = true;
   applyLayout();
+  scrolling = false;
+  gesture_reset(&gesture);
 
   tft->fillScreen(TFT_WHITE);
   drawHeader();
@@ -421,8 +577,33 @@ void chat_draw() {
   if (kbVisible) keyboard_draw();
 }
 
+void chat_close() {
+  opened = false;
+  kinetic_release();
+}
+
 void chat_tick() {
+  // Drain everything the worker produced since the last tick, then repaint
+  // once from the first line that changed. This runs whether or not the
+  // window is open: the worker blocks once its event queue is full.
+  AiEvent ev;
+  int changed = -1;
+  while (ai_pollEvent(ev)) {
+    int i = applyAIEvent(ev);
+    if (i >= 0 && (changed < 0 || i < changed)) changed = i;
+  }
+  if (!opened) return;
+  // A moving view is repainted whole by its next frame or when it settles.
+  if (changed >= 0) {
+    if (!scrolling) drawChatHistory(aiFirstLine(changed));
+    if (!replyPending) drawSendButton();
+  }
+
   uint32_t now = millis();
+  if (scrolling) {
+    if (kinetic_frame(&kinetic, now)) drawScrolled();
+    if (!gesture_active(&gesture) && !kinetic_moving(&kinetic)) settleScroll();
+  }
   if (now - lastStatusTick > 900) {
     system_ui_tick(164, 6, TFT_BLUE);
     lastStatusTick = now;
@@ -431,14 +612,65 @@ void chat_tick() {
 
 void chat_release() {
   keyboard_release();
-  draggingChat = false;
-  dragAccum = 0;
-  drawChatHistory();
+  if (!scrolling) drawChatHistory();
+}
+
+// SEND: the input becomes a message and a request.
+static void sendInput() {
+  String userText = keyboard_get_text();
+  userText.trim();
+
+  // One reply at a time: it streams into the newest message. The text
+  // stays in the input until SEND is available again.
+  if (userText.length() > 0 && !replyPending) {
+    settleScroll();
+    // Clear input immediately for better UX
+    keyboard_clear();
+    updateInputText();
+
+    // The reply is filled in by chat_tick() when the worker is done;
+    // the UI keeps running meanwhile.
+    if (ai_requestAsync(userText)) {
+      pushMessage(userText.c_str(), "", true);
+      drawSendButton();
+    } else {
+      pushMessage(userText.c_str(), "Still busy, try again in a moment.");
+    }
+
+    scrollLine = 0; // show from the beginning after sending
+    drawChatHistory();
+  }
+}
+
+void chat_keys(const char* keys, int n) {
+  if (!tft) return;
+  // The input is repainted once per run of keys, however long.
+  for (int i = 0; i < n;) {
+    int used = keyboard_type(keys + i, n - i);
+    if (used > 0) updateInputText();
+    i += used;
+    if (i < n) {
+      sendInput();   // INPUT_KEY_ENTER
+      i++;
+    }
+  }
 }
 
 void chat_handleTouch(bool pressed, bool lastPressed, int x, int y) {
   if (!tft) return;
 
+  // A history drag keeps the pointer until it is released.
+  if (gesture_active(&gesture)) {
+    GestureEvent g;
+    if (gesture_feed(&gesture, pressed, x, y, input_time(), &g)) handleGesture(g);
+    if (pressed) return;
+  }
+  if (pressed && !lastPressed && scrolling) {
+    // Touching the history catches a fling; anything else ends it first.
+    if (inChatArea(x, y)) kinetic_stop(&kinetic);
+    else settleScroll();
+  }
+
   if (pressed && kbVisible) {
     KB_Action tickA = keyboard_tick(true, x, y);
     if (tickA == KB_CHANGED) {
@@ -464,52 +696,19 @@ void chat_handleTouch(bool pressed, bool lastPressed, int x, int y) {
   }
 
   if (pressed && !lastPressed && inChatArea(x, y)) {
-    int idx = hitAiToggle(x, y);
+    int idx = scrolling ? -1 : hitAiToggle(x, y);
     if (idx >= 0) {
-      chatAIExpanded[idx] = !chatAIExpanded[idx];
+      msgAt(idx).expanded = !msgAt(idx).expanded;
       drawChatHistory();
       return;
     }
-  }
-
-  if (pressed && inChatArea(x, y)) {
-    if (!draggingChat) {
-      draggingChat = true;
-      dragStartY = y;
-      dragAccum = 0;
-      return;
-    }
-
-    int dy = y - dragStartY;
-    dragStartY = y;
-    dragAccum += dy;
-
-    if (abs(dragAccum) >= LINE_H) {
-      int steps = dragAccum / LINE_H;
-      dragAccum -= steps * LINE_H;
-
-      int maxScroll = max(0, totalLines - visibleLines);
-      scrollLine = constrain(scrollLine - steps, 0, maxScroll);
-      drawChatHistory();
-    }
+    GestureEvent g;
+    gesture_feed(&gesture, true, x, y, input_time(), &g);
     return;
   }
 
   if (pressed && !lastPressed && inRect(x, y, 250, INPUT_Y, 66, INPUT_H)) {
-    String userText = keyboard_get_text();
-    userText.trim();
-
-    if (userText.length() > 0) {
-      // Clear input immediately for better UX
-      keyboard_clear();
-      updateInputText();
-
-      String aiText = ai_sendMessage(userText);
-      pushMessage(userText.c_str(), aiText.c_str());
-
-      scrollLine = 0; // show from the beginning after sending
-      drawChatHistory();
-    }
+    sendInput();
     return;
   }
 
@@ -1,11 +1,16 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "display.h"
 
-void chat_init(TFT_eSPI* tft);
+void chat_init(Display* tft);
 void chat_draw();
+// Replies keep streaming into the history while the window is closed;
+// chat_tick() then only takes the worker's events and draws nothing.
+void chat_close();
 void chat_tick();
 
 void chat_handleTouch(bool pressed, bool lastPressed, int x, int y);
 void chat_scroll_steps(int steps);
+// Keys typed on the bridge (input_poll_keys()); Enter sends.
+void chat_keys(const char* keys, int n);
 
 void chat_release();
@@ -25,6 +25,23 @@ export default {
     const model = body.model || "@cf/meta/llama-3.1-8b-instruct";
     const prompt = body.prompt || "Reply in English with a full answer.";
 
+    // Streaming: pass the model's SSE stream straight through
+    // ("data: {"response":"..."}" per token, then "data: [DONE]").
+    if (body.stream === true) {
+      const stream = await env.AI.run(model, {
+        prompt,
+        max_tokens: 300,
+        stream: true,
+      });
+
+      return new Response(stream, {
+        headers: {
+          "content-type": "text/event-stream",
+          "cache-control": "no-cache",
+        },
+      });
+    }
+
     const result = await env.AI.run(model, {
       prompt,
       max_tokens: 300,
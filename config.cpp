@@ -0,0 +1,215 @@
+#include "config.h"
+#include "persist.h"
+#include <Preferences.h>
+#include <Arduino.h>
+
+static const char* NVS_NS  = "config";
+static const char* NVS_KEY = "blob";
+
+// New fields go at the end: a blob written by an older version is a
+// prefix of this struct, and the fields it lacks keep their defaults.
+struct __attribute__((packed)) ConfigData {
+  uint8_t brightness;
+  uint8_t autoConnect;
+  uint8_t trashMask;
+  char wifiSsid[CONFIG_SSID_MAX + 1];
+  char wifiPass[CONFIG_PASS_MAX + 1];
+  char aiToken[CONFIG_TOKEN_MAX + 1];
+};
+
+struct __attribute__((packed)) ConfigBlob {
+  uint16_t version;
+  uint16_t size;      // bytes of data that follow
+  uint32_t crc;       // CRC-32 of those bytes
+  ConfigData data;
+};
+
+static const ConfigData DEFAULTS = {
+  220,    // brightness
+  1,      // autoConnect
+  0,      // trashMask
+  "", "", ""
+};
+
+static ConfigData cfg = DEFAULTS;
+static bool lastSaveOk = true;
+
+static uint32_t crc32(const uint8_t* p, size_t n) {
+  uint32_t crc = 0xFFFFFFFF;
+  while (n--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+// Writes cfg and reads it back. Returns true once the blob in flash
+// matches.
+static bool writeBlob() {
+  ConfigBlob blob;
+  blob.version = CONFIG_VERSION;
+  blob.size = sizeof(ConfigData);
+  blob.data = cfg;
+  blob.crc = crc32((const uint8_t*)&blob.data, sizeof(ConfigData));
+  ConfigBlob check;
+  Preferences p;
+  p.begin(NVS_NS, false);
+  bool ok = p.putBytes(NVS_KEY, &blob, sizeof(blob)) == sizeof(blob) &&
+            p.getBytes(NVS_KEY, &check, sizeof(check)) == sizeof(check) &&
+            memcmp(&blob, &check, sizeof(blob)) == 0;
+  p.end();
+  return ok;
+}
+
+static void saveBlob() {
+  lastSaveOk = writeBlob();
+}
+
+// Commits now (along with anything else pending) instead of after the
+// write-behind delay.
+static bool commitNow() {
+  persist_mark_dirty(PERSIST_CONFIG);
+  persist_flush();
+  return lastSaveOk;
+}
+
+static void copyString(char* dst, size_t size, const String& s) {
+  strncpy(dst, s.c_str(), size - 1);
+  dst[size - 1] = 0;
+}
+
+// Empties a namespace of the old layout once its values are in the blob.
+static void dropLegacy(const char* ns) {
+  Preferences p;
+  p.begin(ns, false);
+  p.clear();
+  p.end();
+}
+
+// Old namespaces, in the order migrateLegacy() reads them.
+static const char* const LEGACY_NS[] = { "settings", "trash", "wifi", "cfg" };
+enum { LEGACY_SETTINGS = 1, LEGACY_TRASH = 2, LEGACY_WIFI = 4, LEGACY_CFG = 8 };
+
+// Picks up the namespaces each module used to keep. Returns a mask of the
+// ones that are now fully in cfg and can be dropped once the blob is
+// written. A value that does not fit the blob is left out of cfg and its
+// namespace is kept, so nothing is lost.
+static uint8_t migrateLegacy() {
+  uint8_t done = 0;
+  Preferences p;
+  p.begin("settings", true);
+  if (p.isKey("bright") || p.isKey("autoc")) done |= LEGACY_SETTINGS;
+  cfg.brightness = p.getUChar("bright", cfg.brightness);
+  cfg.autoConnect = p.getBool("autoc", cfg.autoConnect) ? 1 : 0;
+  p.end();
+
+  p.begin("trash", true);
+  if (p.isKey("mask")) done |= LEGACY_TRASH;
+  cfg.trashMask = p.getUChar("mask", cfg.trashMask);
+  p.end();
+
+  p.begin("wifi", true);
+  bool found = p.isKey("ssid");
+  String ssid = p.getString("ssid", "");
+  String pass = p.getString("pass", "");
+  p.end();
+  ssid.trim();
+  pass.trim();
+  if (ssid.length() <= CONFIG_SSID_MAX && pass.length() <= CONFIG_PASS_MAX) {
+    copyString(cfg.wifiSsid, sizeof(cfg.wifiSsid), ssid);
+    copyString(cfg.wifiPass, sizeof(cfg.wifiPass), pass);
+    if (found) done |= LEGACY_WIFI;
+  } else {
+    Serial.println("Config: saved Wi-Fi network too long, kept in old storage");
+  }
+
+  p.begin("cfg", true);
+  found = p.isKey("auth");
+  String tok = p.getString("auth", "");
+  p.end();
+  tok.trim();
+  if (tok.length() <= CONFIG_TOKEN_MAX) {
+    copyString(cfg.aiToken, sizeof(cfg.aiToken), tok);
+    if (found) done |= LEGACY_CFG;
+  } else {
+    Serial.println("Config: saved token too long, kept in old storage");
+  }
+  return done;
+}
+
+void config_init() {
+  persist_register(PERSIST_CONFIG, saveBlob);
+
+  ConfigBlob blob;
+  Preferences p;
+  p.begin(NVS_NS, true);
+  size_t n = p.getBytes(NVS_KEY, &blob, sizeof(blob));
+  p.end();
+
+  size_t header = sizeof(blob) - sizeof(ConfigData);
+  if (n >= header && blob.version >= 1 && blob.version <= CONFIG_VERSION &&
+      blob.size <= sizeof(ConfigData) && n == header + blob.size &&
+      blob.crc == crc32((const uint8_t*)&blob.data, blob.size)) {
+    cfg = DEFAULTS;
+    memcpy(&cfg, &blob.data, blob.size);
+    cfg.wifiSsid[CONFIG_SSID_MAX] = 0;
+    cfg.wifiPass[CONFIG_PASS_MAX] = 0;
+    cfg.aiToken[CONFIG_TOKEN_MAX] = 0;
+    if (blob.version < CONFIG_VERSION) persist_mark_dirty(PERSIST_CONFIG);
+    return;
+  }
+
+  // First boot with this layout (or a damaged blob): start from the
+  // defaults plus whatever the old namespaces held, and write the blob
+  // right away so the next boot is a single read. The old namespaces are
+  // only dropped once the blob has been read back intact; until then a
+  // reset just runs the migration again.
+  cfg = DEFAULTS;
+  uint8_t migrated = migrateLegacy();
+  if (!writeBlob()) {
+    Serial.println("Config: could not write settings, old storage kept");
+    return;
+  }
+  for (size_t i = 0; i < sizeof(LEGACY_NS) / sizeof(LEGACY_NS[0]); i++) {
+    if (migrated & (1 << i)) dropLegacy(LEGACY_NS[i]);
+  }
+}
+
+uint8_t config_get_brightness() { return cfg.brightness; }
+bool config_get_autoconnect() { return cfg.autoConnect != 0; }
+uint8_t config_get_trash_mask() { return cfg.trashMask; }
+const char* config_get_wifi_ssid() { return cfg.wifiSsid; }
+const char* config_get_wifi_pass() { return cfg.wifiPass; }
+const char* config_get_ai_token() { return cfg.aiToken; }
+
+void config_set_brightness(uint8_t val) {
+  if (cfg.brightness == val) return;
+  cfg.brightness = val;
+  persist_mark_dirty(PERSIST_CONFIG);
+}
+
+void config_set_autoconnect(bool on) {
+  if (config_get_autoconnect() == on) return;
+  cfg.autoConnect = on ? 1 : 0;
+  persist_mark_dirty(PERSIST_CONFIG);
+}
+
+void config_set_trash_mask(uint8_t mask) {
+  if (cfg.trashMask == mask) return;
+  cfg.trashMask = mask;
+  persist_mark_dirty(PERSIST_CONFIG);
+}
+
+bool config_set_wifi(const char* ssid, const char* pass) {
+  strncpy(cfg.wifiSsid, ssid, CONFIG_SSID_MAX);
+  cfg.wifiSsid[CONFIG_SSID_MAX] = 0;
+  strncpy(cfg.wifiPass, pass, CONFIG_PASS_MAX);
+  cfg.wifiPass[CONFIG_PASS_MAX] = 0;
+  return commitNow();
+}
+
+bool config_set_ai_token(const char* tok) {
+  if (strlen(tok) > CONFIG_TOKEN_MAX) return false;
+  strcpy(cfg.aiToken, tok);
+  return commitNow();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+
+// All persistent settings in one packed, versioned struct, stored as a
+// single NVS blob with a CRC.
+//
+// config_init() reads the blob once at boot; every accessor after that
+// works on the copy in RAM. Setters mark the blob dirty for the
+// write-behind layer (persist.h), which writes it back whole.
+//
+// Boards that still have the old per-module namespaces (settings, trash,
+// wifi, cfg) are migrated on the first boot that finds no valid blob.
+
+#define CONFIG_VERSION   1
+#define CONFIG_SSID_MAX  32
+#define CONFIG_PASS_MAX  64
+#define CONFIG_TOKEN_MAX 128
+
+void config_init();
+
+uint8_t config_get_brightness();
+void config_set_brightness(uint8_t val);
+
+bool config_get_autoconnect();
+void config_set_autoconnect(bool on);
+
+uint8_t config_get_trash_mask();
+void config_set_trash_mask(uint8_t mask);
+
+// Credentials are not left to the write-behind delay: their setters
+// commit to flash before returning, and return false if that failed.
+
+// Saved network; "" when none.
+const char* config_get_wifi_ssid();
+const char* config_get_wifi_pass();
+bool config_set_wifi(const char* ssid, const char* pass);
+
+// Worker token; "" when none. Returns false (and keeps the old token) if
+// tok does not fit.
+const char* config_get_ai_token();
+bool config_set_ai_token(const char* tok);
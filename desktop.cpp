@@ -11,7 +11,7 @@
 
 #include <Arduino.h>
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 
 static const int SCREEN_W = 320;
 static const int SCREEN_H = 240;
@@ -133,8 +133,7 @@ static Rect rectForTarget(DragTarget t) {
 }
 
 static void setSelected(DragTarget t);
-static void redrawSceneRect(int x,int y,int w,int h);
-static void animateDeleteRect(const Rect& r);
+static void markDirty(int x, int y, int w, int h);
 
 // Taskbar + Start menu
 static const int TASKBAR_H = 20;
@@ -154,55 +153,141 @@ static const int START_MENU_ITEMS = 7;
 
 static uint32_t lastStatusTick = 0;
 
-static uint16_t wallBuf[200 * 80];
-static const int WALLBUF_MAX = (int)(sizeof(wallBuf) / sizeof(wallBuf[0]));
-
-static void redrawWallpaperRect(int x, int y, int w, int h) {
-  if (!tft) return;
+static const int STATUS_X = SCREEN_W - 92;
+static const int STATUS_Y = START_Y + 1;
+static const int STATUS_W = 90;
+static const int STATUS_H = 16;
+
+// ---------- Compositor ----------
+// Scene changes only record damage rects. When the current touch / tick is
+// done, overlapping rects are merged and each one is composed off screen
+// (wallpaper, then icons with transparency, then taskbar and menus) and sent
+// with a single pushImage, so nothing is drawn twice and nothing flickers.
+// The scratch sprite has the same 16000 pixel budget the old wallpaper
+// buffer had; larger regions are sent as several tiles.
+static const int SCRATCH_W = 160;
+static const int SCRATCH_H = 100;
+
+static TFT_eSprite* scratch = nullptr;
+static bool scratchFailed = false;
+
+// Target of the paint* functions: the scratch sprite while composing, the
+// screen if the sprite could not be allocated.
+static TFT_eSPI* gfx = nullptr;
+static bool composing = false;
+static int tileX = 0, tileY = 0, tileW = 0, tileH = 0;
+
+static const int MAX_DAMAGE = 8;
+static const int MERGE_SLACK = 1024;   // px of extra area accepted to merge two rects
+static Rect damage[MAX_DAMAGE];
+static int damageCount = 0;
+
+static inline int rectArea(const Rect& r) { return r.w * r.h; }
+
+static Rect rectUnion(const Rect& a, const Rect& b) {
+  int x0 = min(a.x, b.x);
+  int y0 = min(a.y, b.y);
+  int x1 = max(a.x + a.w, b.x + b.w);
+  int y1 = max(a.y + a.h, b.y + b.h);
+  return { x0, y0, x1 - x0, y1 - y0 };
+}
 
+static void markDirty(int x, int y, int w, int h) {
   if (x < 0) { w += x; x = 0; }
   if (y < 0) { h += y; y = 0; }
   if (x + w > SCREEN_W) w = SCREEN_W - x;
   if (y + h > SCREEN_H) h = SCREEN_H - y;
   if (w <= 0 || h <= 0) return;
 
-  int pixels = w * h;
-  if (pixels > WALLBUF_MAX) {
-    tft->setSwapBytes(true);
-    tft->pushImage(0, 0, WALLPAPER_WIDTH, WALLPAPER_HEIGHT, wallpaper_map);
+  Rect r = { x, y, w, h };
+
+  // Fold in every rect that is cheaper to redraw together than apart.
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (int i = 0; i < damageCount; i++) {
+      Rect u = rectUnion(r, damage[i]);
+      if (rectArea(u) <= rectArea(r) + rectArea(damage[i]) + MERGE_SLACK) {
+        r = u;
+        damage[i] = damage[--damageCount];
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  if (damageCount == MAX_DAMAGE) {
+    int best = 0;
+    int bestGrow = 0x7FFFFFFF;
+    for (int i = 0; i < damageCount; i++) {
+      int grow = rectArea(rectUnion(r, damage[i])) - rectArea(damage[i]);
+      if (grow < bestGrow) { bestGrow = grow; best = i; }
+    }
+    r = rectUnion(r, damage[best]);
+    damage[best] = damage[--damageCount];
+  }
+
+  damage[damageCount++] = r;
+}
+
+static inline uint16_t swap16(uint16_t c) { return (uint16_t)((c >> 8) | (c << 8)); }
+
+// Icons are keyed on black. TFT_eSprite has no keyed pushImage, so while
+// composing the pixels are copied straight into the scratch buffer.
+static void blitIcon(int x, int y, int w, int h, const uint16_t* map) {
+  if (!composing) {
+    gfx->setSwapBytes(true);
+    gfx->pushImage(x, y, w, h, map, 0x0000);
     return;
   }
 
-  int idx = 0;
-  for (int yy = 0; yy < h; yy++) {
-    int srcRow = (y + yy) * SCREEN_W;
-    int srcBase = srcRow + x;
-    for (int xx = 0; xx < w; xx++) {
-      wallBuf[idx++] = wallpaper_map[srcBase + xx];
+  int x0 = max(x, tileX), y0 = max(y, tileY);
+  int x1 = min(x + w, tileX + tileW), y1 = min(y + h, tileY + tileH);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  uint16_t* buf = (uint16_t*)scratch->getPointer();
+  for (int yy = y0; yy < y1; yy++) {
+    const uint16_t* src = map + (yy - y) * w;
+    uint16_t* dst = buf + (yy - tileY) * SCRATCH_W - tileX;
+    for (int xx = x0; xx < x1; xx++) {
+      uint16_t c = pgm_read_word(&src[xx - x]);
+      if (c != 0x0000) dst[xx] = swap16(c);
     }
   }
+}
+
+static void paintWallpaper(int x, int y, int w, int h) {
+  if (composing) {
+    uint16_t* buf = (uint16_t*)scratch->getPointer();
+    for (int yy = 0; yy < h; yy++) {
+      const uint16_t* src = wallpaper_map + (y + yy) * WALLPAPER_WIDTH + x;
+      uint16_t* dst = buf + yy * SCRATCH_W;
+      for (int xx = 0; xx < w; xx++) dst[xx] = swap16(pgm_read_word(&src[xx]));
+    }
+    return;
+  }
 
-  tft->setSwapBytes(true);
-  tft->pushImage(x, y, w, h, wallBuf);
+  // No scratch buffer: stream the rows straight out of flash.
+  gfx->setSwapBytes(true);
+  for (int yy = 0; yy < h; yy++) {
+    gfx->pushImage(x, y + yy, w, 1, wallpaper_map + (y + yy) * WALLPAPER_WIDTH + x);
+  }
 }
 
 static void drawWifiIcon() {
   bool sel = (selectedTarget == DRAG_WIFI);
 
-  tft->setSwapBytes(true);
-
-  tft->pushImage(wifiX, wifiY, WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT, wifi_icon_map, 0x0000);
+  blitIcon(wifiX, wifiY, WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT, wifi_icon_map);
 
   int labelTop = wifiY + WIFI_ICON_HEIGHT + LABEL_Y_GAP;
   drawLabelXP("WiFi", wifiX + WIFI_ICON_WIDTH/2, labelTop, sel);
 }
 
-
 static void drawTaskbar() {
   int y = SCREEN_H - TASKBAR_H;
   // XP-style taskbar (solid blue, no grey block)
-  tft->fillRect(0, y, SCREEN_W, TASKBAR_H, 0x047F);
-  tft->drawFastHLine(0, y, SCREEN_W, 0x7BEF);
+  gfx->fillRect(0, y, SCREEN_W, TASKBAR_H, 0x047F);
+  gfx->drawFastHLine(0, y, SCREEN_W, 0x7BEF);
 
   // Start button with hover/pressed states
   {
@@ -210,34 +295,43 @@ static void drawTaskbar() {
     uint16_t hover = 0x27E0;
     uint16_t pressed = 0x04C0;
     uint16_t fill = (startMenuVisible || startPressed) ? pressed : (startHover ? hover : base);
-    tft->fillRoundRect(START_X, START_Y - 1, START_W, START_H + 2, 6, fill);
-    tft->drawRoundRect(START_X, START_Y - 1, START_W, START_H + 2, 6, TFT_WHITE);
-    tft->setTextColor(TFT_WHITE, fill);
-    tft->drawString("Start", START_X + 8, START_Y + 2, 2);
+    gfx->fillRoundRect(START_X, START_Y - 1, START_W, START_H + 2, 6, fill);
+    gfx->drawRoundRect(START_X, START_Y - 1, START_W, START_H + 2, 6, TFT_WHITE);
+    gfx->setTextColor(TFT_WHITE, fill);
+    gfx->drawString("Start", START_X + 8, START_Y + 2, 2);
   }
 
   // Status icons directly on the blue taskbar (no separate block)
-  system_ui_draw_status(SCREEN_W - 92, START_Y + 1, 0x047F);
+  system_ui_draw_status_to(gfx, STATUS_X, STATUS_Y, 0x047F);
 
   // No clock/status block
 }
 
+static void invalidateTaskbar() {
+  markDirty(0, SCREEN_H - TASKBAR_H, SCREEN_W, TASKBAR_H);
+}
+
+static Rect startMenuRect() {
+  int h = START_MENU_ITEMS * START_MENU_ITEM_H + 6;
+  int y = startMenuY - h;
+  if (y < 0) y = 0;
+  return { startMenuX, y, START_MENU_W, h };
+}
+
 void desktop_set_mouse_mode(bool on) {
   if (mouseMode == on) return;
   mouseMode = on;
   if (!mouseMode && startHover) {
     startHover = false;
-    drawTaskbar();
+    invalidateTaskbar();
   }
 }
 
 static void drawStartMenu(int activeItem) {
-  startMenuVisible = true;
-
-  int h = START_MENU_ITEMS * START_MENU_ITEM_H + 6;
-  int x = startMenuX;
-  int y = startMenuY - h;
-  if (y < 0) y = 0;
+  Rect r = startMenuRect();
+  int x = r.x;
+  int y = r.y;
+  int h = r.h;
 
   uint16_t bg        = 0xEF7D;
   uint16_t borderDk  = 0x7BEF;
@@ -246,18 +340,18 @@ static void drawStartMenu(int activeItem) {
   uint16_t hlBlue    = 0x1C9F;
   uint16_t hlBlue2   = 0x047F;
 
-  tft->fillRect(x, y, START_MENU_W, h, bg);
-  tft->drawFastHLine(x, y, START_MENU_W, borderLt);
-  tft->drawFastVLine(x, y, h, borderLt);
-  tft->drawFastHLine(x, y + h - 1, START_MENU_W, borderDk);
-  tft->drawFastVLine(x + START_MENU_W - 1, y, h, borderDk);
-  tft->drawRect(x + 1, y + 1, START_MENU_W - 2, h - 2, innerDk);
+  gfx->fillRect(x, y, START_MENU_W, h, bg);
+  gfx->drawFastHLine(x, y, START_MENU_W, borderLt);
+  gfx->drawFastVLine(x, y, h, borderLt);
+  gfx->drawFastHLine(x, y + h - 1, START_MENU_W, borderDk);
+  gfx->drawFastVLine(x + START_MENU_W - 1, y, h, borderDk);
+  gfx->drawRect(x + 1, y + 1, START_MENU_W - 2, h - 2, innerDk);
 
   // XP-like left stripe
   int stripeW = 28;
   for (int i = 0; i < h; i++) {
     uint16_t c = (i % 2 == 0) ? 0x1C9F : 0x047F;
-    tft->drawFastHLine(x + 2, y + 2 + i, stripeW, c);
+    gfx->drawFastHLine(x + 2, y + 2 + i, stripeW, c);
   }
 
   const char* items[START_MENU_ITEMS] = {
@@ -271,38 +365,38 @@ static void drawStartMenu(int activeItem) {
     int ih = START_MENU_ITEM_H;
 
     if (i == activeItem) {
-      tft->fillRect(ix, iy, iw, ih/2, hlBlue);
-      tft->fillRect(ix, iy + ih/2, iw, ih - ih/2, hlBlue2);
-      tft->drawRect(ix, iy, iw, ih, TFT_WHITE);
-      tft->setTextColor(TFT_WHITE, hlBlue2);
+      gfx->fillRect(ix, iy, iw, ih/2, hlBlue);
+      gfx->fillRect(ix, iy + ih/2, iw, ih - ih/2, hlBlue2);
+      gfx->drawRect(ix, iy, iw, ih, TFT_WHITE);
+      gfx->setTextColor(TFT_WHITE, hlBlue2);
     } else {
-      tft->setTextColor(TFT_BLACK, bg);
+      gfx->setTextColor(TFT_BLACK, bg);
     }
 
-    tft->drawString(items[i], ix + 6, iy + 3, 2);
+    gfx->drawString(items[i], ix + 6, iy + 3, 2);
   }
 }
 
+static void showStartMenu() {
+  startMenuVisible = true;
+  Rect r = startMenuRect();
+  markDirty(r.x, r.y, r.w, r.h);
+}
+
 static void hideStartMenu() {
   if (!startMenuVisible) return;
-  int h = START_MENU_ITEMS * START_MENU_ITEM_H + 6;
-  int x = startMenuX;
-  int y = startMenuY - h;
-  if (y < 0) y = 0;
+  Rect r = startMenuRect();
   startMenuVisible = false;
   startMenuActive = -1;
-  redrawSceneRect(x, y, START_MENU_W, h);
-  drawTaskbar();
+  markDirty(r.x, r.y, r.w, r.h);
+  invalidateTaskbar();
 }
 
 static int startMenuHitItem(int x, int y) {
   if (!startMenuVisible) return -1;
-  int h = START_MENU_ITEMS * START_MENU_ITEM_H + 6;
-  int mx = startMenuX;
-  int my = startMenuY - h;
-  if (my < 0) my = 0;
-  if (!inRect(x, y, mx, my, START_MENU_W, h)) return -1;
-  int relY = y - (my + 3);
+  Rect r = startMenuRect();
+  if (!inRect(x, y, r.x, r.y, r.w, r.h)) return -1;
+  int relY = y - (r.y + 3);
   int idx = relY / START_MENU_ITEM_H;
   if (idx < 0 || idx >= START_MENU_ITEMS) return -1;
   return idx;
@@ -313,7 +407,7 @@ static void drawLabelXP(const char* label, int cx, int topY, bool selected) {
   const uint16_t sel1 = 0x1C9F;
   const uint16_t sel2 = 0x047F;
 
-  int tw = tft->textWidth(label, LABEL_FONT);
+  int tw = gfx->textWidth(label, LABEL_FONT);
   int boxW = tw + 14;
   if (boxW < 34) boxW = 34;
   if (boxW > LABEL_W) boxW = LABEL_W;
@@ -326,33 +420,33 @@ static void drawLabelXP(const char* label, int cx, int topY, bool selected) {
   if (x + boxW > SCREEN_W - 2) x = SCREEN_W - 2 - boxW;
 
   if (selected) {
-    tft->fillRect(x, y, boxW, boxH/2, sel1);
-    tft->fillRect(x, y + boxH/2, boxW, boxH - boxH/2, sel2);
-    tft->drawRect(x, y, boxW, boxH, TFT_WHITE);
-
-    tft->setTextDatum(MC_DATUM);
-    tft->setTextColor(TFT_WHITE, sel2);
-    tft->drawString(label, cx, y + boxH/2, LABEL_FONT);
-    tft->setTextDatum(TL_DATUM);
+    gfx->fillRect(x, y, boxW, boxH/2, sel1);
+    gfx->fillRect(x, y + boxH/2, boxW, boxH - boxH/2, sel2);
+    gfx->drawRect(x, y, boxW, boxH, TFT_WHITE);
+
+    gfx->setTextDatum(MC_DATUM);
+    gfx->setTextColor(TFT_WHITE, sel2);
+    gfx->drawString(label, cx, y + boxH/2, LABEL_FONT);
+    gfx->setTextDatum(TL_DATUM);
   } else {
 
-    tft->setTextDatum(MC_DATUM);
-    tft->setTextColor(TFT_BLACK);
-    tft->drawString(label, cx+1, topY + LABEL_H/2 + 1, LABEL_FONT);
-    tft->setTextColor(TFT_WHITE);
-    tft->drawString(label, cx,   topY + LABEL_H/2,     LABEL_FONT);
-    tft->setTextDatum(TL_DATUM);
+    gfx->setTextDatum(MC_DATUM);
+    gfx->setTextColor(TFT_BLACK);
+    gfx->drawString(label, cx+1, topY + LABEL_H/2 + 1, LABEL_FONT);
+    gfx->setTextColor(TFT_WHITE);
+    gfx->drawString(label, cx,   topY + LABEL_H/2,     LABEL_FONT);
+    gfx->setTextDatum(TL_DATUM);
   }
 }
 
 static void drawAIIcon() {
   bool sel = (selectedTarget == DRAG_AI);
 
-  tft->fillRoundRect(aiX, aiY, aiW, aiH, 8, TFT_BLUE);
-  tft->drawRoundRect(aiX, aiY, aiW, aiH, 8, TFT_WHITE);
+  gfx->fillRoundRect(aiX, aiY, aiW, aiH, 8, TFT_BLUE);
+  gfx->drawRoundRect(aiX, aiY, aiW, aiH, 8, TFT_WHITE);
 
-  tft->setTextColor(TFT_WHITE, TFT_BLUE);
-  tft->drawCentreString("AI", aiX + aiW/2, aiY + 10, 4);
+  gfx->setTextColor(TFT_WHITE, TFT_BLUE);
+  gfx->drawCentreString("AI", aiX + aiW/2, aiY + 10, 4);
 
   int labelTop = aiY + aiH + LABEL_Y_GAP;
   drawLabelXP("Chat", aiX + aiW/2, labelTop, sel);
@@ -362,8 +456,7 @@ static void drawAIIcon() {
 static void drawPaintIcon() {
   bool sel = (selectedTarget == DRAG_PAINT);
 
-  tft->setSwapBytes(true);
-  tft->pushImage(paintX, paintY, PAINT_ICON_WIDTH, PAINT_ICON_HEIGHT, paint_icon_map, 0x0000);
+  blitIcon(paintX, paintY, PAINT_ICON_WIDTH, PAINT_ICON_HEIGHT, paint_icon_map);
 
   int labelTop = paintY + PAINT_ICON_HEIGHT + LABEL_Y_GAP;
   drawLabelXP("Paint", paintX + PAINT_ICON_WIDTH/2, labelTop, sel);
@@ -374,15 +467,14 @@ static void drawTrashIcon() {
   bool sel = (selectedTarget == DRAG_TRASH);
 
   if (hoverTrash) {
-    tft->fillRoundRect(trashX - 2, trashY - 2, TRASH_ICON_WIDTH + 4, TRASH_ICON_HEIGHT + 4, 4, 0xE73C);
+    gfx->fillRoundRect(trashX - 2, trashY - 2, TRASH_ICON_WIDTH + 4, TRASH_ICON_HEIGHT + 4, 4, 0xE73C);
   }
 
-  tft->setSwapBytes(true);
-  tft->pushImage(trashX, trashY, TRASH_ICON_WIDTH, TRASH_ICON_HEIGHT, trash_icon_map, 0x0000);
+  blitIcon(trashX, trashY, TRASH_ICON_WIDTH, TRASH_ICON_HEIGHT, trash_icon_map);
 
   if (trash_deleted_count() > 0) {
-    tft->fillRect(trashX + 8, trashY + 6, 10, 6, TFT_WHITE);
-    tft->fillRect(trashX + 16, trashY + 14, 8, 6, TFT_WHITE);
+    gfx->fillRect(trashX + 8, trashY + 6, 10, 6, TFT_WHITE);
+    gfx->fillRect(trashX + 16, trashY + 14, 8, 6, TFT_WHITE);
   }
 
   int labelTop = trashY + TRASH_ICON_HEIGHT + LABEL_Y_GAP;
@@ -393,8 +485,7 @@ static void drawTrashIcon() {
 static void drawInternetIcon() {
   bool sel = (selectedTarget == DRAG_NET);
 
-  tft->setSwapBytes(true);
-  tft->pushImage(netX, netY, INTERNET_ICON_WIDTH, INTERNET_ICON_HEIGHT, internet_icon_map, 0x0000);
+  blitIcon(netX, netY, INTERNET_ICON_WIDTH, INTERNET_ICON_HEIGHT, internet_icon_map);
 
   int labelTop = netY + INTERNET_ICON_HEIGHT + LABEL_Y_GAP;
   drawLabelXP("Internet", netX + INTERNET_ICON_WIDTH/2, labelTop, sel);
@@ -404,8 +495,7 @@ static void drawInternetIcon() {
 static void drawNotesIcon() {
   bool sel = (selectedTarget == DRAG_NOTES);
 
-  tft->setSwapBytes(true);
-  tft->pushImage(notesX, notesY, NOTES_ICON_WIDTH, NOTES_ICON_HEIGHT, notes_icon_map, 0x0000);
+  blitIcon(notesX, notesY, NOTES_ICON_WIDTH, NOTES_ICON_HEIGHT, notes_icon_map);
 
   int labelTop = notesY + NOTES_ICON_HEIGHT + LABEL_Y_GAP;
   drawLabelXP("Notes", notesX + NOTES_ICON_WIDTH/2, labelTop, sel);
@@ -414,14 +504,8 @@ static void drawNotesIcon() {
 
 static int menuHeight() { return MENU_ITEM_H * MENU_ITEMS + 6; }
 
-static void menu_draw_xp(int activeItem) {
-  menuVisible = true;
-
+static void drawMenuXP(int activeItem) {
   int h = menuHeight();
-  if (menuX + MENU_W > SCREEN_W) menuX = SCREEN_W - MENU_W - 2;
-  if (menuY + h > SCREEN_H)      menuY = SCREEN_H - h - 2;
-  if (menuX < 0) menuX = 0;
-  if (menuY < 0) menuY = 0;
 
   uint16_t bg        = 0xEF7D;
   uint16_t borderDk  = 0x7BEF;
@@ -430,14 +514,14 @@ static void menu_draw_xp(int activeItem) {
   uint16_t hlBlue    = 0x1C9F;
   uint16_t hlBlue2   = 0x047F;
 
-  tft->fillRect(menuX, menuY, MENU_W, h, bg);
+  gfx->fillRect(menuX, menuY, MENU_W, h, bg);
 
-  tft->drawFastHLine(menuX, menuY, MENU_W, borderLt);
-  tft->drawFastVLine(menuX, menuY, h, borderLt);
-  tft->drawFastHLine(menuX, menuY + h - 1, MENU_W, borderDk);
-  tft->drawFastVLine(menuX + MENU_W - 1, menuY, h, borderDk);
+  gfx->drawFastHLine(menuX, menuY, MENU_W, borderLt);
+  gfx->drawFastVLine(menuX, menuY, h, borderLt);
+  gfx->drawFastHLine(menuX, menuY + h - 1, MENU_W, borderDk);
+  gfx->drawFastVLine(menuX + MENU_W - 1, menuY, h, borderDk);
 
-  tft->drawRect(menuX + 1, menuY + 1, MENU_W - 2, h - 2, innerDk);
+  gfx->drawRect(menuX + 1, menuY + 1, MENU_W - 2, h - 2, innerDk);
 
   const char* items[MENU_ITEMS] = {"Open", "Move", "Properties", "Cancel"};
 
@@ -448,18 +532,32 @@ static void menu_draw_xp(int activeItem) {
     int ih = MENU_ITEM_H;
 
     if (i == activeItem) {
-      tft->fillRect(ix, iy, iw, ih/2, hlBlue);
-      tft->fillRect(ix, iy + ih/2, iw, ih - ih/2, hlBlue2);
-      tft->drawRect(ix, iy, iw, ih, TFT_WHITE);
-      tft->setTextColor(TFT_WHITE, hlBlue2);
+      gfx->fillRect(ix, iy, iw, ih/2, hlBlue);
+      gfx->fillRect(ix, iy + ih/2, iw, ih - ih/2, hlBlue2);
+      gfx->drawRect(ix, iy, iw, ih, TFT_WHITE);
+      gfx->setTextColor(TFT_WHITE, hlBlue2);
     } else {
-      tft->setTextColor(TFT_BLACK, bg);
+      gfx->setTextColor(TFT_BLACK, bg);
     }
 
-    tft->drawString(items[i], menuX + 12, iy + 3, 2);
+    gfx->drawString(items[i], menuX + 12, iy + 3, 2);
   }
 }
 
+// Shows the context menu (or moves its highlight); painted on the next flush.
+static void menu_draw_xp(int activeItem) {
+  menuVisible = true;
+  menuActiveItem = activeItem;
+
+  int h = menuHeight();
+  if (menuX + MENU_W > SCREEN_W) menuX = SCREEN_W - MENU_W - 2;
+  if (menuY + h > SCREEN_H)      menuY = SCREEN_H - h - 2;
+  if (menuX < 0) menuX = 0;
+  if (menuY < 0) menuY = 0;
+
+  markDirty(menuX, menuY, MENU_W, h);
+}
+
 static int menu_hitItem(int x, int y) {
   if (!menuVisible) return -1;
   int h = menuHeight();
@@ -471,9 +569,8 @@ static int menu_hitItem(int x, int y) {
   return idx;
 }
 
-static void redrawSceneRect(int x,int y,int w,int h) {
-  redrawWallpaperRect(x,y,w,h);
-
+// Everything above the wallpaper that touches (x,y,w,h), back to front.
+static void drawSceneRect(int x,int y,int w,int h) {
   Rect ar = aiRect();
   Rect pr = paintRect();
   Rect tr = trashRect();
@@ -491,7 +588,7 @@ static void redrawSceneRect(int x,int y,int w,int h) {
   if (menuVisible) {
     int mh = menuHeight();
     if (rectIntersects(x,y,w,h, menuX,menuY, MENU_W,mh)) {
-      menu_draw_xp(menuActiveItem);
+      drawMenuXP(menuActiveItem);
     }
   }
 
@@ -501,20 +598,84 @@ static void redrawSceneRect(int x,int y,int w,int h) {
   }
 
   if (startMenuVisible) {
-    int h = START_MENU_ITEMS * START_MENU_ITEM_H + 6;
-    int sx = startMenuX;
-    int sy = startMenuY - h;
-    if (sy < 0) sy = 0;
-    if (rectIntersects(x,y,w,h, sx, sy, START_MENU_W, h)) {
+    Rect sr = startMenuRect();
+    if (rectIntersects(x,y,w,h, sr.x, sr.y, sr.w, sr.h)) {
       drawStartMenu(startMenuActive);
     }
   }
 }
 
-static void animateDeleteRect(const Rect& r) {
-  // Subtle fade: just clear once to avoid visible blinking.
-  redrawWallpaperRect(r.x, r.y, r.w, r.h);
+static void composeTile(int tx, int ty, int tw, int th) {
+  tileX = tx; tileY = ty; tileW = tw; tileH = th;
+  composing = true;
+  gfx = scratch;
+
+  paintWallpaper(tx, ty, tw, th);
+
+  // Datum at (-tx,-ty): the scene is drawn in screen coordinates and
+  // clipped to the tile.
+  scratch->setViewport(-tx, -ty, tx + tw, ty + th, true);
+  drawSceneRect(tx, ty, tw, th);
+  scratch->resetViewport();
+
+  composing = false;
+  gfx = tft;
+
+  // Pack the rows so the tile is one contiguous block for pushImage.
+  uint16_t* buf = (uint16_t*)scratch->getPointer();
+  if (tw < SCRATCH_W) {
+    for (int yy = 1; yy < th; yy++) {
+      memmove(buf + yy * tw, buf + yy * SCRATCH_W, tw * sizeof(uint16_t));
+    }
+  }
+
+  // Sprite pixels are already in SPI byte order.
+  bool swap = tft->getSwapBytes();
+  tft->setSwapBytes(false);
+  tft->pushImage(tx, ty, tw, th, buf);
+  tft->setSwapBytes(swap);
+}
+
+static bool ensureScratch() {
+  if (scratch && scratch->created()) return true;
+  if (scratchFailed || !tft) return false;
+  if (!scratch) scratch = new TFT_eSprite(tft);
+  scratch->setColorDepth(16);
+  if (!scratch->createSprite(SCRATCH_W, SCRATCH_H)) {
+    scratchFailed = true;
+    return false;
+  }
+  return true;
 }
+
+static void flushDamage() {
+  if (!tft || damageCount == 0) return;
+
+  bool useScratch = ensureScratch();
+
+  for (int i = 0; i < damageCount; i++) {
+    const Rect& r = damage[i];
+
+    if (!useScratch) {
+      // Low-memory fallback: draw in place, back to front.
+      gfx = tft;
+      paintWallpaper(r.x, r.y, r.w, r.h);
+      drawSceneRect(r.x, r.y, r.w, r.h);
+      continue;
+    }
+
+    for (int ty = r.y; ty < r.y + r.h; ty += SCRATCH_H) {
+      int th = min(SCRATCH_H, r.y + r.h - ty);
+      for (int tx = r.x; tx < r.x + r.w; tx += SCRATCH_W) {
+        int tw = min(SCRATCH_W, r.x + r.w - tx);
+        composeTile(tx, ty, tw, th);
+      }
+    }
+  }
+
+  damageCount = 0;
+}
+
 static void menu_hide() {
   if (!menuVisible) return;
   int h = menuHeight();
@@ -524,7 +685,7 @@ static void menu_hide() {
   menuActiveItem = -1;
   menuFor = MENU_NONE;
 
-  redrawSceneRect(menuX, menuY, MENU_W, h);
+  markDirty(menuX, menuY, MENU_W, h);
 }
 
 static void setSelected(DragTarget t) {
@@ -535,39 +696,38 @@ static void setSelected(DragTarget t) {
 
   selectedTarget = t;
 
-  if (oldR.w > 0) redrawSceneRect(oldR.x, oldR.y, oldR.w, oldR.h);
-  if (newR.w > 0) redrawSceneRect(newR.x, newR.y, newR.w, newR.h);
+  if (oldR.w > 0) markDirty(oldR.x, oldR.y, oldR.w, oldR.h);
+  if (newR.w > 0) markDirty(newR.x, newR.y, newR.w, newR.h);
 }
 
-void desktop_init(TFT_eSPI* display) {
+void desktop_init(Display* display) {
   tft = display;
+  gfx = display;
+}
+
+void desktop_close() {
+  if (scratch) scratch->deleteSprite();
+  // Memory may be short now and not later.
+  scratchFailed = false;
 }
 
 void desktop_draw() {
   if (!tft) return;
 
-  tft->fillScreen(TFT_BLACK);  // ✅ clears leftover UI like Wi-Fi back button
-
-  tft->setSwapBytes(true);
-  tft->pushImage(0, 0, WALLPAPER_WIDTH, WALLPAPER_HEIGHT, wallpaper_map);
-
-  if (!trash_is_deleted(ICON_AI)) drawAIIcon();
-  if (!trash_is_deleted(ICON_PAINT)) drawPaintIcon();
-  drawTrashIcon();
-  if (!trash_is_deleted(ICON_INTERNET)) drawInternetIcon();
-  if (!trash_is_deleted(ICON_NOTES)) drawNotesIcon();
-  if (!trash_is_deleted(ICON_WIFI)) drawWifiIcon();
-
-  drawTaskbar();
-
-  if (menuVisible) menu_draw_xp(menuActiveItem);
-  if (startMenuVisible) drawStartMenu(startMenuActive);
+  // The whole screen is composed, which also covers leftover UI such as
+  // the Wi-Fi back button.
+  damageCount = 0;
+  markDirty(0, 0, SCREEN_W, SCREEN_H);
+  flushDamage();
 }
 
 void desktop_tick() {
   uint32_t now = millis();
   if (now - lastStatusTick > 900) {
-    system_ui_tick(SCREEN_W - 92, START_Y + 1, 0x047F);
+    if (system_ui_status_stale()) {
+      markDirty(STATUS_X, STATUS_Y, STATUS_W, STATUS_H);
+      flushDamage();
+    }
     lastStatusTick = now;
   }
 }
@@ -576,7 +736,8 @@ void desktop_cursor_move(int x, int y) {
   if (!tft) return;
   if (x < 0 || y < 0 || x >= SCREEN_W || y >= SCREEN_H) return;
   if (cursorX >= 0 && cursorY >= 0) {
-    redrawSceneRect(cursorX - 3, cursorY - 3, 7, 7);
+    markDirty(cursorX - 3, cursorY - 3, 7, 7);
+    flushDamage();
   }
   cursorX = x;
   cursorY = y;
@@ -587,7 +748,8 @@ void desktop_cursor_move(int x, int y) {
 void desktop_cursor_hide() {
   if (!tft) return;
   if (cursorX >= 0 && cursorY >= 0) {
-    redrawSceneRect(cursorX - 3, cursorY - 3, 7, 7);
+    markDirty(cursorX - 3, cursorY - 3, 7, 7);
+    flushDamage();
   }
   cursorX = -1;
   cursorY = -1;
@@ -600,7 +762,8 @@ void desktop_mouse_indicator(bool on) {
   if (on) {
     tft->fillRect(2, 2, 6, 6, TFT_WHITE);
   } else {
-    redrawSceneRect(2, 2, 6, 6);
+    markDirty(2, 2, 6, 6);
+    flushDamage();
   }
 }
 
@@ -678,19 +841,18 @@ static DragTarget hitTestTarget(int x, int y, bool* onIconBody) {
   return DRAG_NONE;
 }
 
-DesktopAction desktop_handleTouch(bool pressed, bool lastPressed, int x, int y) {
-  if (!tft) return DESKTOP_NONE;
+static DesktopAction handleTouch(bool pressed, bool lastPressed, int x, int y) {
 
   if (!pressed && lastPressed && startPressed) {
     startPressed = false;
-    drawTaskbar();
+    invalidateTaskbar();
   }
 
   if (mouseMode && !pressed) {
     bool h = inRect(x, y, START_X, START_Y, START_W, START_H);
     if (h != startHover) {
       startHover = h;
-      drawTaskbar();
+      invalidateTaskbar();
     }
   }
 
@@ -699,7 +861,7 @@ DesktopAction desktop_handleTouch(bool pressed, bool lastPressed, int x, int y)
       int hit = startMenuHitItem(x, y);
       if (hit != startMenuActive) {
         startMenuActive = hit;
-        drawStartMenu(startMenuActive);
+        showStartMenu();
       }
     }
     if (pressed && !lastPressed) {
@@ -708,14 +870,14 @@ DesktopAction desktop_handleTouch(bool pressed, bool lastPressed, int x, int y)
         hideStartMenu();
         return DESKTOP_NONE;
       }
-      drawStartMenu(startMenuActive);
+      showStartMenu();
       return DESKTOP_NONE;
     }
     if (pressed && lastPressed) {
       int hit = startMenuHitItem(x, y);
       if (hit != startMenuActive) {
         startMenuActive = hit;
-        drawStartMenu(startMenuActive);
+        showStartMenu();
       }
       return DESKTOP_NONE;
     }
@@ -791,10 +953,9 @@ if (item == 1) {
       startMenuX = START_X;
       startMenuY = START_Y;
       startPressed = true;
-      drawTaskbar();
-      startMenuVisible = !startMenuVisible;
-      if (startMenuVisible) drawStartMenu(startMenuActive);
-      else hideStartMenu();
+      invalidateTaskbar();
+      if (startMenuVisible) hideStartMenu();
+      else showStartMenu();
       return DESKTOP_NONE;
     }
 
@@ -880,8 +1041,8 @@ if (item == 1) {
       }
 
       Rect newR = rectForTarget(dragTarget);
-      redrawSceneRect(oldR.x, oldR.y, oldR.w, oldR.h);
-      redrawSceneRect(newR.x, newR.y, newR.w, newR.h);
+      markDirty(oldR.x, oldR.y, oldR.w, oldR.h);
+      markDirty(newR.x, newR.y, newR.w, newR.h);
     }
 
     if (dragTarget != DRAG_TRASH) {
@@ -889,7 +1050,7 @@ if (item == 1) {
       bool nowHover = inRect(x, y, tr.x, tr.y, tr.w, tr.h);
       if (nowHover != hoverTrash) {
         hoverTrash = nowHover;
-        redrawSceneRect(tr.x, tr.y, tr.w, tr.h);
+        markDirty(tr.x, tr.y, tr.w, tr.h);
       }
     }
 
@@ -918,7 +1079,6 @@ if (!moved && heldMs < HOLD_TO_DRAG_MS) {
 
         menuFingerDown = false;
         menuActiveItem = -1;
-        menuVisible = true;
         menu_draw_xp(menuActiveItem);
       }
     }
@@ -927,21 +1087,20 @@ if (!moved && heldMs < HOLD_TO_DRAG_MS) {
       Rect tr = trashRect();
       if (inRect(x, y, tr.x, tr.y, tr.w, tr.h)) {
         Rect dr = rectForTarget(dragTarget);
-        animateDeleteRect(dr);
         if (dragTarget == DRAG_AI) trash_delete_icon(ICON_AI);
         if (dragTarget == DRAG_PAINT) trash_delete_icon(ICON_PAINT);
         if (dragTarget == DRAG_NET) trash_delete_icon(ICON_INTERNET);
         if (dragTarget == DRAG_NOTES) trash_delete_icon(ICON_NOTES);
         if (dragTarget == DRAG_WIFI) trash_delete_icon(ICON_WIFI);
-        redrawSceneRect(dr.x, dr.y, dr.w, dr.h);
-        redrawSceneRect(tr.x, tr.y, tr.w, tr.h);
+        markDirty(dr.x, dr.y, dr.w, dr.h);
+        markDirty(tr.x, tr.y, tr.w, tr.h);
       }
     }
 
     if (hoverTrash) {
       hoverTrash = false;
       Rect tr = trashRect();
-      redrawSceneRect(tr.x, tr.y, tr.w, tr.h);
+      markDirty(tr.x, tr.y, tr.w, tr.h);
     }
 
     dragTarget = DRAG_NONE;
@@ -951,3 +1110,11 @@ if (!moved && heldMs < HOLD_TO_DRAG_MS) {
 
   return DESKTOP_NONE;
 }
+
+DesktopAction desktop_handleTouch(bool pressed, bool lastPressed, int x, int y) {
+  if (!tft) return DESKTOP_NONE;
+
+  DesktopAction act = handleTouch(pressed, lastPressed, x, y);
+  flushDamage();
+  return act;
+}
@@ -1,6 +1,6 @@
 #pragma once
 #include <Arduino.h>
-#include <TFT_eSPI.h>
+#include "display.h"
 
 enum DesktopAction {
   DESKTOP_NONE = 0,
@@ -22,9 +22,12 @@ enum DesktopAction {
   DESKTOP_PROPERTIES_SETTINGS
 };
 
-void desktop_init(TFT_eSPI* display);
+void desktop_init(Display* display);
 void desktop_draw();
 void desktop_tick();
+// Another app comes to the front: the compositor's sprite is given back
+// until the next desktop_draw().
+void desktop_close();
 void desktop_set_mouse_mode(bool on);
 
 DesktopAction desktop_handleTouch(bool pressed, bool lastPressed, int x, int y);
@@ -0,0 +1,322 @@
+#include "display.h"
+#include "mirror.h"
+
+static const char* SCOPE_NAMES[DS_SCOPE_COUNT] = {
+  "system", "desktop", "chat", "paint", "wifi", "internet", "notes", "trash", "settings", "cursor",
+  "mirror"
+};
+
+static const char* OP_NAMES[DS_OP_COUNT] = {
+  "fillRect", "drawPixel", "pushImage", "drawString", "readPixel"
+};
+
+static DisplayStat stats[DS_SCOPE_COUNT][DS_OP_COUNT];
+static DisplayScope curScope = DS_SCOPE_SYSTEM;
+
+void display_stats_set_scope(DisplayScope scope) {
+  if (scope < DS_SCOPE_COUNT) curScope = scope;
+}
+
+DisplayScope display_stats_scope() {
+  return curScope;
+}
+
+const DisplayStat* display_stats_get(DisplayScope scope) {
+  if (scope >= DS_SCOPE_COUNT) return nullptr;
+  return stats[scope];
+}
+
+void display_stats_reset() {
+  memset(stats, 0, sizeof(stats));
+}
+
+void display_stats_print(Print& out) {
+  out.println("scope     op            calls     pixels   bus_bytes      us");
+  for (int s = 0; s < DS_SCOPE_COUNT; s++) {
+    DisplayStat sum = {0, 0, 0, 0};
+    for (int o = 0; o < DS_OP_COUNT; o++) {
+      const DisplayStat& st = stats[s][o];
+      if (st.calls == 0) continue;
+      out.printf("%-9s %-11s %8lu %10llu %11llu %7llu\n", SCOPE_NAMES[s], OP_NAMES[o],
+                 (unsigned long)st.calls, (unsigned long long)st.pixels,
+                 (unsigned long long)st.busBytes, (unsigned long long)st.us);
+      sum.calls += st.calls;
+      sum.pixels += st.pixels;
+      sum.busBytes += st.busBytes;
+      sum.us += st.us;
+    }
+    if (sum.calls == 0) continue;
+    out.printf("%-9s %-11s %8lu %10llu %11llu %7llu\n", SCOPE_NAMES[s], "= total",
+               (unsigned long)sum.calls, (unsigned long long)sum.pixels,
+               (unsigned long long)sum.busBytes, (unsigned long long)sum.us);
+  }
+}
+
+#if DISPLAY_STATS
+
+// ILI9341 cost model: a CASET/PASET/RAMWR window is 11 bytes on the wire,
+// then 2 bytes per pixel written. A read adds RAMRD, a dummy byte and
+// 3 bytes (18 bit) per pixel.
+static const uint32_t WINDOW_BYTES = 11;
+static const uint32_t READ_PIXEL_BYTES = WINDOW_BYTES + 2 + 3;
+
+// TFT_eSPI draws text and shapes through the same virtual primitives;
+// only the outermost call the app made is counted.
+static int depth = 0;
+
+namespace {
+struct OpTimer {
+  DisplayOp op;
+  uint32_t pixels;
+  uint32_t bytes;
+  uint32_t t0;
+  bool outer;
+
+  OpTimer(DisplayOp o, uint32_t px, uint32_t b)
+    : op(o), pixels(px), bytes(b), t0(micros()), outer(depth++ == 0) {}
+
+  ~OpTimer() {
+    depth--;
+    if (!outer) return;
+    DisplayStat& st = stats[curScope][op];
+    st.calls++;
+    st.pixels += pixels;
+    st.busBytes += bytes;
+    st.us += (uint32_t)(micros() - t0);
+  }
+};
+}
+
+// The mirror also only wants the outermost call, but it sees more of them
+// (outlines, shapes) than are counted, so it nests separately.
+static int mirrorDepth = 0;
+
+namespace {
+struct MirrorOp {
+  bool outer;
+  MirrorOp() : outer(mirrorDepth++ == 0 && mirror_active()) {}
+  ~MirrorOp() { mirrorDepth--; }
+};
+}
+
+static uint32_t clippedArea(int32_t x, int32_t y, int32_t w, int32_t h, int32_t sw, int32_t sh) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > sw) w = sw - x;
+  if (y + h > sh) h = sh - y;
+  if (w <= 0 || h <= 0) return 0;
+  return (uint32_t)w * (uint32_t)h;
+}
+
+static uint32_t writeBytes(uint32_t pixels) {
+  return pixels ? WINDOW_BYTES + 2 * pixels : 0;
+}
+
+void StatsTFT::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  uint32_t px = clippedArea(x, y, w, h, width(), height());
+  OpTimer t(DS_OP_FILL_RECT, px, writeBytes(px));
+  MirrorOp m;
+  if (m.outer) mirror_fill(x, y, w, h, (uint16_t)color);
+  TFT_eSPI::fillRect(x, y, w, h, color);
+}
+
+void StatsTFT::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  uint32_t px = clippedArea(x, y, 1, 1, width(), height());
+  OpTimer t(DS_OP_DRAW_PIXEL, px, writeBytes(px));
+  MirrorOp m;
+  if (m.outer) mirror_fill(x, y, 1, 1, (uint16_t)color);
+  TFT_eSPI::drawPixel(x, y, color);
+}
+
+void StatsTFT::fillScreen(uint32_t color) {
+  MirrorOp m;
+  if (m.outer) mirror_fill(0, 0, width(), height(), (uint16_t)color);
+  TFT_eSPI::fillScreen(color);
+}
+
+void StatsTFT::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) mirror_fill(x, y, w, 1, (uint16_t)color);
+  TFT_eSPI::drawFastHLine(x, y, w, color);
+}
+
+void StatsTFT::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) mirror_fill(x, y, 1, h, (uint16_t)color);
+  TFT_eSPI::drawFastVLine(x, y, h, color);
+}
+
+void StatsTFT::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) {
+    mirror_fill(x, y, w, 1, (uint16_t)color);
+    mirror_fill(x, y + h - 1, w, 1, (uint16_t)color);
+    mirror_fill(x, y + 1, 1, h - 2, (uint16_t)color);
+    mirror_fill(x + w - 1, y + 1, 1, h - 2, (uint16_t)color);
+  }
+  TFT_eSPI::drawRect(x, y, w, h, color);
+}
+
+// The rest do not say pixel for pixel what they draw: the mirror reads
+// their bounding box back.
+static void boxDirty(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+  if (x0 > x1) std::swap(x0, x1);
+  if (y0 > y1) std::swap(y0, y1);
+  mirror_dirty(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+}
+
+void StatsTFT::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) boxDirty(x0, y0, x1, y1);
+  TFT_eSPI::drawLine(x0, y0, x1, y1, color);
+}
+
+void StatsTFT::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) mirror_dirty(x, y, w, h);
+  TFT_eSPI::drawRoundRect(x, y, w, h, r, color);
+}
+
+void StatsTFT::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) mirror_dirty(x, y, w, h);
+  TFT_eSPI::fillRoundRect(x, y, w, h, r, color);
+}
+
+void StatsTFT::drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) boxDirty(x - r, y - r, x + r, y + r);
+  TFT_eSPI::drawCircle(x, y, r, color);
+}
+
+void StatsTFT::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) boxDirty(x - r, y - r, x + r, y + r);
+  TFT_eSPI::fillCircle(x, y, r, color);
+}
+
+void StatsTFT::drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) boxDirty(min(x0, min(x1, x2)), min(y0, min(y1, y2)), max(x0, max(x1, x2)), max(y0, max(y1, y2)));
+  TFT_eSPI::drawTriangle(x0, y0, x1, y1, x2, y2, color);
+}
+
+void StatsTFT::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+  MirrorOp m;
+  if (m.outer) boxDirty(min(x0, min(x1, x2)), min(y0, min(y1, y2)), max(x0, max(x1, x2)), max(y0, max(y1, y2)));
+  TFT_eSPI::fillTriangle(x0, y0, x1, y1, x2, y2, color);
+}
+
+void StatsTFT::drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size) {
+  MirrorOp m;
+  if (m.outer) {
+    int32_t s = size ? size : 1;
+    mirror_dirty(x, y, 6 * s, 8 * s);
+  }
+  TFT_eSPI::drawChar(x, y, c, color, bg, size);
+}
+
+int16_t StatsTFT::drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font) {
+  MirrorOp m;
+  if (m.outer) {
+    char s[2] = {(char)uniCode, 0};
+    mirror_dirty(x, y, textWidth(s, font), fontHeight(font));
+  }
+  return TFT_eSPI::drawChar(uniCode, x, y, font);
+}
+
+// Keyed pushes are charged as if every pixel were written; TFT_eSPI splits
+// them into runs, so this is an upper bound.
+void StatsTFT::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data) {
+  uint32_t px = clippedArea(x, y, w, h, width(), height());
+  OpTimer t(DS_OP_PUSH_IMAGE, px, writeBytes(px));
+  MirrorOp m;
+  if (m.outer) mirror_image(x, y, w, h, data, getSwapBytes());
+  TFT_eSPI::pushImage(x, y, w, h, data);
+}
+
+void StatsTFT::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+  uint32_t px = clippedArea(x, y, w, h, width(), height());
+  OpTimer t(DS_OP_PUSH_IMAGE, px, writeBytes(px));
+  MirrorOp m;
+  if (m.outer) mirror_image(x, y, w, h, data, getSwapBytes());
+  TFT_eSPI::pushImage(x, y, w, h, data);
+}
+
+// Keyed pixels leave the screen as it was, which the mirror cannot tell
+// from the data, so keyed pushes are read back.
+void StatsTFT::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data, uint16_t transparent) {
+  uint32_t px = clippedArea(x, y, w, h, width(), height());
+  OpTimer t(DS_OP_PUSH_IMAGE, px, writeBytes(px));
+  MirrorOp m;
+  if (m.outer) mirror_dirty(x, y, w, h);
+  TFT_eSPI::pushImage(x, y, w, h, data, transparent);
+}
+
+void StatsTFT::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, uint16_t transparent) {
+  uint32_t px = clippedArea(x, y, w, h, width(), height());
+  OpTimer t(DS_OP_PUSH_IMAGE, px, writeBytes(px));
+  MirrorOp m;
+  if (m.outer) mirror_dirty(x, y, w, h);
+  TFT_eSPI::pushImage(x, y, w, h, data, transparent);
+}
+
+// Text is estimated as one window per glyph covering the string's box.
+static uint32_t textBytes(const char* s, uint32_t pixels) {
+  uint32_t glyphs = s ? (uint32_t)strlen(s) : 0;
+  return pixels ? glyphs * WINDOW_BYTES + 2 * pixels : 0;
+}
+
+// The box a string covers when drawn at (x, y) with the given datum.
+// Baseline datums are treated as bottom ones with room below for
+// descenders.
+static void textDirty(StatsTFT* t, const char* s, int32_t x, int32_t y, uint8_t font, uint8_t datum) {
+  int32_t w = t->textWidth(s, font);
+  int32_t h = t->fontHeight(font);
+  int32_t col = datum % 3, row = datum / 3;
+  x -= col * w / 2;
+  if (row >= 3) {
+    y -= h;
+    h *= 2;
+  } else {
+    y -= row * h / 2;
+  }
+  mirror_dirty(x, y, w, h);
+}
+
+int16_t StatsTFT::drawString(const char* s, int32_t x, int32_t y, uint8_t font) {
+  uint32_t px = (uint32_t)textWidth(s, font) * (uint32_t)fontHeight(font);
+  OpTimer t(DS_OP_DRAW_STRING, px, textBytes(s, px));
+  MirrorOp m;
+  if (m.outer) textDirty(this, s, x, y, font, textdatum);
+  return TFT_eSPI::drawString(s, x, y, font);
+}
+
+int16_t StatsTFT::drawCentreString(const char* s, int32_t x, int32_t y, uint8_t font) {
+  uint32_t px = (uint32_t)textWidth(s, font) * (uint32_t)fontHeight(font);
+  OpTimer t(DS_OP_DRAW_STRING, px, textBytes(s, px));
+  MirrorOp m;
+  if (m.outer) textDirty(this, s, x, y, font, TC_DATUM);
+  return TFT_eSPI::drawCentreString(s, x, y, font);
+}
+
+int16_t StatsTFT::drawRightString(const char* s, int32_t x, int32_t y, uint8_t font) {
+  uint32_t px = (uint32_t)textWidth(s, font) * (uint32_t)fontHeight(font);
+  OpTimer t(DS_OP_DRAW_STRING, px, textBytes(s, px));
+  MirrorOp m;
+  if (m.outer) textDirty(this, s, x, y, font, TR_DATUM);
+  return TFT_eSPI::drawRightString(s, x, y, font);
+}
+
+uint16_t StatsTFT::readPixel(int32_t x, int32_t y) {
+  OpTimer t(DS_OP_READ_PIXEL, 1, READ_PIXEL_BYTES);
+  return TFT_eSPI::readPixel(x, y);
+}
+
+void StatsTFT::readRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data) {
+  uint32_t px = clippedArea(x, y, w, h, width(), height());
+  OpTimer t(DS_OP_READ_PIXEL, px, px ? WINDOW_BYTES + 2 + 3 * px : 0);
+  TFT_eSPI::readRect(x, y, w, h, data);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+// Display access with per-app draw accounting.
+//
+// Every fillRect / drawPixel / pushImage / drawString / readPixel goes
+// through StatsTFT, which adds calls, pixels, estimated SPI bytes and
+// elapsed microseconds to the scope that is currently active (set from
+// loop() before each app runs). StatsTFT also hands each draw call to the
+// screen mirror (mirror.h). Build with -DDISPLAY_STATS=0 to compile the
+// plain TFT_eSPI instead.
+
+#ifndef DISPLAY_STATS
+#define DISPLAY_STATS 1
+#endif
+
+enum DisplayScope : uint8_t {
+  DS_SCOPE_SYSTEM = 0,   // boot, status bar, anything outside an app
+  DS_SCOPE_DESKTOP,
+  DS_SCOPE_CHAT,
+  DS_SCOPE_PAINT,
+  DS_SCOPE_WIFI,
+  DS_SCOPE_INTERNET,
+  DS_SCOPE_NOTES,
+  DS_SCOPE_TRASH,
+  DS_SCOPE_SETTINGS,
+  DS_SCOPE_CURSOR,       // mouse pointer save/restore
+  DS_SCOPE_MIRROR,       // read-back for the screen mirror
+  DS_SCOPE_COUNT
+};
+
+enum DisplayOp : uint8_t {
+  DS_OP_FILL_RECT = 0,
+  DS_OP_DRAW_PIXEL,
+  DS_OP_PUSH_IMAGE,
+  DS_OP_DRAW_STRING,
+  DS_OP_READ_PIXEL,
+  DS_OP_COUNT
+};
+
+struct DisplayStat {
+  uint32_t calls;
+  uint64_t pixels;
+  uint64_t busBytes;
+  uint64_t us;
+};
+
+void display_stats_set_scope(DisplayScope scope);
+DisplayScope display_stats_scope();
+const DisplayStat* display_stats_get(DisplayScope scope);   // DS_OP_COUNT entries
+void display_stats_reset();
+void display_stats_print(Print& out);
+
+#if DISPLAY_STATS
+
+class StatsTFT : public TFT_eSPI {
+public:
+  StatsTFT(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT) : TFT_eSPI(w, h) {}
+
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) override;
+  void drawPixel(int32_t x, int32_t y, uint32_t color) override;
+
+  // Not counted; seen only by the mirror.
+  void fillScreen(uint32_t color);
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) override;
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) override;
+  void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) override;
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+  void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+  void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+  void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+  void drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size) override;
+  int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font) override;
+
+  using TFT_eSPI::pushImage;
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data, uint16_t transparent);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, uint16_t transparent);
+
+  int16_t drawString(const char* s, int32_t x, int32_t y, uint8_t font);
+  int16_t drawString(const char* s, int32_t x, int32_t y) { return drawString(s, x, y, textfont); }
+  int16_t drawString(const String& s, int32_t x, int32_t y, uint8_t font) { return drawString(s.c_str(), x, y, font); }
+  int16_t drawString(const String& s, int32_t x, int32_t y) { return drawString(s.c_str(), x, y, textfont); }
+  int16_t drawCentreString(const char* s, int32_t x, int32_t y, uint8_t font);
+  int16_t drawCentreString(const String& s, int32_t x, int32_t y, uint8_t font) { return drawCentreString(s.c_str(), x, y, font); }
+  int16_t drawRightString(const char* s, int32_t x, int32_t y, uint8_t font);
+  int16_t drawRightString(const String& s, int32_t x, int32_t y, uint8_t font) { return drawRightString(s.c_str(), x, y, font); }
+
+  uint16_t readPixel(int32_t x, int32_t y);
+  void readRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data);
+};
+
+typedef StatsTFT Display;
+
+#else
+
+typedef TFT_eSPI Display;
+
+#endif
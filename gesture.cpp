@@ -0,0 +1,118 @@
+#include "gesture.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Farther than this from the press point and it is a drag, not a tap.
+static const int TAP_SLOP = 6;
+static const uint32_t LONG_PRESS_MS = 600;
+static const uint32_t DOUBLE_TAP_MS = 300;
+static const int DOUBLE_TAP_SLOP = 20;
+// Velocity is measured over the samples this close to the release; a
+// finger that stopped before lifting does not fling.
+static const uint32_t VELOCITY_WINDOW_MS = 80;
+static const float FLING_MIN_V = 150.0f;
+
+void gesture_reset(GestureTracker* g) {
+  memset(g, 0, sizeof(*g));
+}
+
+bool gesture_active(const GestureTracker* g) { return g->down; }
+
+static void addSample(GestureTracker* g, int x, int y, uint32_t ms) {
+  g->sx[g->sampleHead] = (int16_t)x;
+  g->sy[g->sampleHead] = (int16_t)y;
+  g->sms[g->sampleHead] = ms;
+  g->sampleHead = (g->sampleHead + 1) % GESTURE_SAMPLES;
+  if (g->sampleCount < GESTURE_SAMPLES) g->sampleCount++;
+}
+
+// Velocity between the newest sample and the oldest one inside the
+// window before `ms`.
+static void releaseVelocity(const GestureTracker* g, uint32_t ms, float* vx, float* vy) {
+  *vx = *vy = 0;
+  if (g->sampleCount < 2) return;
+  int newest = (g->sampleHead + GESTURE_SAMPLES - 1) % GESTURE_SAMPLES;
+  if (ms - g->sms[newest] > VELOCITY_WINDOW_MS) return;
+  int oldest = newest;
+  for (int k = 1; k < g->sampleCount; k++) {
+    int i = (newest + GESTURE_SAMPLES - k) % GESTURE_SAMPLES;
+    if (ms - g->sms[i] > VELOCITY_WINDOW_MS) break;
+    oldest = i;
+  }
+  uint32_t dt = g->sms[newest] - g->sms[oldest];
+  if (dt == 0) return;
+  *vx = (g->sx[newest] - g->sx[oldest]) * 1000.0f / dt;
+  *vy = (g->sy[newest] - g->sy[oldest]) * 1000.0f / dt;
+}
+
+static bool report(GestureEvent* out, GestureType type, int x, int y) {
+  memset(out, 0, sizeof(*out));
+  out->type = type;
+  out->x = (int16_t)x;
+  out->y = (int16_t)y;
+  return true;
+}
+
+bool gesture_feed(GestureTracker* g, bool pressed, int x, int y, uint32_t ms, GestureEvent* out) {
+  if (pressed && !g->down) {
+    g->down = true;
+    g->dragging = false;
+    g->longFired = false;
+    g->startX = g->lastX = (int16_t)x;
+    g->startY = g->lastY = (int16_t)y;
+    g->downMs = ms;
+    g->sampleCount = 0;
+    addSample(g, x, y, ms);
+    return false;
+  }
+  if (!g->down) return false;
+
+  if (pressed) {
+    if (x != g->lastX || y != g->lastY) addSample(g, x, y, ms);
+
+    if (!g->dragging && !g->longFired &&
+        (abs(x - g->startX) > TAP_SLOP || abs(y - g->startY) > TAP_SLOP)) {
+      g->dragging = true;
+      // The first report covers the slop too, so content stays under
+      // the finger.
+      g->lastX = g->startX;
+      g->lastY = g->startY;
+    }
+    if (g->dragging) {
+      if (x == g->lastX && y == g->lastY) return false;
+      report(out, GESTURE_DRAG, x, y);
+      out->dx = (int16_t)(x - g->lastX);
+      out->dy = (int16_t)(y - g->lastY);
+      g->lastX = (int16_t)x;
+      g->lastY = (int16_t)y;
+      return true;
+    }
+    if (!g->longFired && ms - g->downMs >= LONG_PRESS_MS) {
+      g->longFired = true;
+      return report(out, GESTURE_LONG_PRESS, g->startX, g->startY);
+    }
+    return false;
+  }
+
+  // Released.
+  g->down = false;
+  if (g->dragging) {
+    float vx, vy;
+    releaseVelocity(g, ms, &vx, &vy);
+    bool fling = vx * vx + vy * vy >= FLING_MIN_V * FLING_MIN_V;
+    report(out, fling ? GESTURE_FLING : GESTURE_DRAG_END, x, y);
+    out->vx = vx;
+    out->vy = vy;
+    return true;
+  }
+  if (g->longFired) return false;
+
+  bool dbl = g->tapMs && ms - g->tapMs <= DOUBLE_TAP_MS &&
+             abs(g->startX - g->tapX) <= DOUBLE_TAP_SLOP &&
+             abs(g->startY - g->tapY) <= DOUBLE_TAP_SLOP;
+  // A double tap does not start the next one.
+  g->tapMs = dbl ? 0 : ms;
+  g->tapX = g->startX;
+  g->tapY = g->startY;
+  return report(out, dbl ? GESTURE_DOUBLE_TAP : GESTURE_TAP, g->startX, g->startY);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+// Turns the pointer states an app's handleTouch() sees into gestures.
+//
+// Feed every call for a region, from the press that starts in it until
+// the release: the tracker reports a drag once the finger left the tap
+// slop, then a fling (or a plain drag end) on release with the finger's
+// velocity over its last few samples. A press that stays put is a tap,
+// a second one shortly after is a double tap, and one held long enough is
+// a long press (reported while still held; its release reports nothing).
+
+enum GestureType : uint8_t {
+  GESTURE_NONE,
+  GESTURE_TAP,
+  GESTURE_DOUBLE_TAP,
+  GESTURE_LONG_PRESS,
+  GESTURE_DRAG,         // dx/dy: movement since the previous report
+  GESTURE_DRAG_END,     // released too slowly to fling
+  GESTURE_FLING,        // vx/vy: release velocity in px/s
+};
+
+struct GestureEvent {
+  GestureType type;
+  int16_t x, y;         // where the pointer is now (tap: where it went down)
+  int16_t dx, dy;
+  float vx, vy;
+};
+
+#define GESTURE_SAMPLES 6
+
+struct GestureTracker {
+  bool down;
+  bool dragging;
+  bool longFired;
+  int16_t startX, startY;
+  int16_t lastX, lastY;
+  uint32_t downMs;
+  // Last tap, to spot a double tap.
+  uint32_t tapMs;
+  int16_t tapX, tapY;
+  // Recent points for the release velocity (a ring).
+  int16_t sx[GESTURE_SAMPLES], sy[GESTURE_SAMPLES];
+  uint32_t sms[GESTURE_SAMPLES];
+  uint8_t sampleHead, sampleCount;
+};
+
+void gesture_reset(GestureTracker* g);
+
+// Whether a press is being tracked (between a press and its release).
+bool gesture_active(const GestureTracker* g);
+
+// One pointer state at time `ms` (see input_time()). Returns true and
+// fills *out when it completes or continues a gesture.
+bool gesture_feed(GestureTracker* g, bool pressed, int x, int y, uint32_t ms, GestureEvent* out);
@@ -0,0 +1,329 @@
+#include "input.h"
+#include "touch.h"
+#include "mirror.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <atomic>
+
+// Mouse bridge (UDP)
+static const uint16_t MOUSE_UDP_PORT = 4210;
+
+// Enough for a fast swipe plus a burst of mouse packets while loop() is
+// busy redrawing.
+#define QUEUE_LEN 64
+// How often the task wakes without an interrupt: to read mouse packets
+// while a bridge is connected, to catch a release whose INT edge was
+// missed while a finger is down, and otherwise to notice Wi-Fi coming up
+// or a bridge's first packet.
+#define MOUSE_POLL_MS 5
+#define HOLD_POLL_MS  50
+#define IDLE_POLL_MS  250
+
+#define INPUT_TASK_STACK 3072
+
+static TaskHandle_t inputTask = nullptr;
+
+// Single producer (the input task), single consumer (loop()). Each side
+// only writes its own index, so no lock is needed.
+static InputEvent queue[QUEUE_LEN];
+static std::atomic<uint32_t> head(0);   // next slot to write
+static std::atomic<uint32_t> tail(0);   // next slot to read
+static uint32_t dropped = 0;
+static uint32_t eventMs = 0;
+
+static WiFiUDP mouseUdp;
+static bool mouseUdpStarted = false;
+
+static void push(InputType type, InputSource src, int x, int y, int wheel, uint32_t ms) {
+  uint32_t h = head.load(std::memory_order_relaxed);
+  if (h - tail.load(std::memory_order_acquire) >= QUEUE_LEN) {
+    dropped++;
+    return;
+  }
+  queue[h % QUEUE_LEN] = {ms, (int16_t)x, (int16_t)y, (int16_t)wheel, type, src};
+  head.store(h + 1, std::memory_order_release);
+}
+
+// Touch: the last reported point, to tell moves from repeats.
+static bool touchDown = false;
+static int touchX = 0;
+static int touchY = 0;
+static uint32_t touchReadMs = 0;
+
+static void sampleTouch(uint32_t ms) {
+  int x, y;
+  bool pressed = touch_read(&x, &y);
+  touchReadMs = millis();
+  if (pressed) {
+    if (!touchDown) push(INPUT_DOWN, INPUT_SRC_TOUCH, x, y, 0, ms);
+    else if (x != touchX || y != touchY) push(INPUT_MOVE, INPUT_SRC_TOUCH, x, y, 0, ms);
+    touchX = x;
+    touchY = y;
+  } else if (touchDown) {
+    push(INPUT_UP, INPUT_SRC_TOUCH, touchX, touchY, 0, ms);
+  }
+  touchDown = pressed;
+}
+
+// Mouse: the bridge sends binary pointer packets (little-endian):
+//
+//   0  u8   version (MOUSE_PROTO_VERSION)
+//   1  u8   type: MOUSE_PKT_ABS (points are positions) or
+//           MOUSE_PKT_REL (points are deltas from the previous one)
+//   2  u16  sequence number, +1 per packet
+//   4  u8   buttons held once the points were reached (bit 0: left)
+//   5  u8   running total of wheel steps, mod 256
+//   6  u8   number of points that follow, oldest first
+//   7  n x (i16 x, i16 y)
+//
+// A 3-byte packet {version, MOUSE_PKT_MIRROR, flags} instead asks for
+// the screen to be mirrored back to the sender (mirror.h); flags bit 0
+// asks for a full frame.
+//
+// Typing comes as {version, MOUSE_PKT_KEYS, u16 key sequence number,
+// keys...}: printable ASCII, INPUT_KEY_BACKSPACE or INPUT_KEY_ENTER, up
+// to KEYS_MAX of them, so a paste is one packet. Unlike pointer state,
+// keys must not get lost or doubled: each packet is answered with
+// {version, MOUSE_PKT_KEYS_ACK, u16 sequence number} once it is queued,
+// the bridge keeps resending until it sees that, and a repeat of the
+// last packet, or an older one, is acknowledged again but not applied.
+// Key packets keep their own link time, since pointer keepalives say
+// nothing about them: after KEYS_LINK_MS without one, or from far
+// behind, it is a restarted bridge, whose first packet is taken whatever
+// its number. Resends come much faster than that, so a lost
+// acknowledgement never doubles keys. With no room in the queue the
+// packet is not acknowledged, so the bridge tries again later.
+//
+// Buttons and wheel are state, not edges: each packet says what is held
+// and how far the wheel has turned in all, so a lost packet costs only
+// the points it carried, and the next one (the bridge repeats itself at
+// several times a second) puts the button right. A packet older than
+// the last one applied is dropped; after a silence, or from far behind,
+// it is a restarted bridge and is taken as the new start. If the bridge
+// goes silent with the button held, the task lets go itself.
+//
+// Each wake drains every datagram waiting in the socket. Moves between
+// two button changes only matter at their last position, so a burst of
+// them becomes one event; button changes are queued in order, at the
+// position they happened, and wheel steps are summed. The cursor is
+// never more than a wake behind the laptop, however fast the bridge
+// sends.
+#define MOUSE_PROTO_VERSION 2
+#define MOUSE_PKT_ABS 1
+#define MOUSE_PKT_REL 2
+#define MOUSE_PKT_MIRROR 3
+#define MOUSE_PKT_KEYS 4
+#define MOUSE_PKT_KEYS_ACK 5
+#define KEYS_HEADER 4
+#define KEYS_MAX 512
+#define MOUSE_HEADER_LEN 7
+#define MOUSE_MAX_POINTS 32
+// A sequence number this far behind the last one is a new bridge, not
+// a late packet.
+#define MOUSE_SEQ_RESTART 256
+// The bridge counts as connected this long after its last packet.
+#define MOUSE_LINK_MS 1000
+// Key packets this far apart come from a new key sequence; the bridge
+// resends an unacknowledged one every 100 ms.
+#define KEYS_LINK_MS 1000
+
+static bool mouseDown = false;
+static int mouseX = -1;   // last position queued
+static int mouseY = -1;
+static int ptrX = 0;      // where the packets put the pointer
+static int ptrY = 0;
+static uint16_t mouseSeq = 0;
+static uint8_t mouseWheelTotal = 0;
+static std::atomic<uint32_t> mouseHeardMs(0);
+static std::atomic<bool> mouseHeard(false);
+static uint32_t mouseLost = 0;
+static uint32_t mouseStale = 0;
+
+// Datagrams read per wake at most, so a flood cannot hold the task.
+#define MOUSE_DRAIN_MAX 64
+#define PKT_BUF_LEN (KEYS_HEADER + KEYS_MAX)
+
+// Typed keys for loop(), single producer / single consumer like the
+// event queue. Twice a full packet, so a paste can land while the last
+// one is still being applied.
+#define KEY_QUEUE_LEN 1024
+static char keyQueue[KEY_QUEUE_LEN];
+static std::atomic<uint32_t> keyHead(0);
+static std::atomic<uint32_t> keyTail(0);
+static bool keysSynced = false;
+static uint16_t keysSeq = 0;
+static uint32_t keysHeardMs = 0;
+
+static int16_t rd16(const uint8_t* p) { return (int16_t)(p[0] | (p[1] << 8)); }
+
+// Checks a packet's version, length and sequence number. Returns false
+// for anything that should not be applied.
+static bool acceptPacket(const uint8_t* pkt, int len) {
+  if (len < MOUSE_HEADER_LEN || pkt[0] != MOUSE_PROTO_VERSION) return false;
+  if (pkt[1] != MOUSE_PKT_ABS && pkt[1] != MOUSE_PKT_REL) return false;
+  int n = pkt[6];
+  if (n > MOUSE_MAX_POINTS || len < MOUSE_HEADER_LEN + 4 * n) return false;
+
+  uint16_t seq = (uint16_t)rd16(pkt + 2);
+  int16_t ahead = (int16_t)(seq - mouseSeq);
+  if (!input_mouse_connected() || ahead <= -MOUSE_SEQ_RESTART) {
+    // A new bridge: its wheel total is the starting point.
+    mouseWheelTotal = pkt[5];
+  } else if (ahead <= 0) {
+    mouseStale++;
+    return false;
+  } else if (ahead > 1) {
+    mouseLost += ahead - 1;
+  }
+  mouseSeq = seq;
+  return true;
+}
+
+// Queues a key packet's keys and acknowledges it; see above.
+static void receiveKeys(const uint8_t* pkt, int len) {
+  uint16_t seq = (uint16_t)rd16(pkt + 2);
+  int16_t ahead = (int16_t)(seq - keysSeq);
+  uint32_t now = millis();
+  bool fresh = !keysSynced || now - keysHeardMs >= KEYS_LINK_MS || ahead > 0 ||
+               ahead <= -MOUSE_SEQ_RESTART;
+  keysHeardMs = now;
+  if (fresh) {
+    int n = len - KEYS_HEADER;
+    uint32_t h = keyHead.load(std::memory_order_relaxed);
+    if (KEY_QUEUE_LEN - (h - keyTail.load(std::memory_order_acquire)) < (uint32_t)n) return;
+    for (int i = 0; i < n; i++) keyQueue[(h + i) % KEY_QUEUE_LEN] = (char)pkt[KEYS_HEADER + i];
+    keyHead.store(h + n, std::memory_order_release);
+    keysSynced = true;
+    keysSeq = seq;
+  }
+  // Repeats and late packets are answered too, or the bridge would resend
+  // them forever.
+  uint8_t ack[4] = {MOUSE_PROTO_VERSION, MOUSE_PKT_KEYS_ACK, pkt[2], pkt[3]};
+  mouseUdp.beginPacket(mouseUdp.remoteIP(), mouseUdp.remotePort());
+  mouseUdp.write(ack, sizeof(ack));
+  mouseUdp.endPacket();
+}
+
+static void pollMouse() {
+  if (!mouseUdpStarted) {
+    if (WiFi.status() != WL_CONNECTED) return;
+    mouseUdp.begin(MOUSE_UDP_PORT);
+    mouseUdpStarted = true;
+    Serial.println("UDP mouse listener started");
+  }
+
+  uint32_t ms = millis();
+  int moveX = mouseX, moveY = mouseY;
+  int wheel = 0;
+  int wheelX = 0, wheelY = 0;
+
+  for (int k = 0; k < MOUSE_DRAIN_MAX && mouseUdp.parsePacket() > 0; k++) {
+    static uint8_t pkt[PKT_BUF_LEN];
+    int len = mouseUdp.read(pkt, sizeof(pkt));
+    if (len >= 3 && pkt[0] == MOUSE_PROTO_VERSION && pkt[1] == MOUSE_PKT_MIRROR) {
+      mirror_request(mouseUdp.remoteIP(), mouseUdp.remotePort(), (pkt[2] & 1) != 0);
+      continue;
+    }
+    if (len >= KEYS_HEADER && pkt[0] == MOUSE_PROTO_VERSION && pkt[1] == MOUSE_PKT_KEYS) {
+      receiveKeys(pkt, len);
+      continue;
+    }
+    if (!acceptPacket(pkt, len)) continue;
+    mouseHeardMs.store(ms, std::memory_order_relaxed);
+    mouseHeard.store(true, std::memory_order_release);
+
+    bool rel = pkt[1] == MOUSE_PKT_REL;
+    for (int i = 0; i < pkt[6]; i++) {
+      int x = rd16(pkt + MOUSE_HEADER_LEN + 4 * i);
+      int y = rd16(pkt + MOUSE_HEADER_LEN + 4 * i + 2);
+      ptrX = constrain(rel ? ptrX + x : x, 0, TOUCH_SCREEN_W - 1);
+      ptrY = constrain(rel ? ptrY + y : y, 0, TOUCH_SCREEN_H - 1);
+    }
+
+    bool down = (pkt[4] & 1) != 0;
+    if (down != mouseDown) {
+      // Where the pointer got to before the button changed still counts:
+      // it is where a drag ends.
+      if (moveX != mouseX || moveY != mouseY) {
+        push(INPUT_MOVE, INPUT_SRC_MOUSE, moveX, moveY, 0, ms);
+      }
+      mouseDown = down;
+      push(mouseDown ? INPUT_DOWN : INPUT_UP, INPUT_SRC_MOUSE, ptrX, ptrY, 0, ms);
+      mouseX = ptrX;
+      mouseY = ptrY;
+    }
+    moveX = ptrX;
+    moveY = ptrY;
+
+    int8_t w = (int8_t)(pkt[5] - mouseWheelTotal);
+    mouseWheelTotal = pkt[5];
+    if (w != 0) {
+      wheel += w;
+      wheelX = ptrX;
+      wheelY = ptrY;
+    }
+  }
+
+  if (moveX != mouseX || moveY != mouseY) {
+    push(INPUT_MOVE, INPUT_SRC_MOUSE, moveX, moveY, 0, ms);
+    mouseX = moveX;
+    mouseY = moveY;
+  }
+  if (wheel != 0) {
+    push(INPUT_WHEEL, INPUT_SRC_MOUSE, wheelX, wheelY, constrain(wheel, -32767, 32767), ms);
+  }
+  if (mouseDown && !input_mouse_connected()) {
+    mouseDown = false;
+    push(INPUT_UP, INPUT_SRC_MOUSE, mouseX, mouseY, 0, ms);
+  }
+}
+
+static void inputWorker(void*) {
+  for (;;) {
+    uint32_t waitMs = input_mouse_connected() ? MOUSE_POLL_MS : touchDown ? HOLD_POLL_MS : IDLE_POLL_MS;
+    bool irq = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs)) > 0;
+    if (irq) sampleTouch(touch_irq_ms());
+    else if (touchDown && millis() - touchReadMs >= HOLD_POLL_MS) sampleTouch(millis());
+    pollMouse();
+  }
+}
+
+void input_init() {
+  // Above the AI worker on the same core, so typing stays responsive
+  // while a reply streams in.
+  xTaskCreatePinnedToCore(inputWorker, "input", INPUT_TASK_STACK, nullptr, 2, &inputTask, 0);
+  touch_init(inputTask);
+}
+
+bool input_poll(InputEvent* ev) {
+  uint32_t t = tail.load(std::memory_order_relaxed);
+  if (t == head.load(std::memory_order_acquire)) return false;
+  *ev = queue[t % QUEUE_LEN];
+  tail.store(t + 1, std::memory_order_release);
+  return true;
+}
+
+uint32_t input_dropped() { return dropped; }
+
+int input_poll_keys(char* buf, int max) {
+  uint32_t t = keyTail.load(std::memory_order_relaxed);
+  uint32_t avail = keyHead.load(std::memory_order_acquire) - t;
+  int n = (int)min(avail, (uint32_t)max);
+  for (int i = 0; i < n; i++) buf[i] = keyQueue[(t + i) % KEY_QUEUE_LEN];
+  keyTail.store(t + n, std::memory_order_release);
+  return n;
+}
+
+bool input_mouse_connected() {
+  return mouseHeard.load(std::memory_order_acquire) &&
+         millis() - mouseHeardMs.load(std::memory_order_relaxed) < MOUSE_LINK_MS;
+}
+
+void input_mouse_stats(uint32_t* lost, uint32_t* stale) {
+  *lost = mouseLost;
+  *stale = mouseStale;
+}
+
+uint32_t input_time() { return eventMs; }
+void input_set_time(uint32_t ms) { eventMs = ms; }
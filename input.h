@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+// All pointer input as one stream of events.
+//
+// A task on core 0 (loop() runs on core 1) turns touch reports and the
+// mouse bridge's sequenced UDP packets into down / move / up / wheel
+// events and queues them in order. loop() hands every event to the foreground app, so a stroke
+// keeps each point the panel or the mouse reported, however long a pass
+// took.
+//
+// A move between a down and an up is a drag; a mouse also sends moves
+// with no button held (hover). Wheel events carry the position of the
+// pointer at the time.
+
+enum InputType : uint8_t {
+  INPUT_DOWN,
+  INPUT_MOVE,
+  INPUT_UP,
+  INPUT_WHEEL,
+};
+
+enum InputSource : uint8_t {
+  INPUT_SRC_TOUCH,
+  INPUT_SRC_MOUSE,
+};
+
+struct InputEvent {
+  uint32_t ms;        // millis() when the input happened
+  int16_t x, y;       // screen coordinates
+  int16_t wheel;      // INPUT_WHEEL: steps, positive scrolls up
+  InputType type;
+  InputSource source;
+};
+
+// Starts the input task and the touch interrupt.
+void input_init();
+
+// Takes the oldest queued event. Returns false when the queue is empty.
+bool input_poll(InputEvent* ev);
+
+// Events dropped because loop() fell too far behind.
+uint32_t input_dropped();
+
+// Keys typed on the bridge's keyboard, for the app's text field:
+// printable ASCII plus these two.
+#define INPUT_KEY_BACKSPACE '\b'
+#define INPUT_KEY_ENTER     '\n'
+
+// Copies up to max queued keys into buf, oldest first, and returns how
+// many. A paste arrives all at once, so apps can apply it in one go.
+int input_poll_keys(char* buf, int max);
+
+// True while the mouse bridge is sending (it repeats its state several
+// times a second even when the mouse is still).
+bool input_mouse_connected();
+
+// Bridge packets that never arrived (gaps in the sequence) and that
+// arrived after a newer one and were ignored.
+void input_mouse_stats(uint32_t* lost, uint32_t* stale);
+
+// When the input an app is handling happened: loop() sets it to the
+// event's timestamp before dispatching it, and to millis() on a pass
+// without events. Gestures are timed by it, not by when a pass ran.
+uint32_t input_time();
+void input_set_time(uint32_t ms);
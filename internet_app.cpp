@@ -1,8 +1,13 @@
 #include "internet_app.h"
 #include "windows.h"
 #include "system_ui.h"
+#include "text_layout.h"
+#include "gesture.h"
+#include "kinetic_scroll.h"
+#include "input.h"
+#include "app_arena.h"
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 
 static const uint16_t XP_BG     = 0xC618;
 static const uint16_t XP_BORDER = 0x7BEF;
@@ -35,12 +40,27 @@ static const int IMG_H = WINDOWS_HEIGHT;
 static const int IMG_PAD = 6;
 
 static const int MAX_LINES  = 120;
-static const int LINE_CHARS = 44;
-
-static char pageLines[MAX_LINES][LINE_CHARS + 1];
-static int  lineCount  = 0;
+static const int LINE_CHARS = 160;
+
+// Article text below the title rows (64 px, see drawPage()), the image
+// and the info box.
+static const int TEXT_X = CONTENT_X + 6;
+static const int TEXT_Y = CONTENT_Y + 64 + IMG_H + IMG_PAD + 4;
+static const int TEXT_LINE_H = 14;
+static const int TEXT_ROWS = max(1, (CONTENT_Y + CONTENT_H - 6 - TEXT_Y) / TEXT_LINE_H);
+
+// Line table of the page; from the app arena while the page is open.
+static uint16_t* lineStarts = nullptr;
+static TextLayout page;
 static int  scrollLine = 0;
 
+// A tap on the page steps the text by a line (up in the top half of the
+// window, down in the bottom half); drags and flings scroll it smoothly
+// and snap to a line when they come to rest.
+static GestureTracker gesture;
+static KineticScroll kinetic;
+static bool scrolling = false;
+
 static int statusX = 0;
 static int statusY = 0;
 static uint32_t lastStatusTick = 0;
@@ -49,58 +69,26 @@ static inline bool inRect(int x,int y,int rx,int ry,int rw,int rh){
   return (x>=rx && x<rx+rw && y>=ry && y<ry+rh);
 }
 
-static void clearLines() {
-  for (int i=0;i<MAX_LINES;i++) pageLines[i][0] = 0;
-  lineCount = 0;
-  scrollLine = 0;
-}
-
-static void addLineC(const String& s) {
-  if (lineCount >= MAX_LINES) return;
-  String t = s;
-  t.trim();
-  if (t.length() == 0) return;
-  t.toCharArray(pageLines[lineCount], LINE_CHARS + 1);
-  pageLines[lineCount][LINE_CHARS] = 0;
-  lineCount++;
-}
-
-static void addWrapped(const String& s) {
-  String t = s;
-  while (t.length() > 0 && lineCount < MAX_LINES) {
-    if ((int)t.length() <= LINE_CHARS) {
-      addLineC(t);
-      return;
-    }
-
-    int cut = LINE_CHARS;
-    int sp = t.lastIndexOf(' ', LINE_CHARS);
-    if (sp > 8) cut = sp;
-
-    addLineC(t.substring(0, cut));
-    t = t.substring(cut);
-    t.trim();
-  }
-}
+static const char* PAGE_TEXT =
+  "Windows XP is a major release of Microsoft's Windows NT "
+  "operating system. It was released to manufacturing on "
+  "August 24, 2001, and later to retail on October 25, 2001.\n"
+  "Development of Windows XP began in the late 1990s under the "
+  "codename \"Neptune\", built on the Windows NT kernel and "
+  "intended for mainstream consumer use.\n"
+  "Upon its release, Windows XP received critical acclaim, "
+  "noting improved performance and stability compared to "
+  "Windows Me, a more intuitive interface, and expanded "
+  "multimedia capabilities.\n"
+  "Mainstream support ended on April 14, 2009, and extended "
+  "support ended on April 8, 2014. Security updates for some "
+  "embedded editions continued until April 2019.";
 
 static void buildFakePage() {
-  clearLines();
-  addWrapped("Windows XP is a major release of Microsoft's Windows NT "
-             "operating system. It was released to manufacturing on "
-             "August 24, 2001, and later to retail on October 25, 2001.");
-  addLineC("");
-  addWrapped("Development of Windows XP began in the late 1990s under the "
-             "codename \"Neptune\", built on the Windows NT kernel and "
-             "intended for mainstream consumer use.");
-  addLineC("");
-  addWrapped("Upon its release, Windows XP received critical acclaim, "
-             "noting improved performance and stability compared to "
-             "Windows Me, a more intuitive interface, and expanded "
-             "multimedia capabilities.");
-  addLineC("");
-  addWrapped("Mainstream support ended on April 14, 2009, and extended "
-             "support ended on April 8, 2014. Security updates for some "
-             "embedded editions continued until April 2019.");
+  lineStarts = (uint16_t*)app_arena_alloc(MAX_LINES * sizeof(uint16_t));
+  text_layout_init(&page, lineStarts, MAX_LINES, CONTENT_W - 12, 2);
+  text_layout_set(&page, PAGE_TEXT, strlen(PAGE_TEXT));
+  scrollLine = 0;
 }
 
 static void drawTitleBar() {
@@ -132,6 +120,77 @@ static void drawContentFrame() {
   tft->drawRect(CONTENT_X, CONTENT_Y, CONTENT_W, CONTENT_H, XP_BORDER);
 }
 
+// The article text at scrollLine; `clear` wipes what the previous
+// position left.
+static void drawPageText(bool clear) {
+  TextWindow win = text_layout_window(&page, scrollLine, TEXT_ROWS);
+  scrollLine = win.first;
+
+  if (clear) tft->fillRect(CONTENT_X + 1, TEXT_Y, CONTENT_W - 2, TEXT_ROWS * TEXT_LINE_H, XP_WHITE);
+  tft->setTextColor(XP_BLACK, XP_WHITE);
+
+  if (page.len == 0) {
+    tft->drawString("(no text loaded)", TEXT_X, TEXT_Y, 2);
+    return;
+  }
+
+  char line[LINE_CHARS + 1];
+  int y = TEXT_Y;
+  for (int i = win.first; i < win.last; i++) {
+    text_layout_copy_line(&page, i, line, sizeof(line));
+    tft->drawString(line, TEXT_X, y, 2);
+    y += TEXT_LINE_H;
+  }
+}
+
+static void drawTextRow(TFT_eSPI* g, int row, int y) {
+  char line[LINE_CHARS + 1];
+  text_layout_copy_line(&page, row, line, sizeof(line));
+  g->setTextColor(XP_BLACK, XP_WHITE);
+  g->drawString(line, TEXT_X, y, 2);
+}
+
+static void drawScrolled() {
+  KineticView v = {CONTENT_X + 1, TEXT_Y, CONTENT_W - 2, TEXT_ROWS * TEXT_LINE_H, TEXT_LINE_H,
+                   page.count, XP_WHITE, drawTextRow};
+  kinetic_render(tft, &v, kinetic.pos);
+}
+
+static void startScroll() {
+  if (scrolling) return;
+  kinetic_reset(&kinetic, scrollLine * TEXT_LINE_H, max(0, page.count - TEXT_ROWS) * TEXT_LINE_H);
+  scrolling = true;
+}
+
+static void settleScroll() {
+  if (!scrolling) return;
+  scrolling = false;
+  kinetic_stop(&kinetic);
+  scrollLine = (kinetic.pos + TEXT_LINE_H / 2) / TEXT_LINE_H;
+  drawPageText(true);
+}
+
+static void handleGesture(const GestureEvent& g) {
+  switch (g.type) {
+    case GESTURE_TAP:
+    case GESTURE_DOUBLE_TAP:
+      if (scrolling) break;
+      if (g.y < CONTENT_Y + CONTENT_H/2) scrollLine--;
+      else scrollLine++;
+      drawPageText(true);
+      break;
+    case GESTURE_DRAG:
+      startScroll();
+      kinetic_drag(&kinetic, g.dy);
+      break;
+    case GESTURE_FLING:
+      kinetic_fling(&kinetic, g.vy, input_time());
+      break;
+    default:
+      break;
+  }
+}
+
 static void drawPage() {
   drawContentFrame();
 
@@ -172,33 +231,7 @@ static void drawPage() {
   tft->setTextColor(XP_BLACK, XP_WHITE);
   tft->drawString("Oct 25, 2001", boxX + 4, boxY + 48, 2);
 
-  int textStartY = imgY + IMG_H + IMG_PAD + 4;
-  int x = CONTENT_X + 6;
-  int y = textStartY;
-
-  const int lineH = 14;
-  int bottomY = CONTENT_Y + CONTENT_H - 6;
-  int visible = (bottomY - y) / lineH;
-  if (visible < 1) visible = 1;
-
-  if (scrollLine < 0) scrollLine = 0;
-  int maxScroll = lineCount - visible;
-  if (maxScroll < 0) maxScroll = 0;
-  if (scrollLine > maxScroll) scrollLine = maxScroll;
-
-  tft->setTextColor(XP_BLACK, XP_WHITE);
-
-  if (lineCount == 0) {
-    tft->drawString("(no text loaded)", x, y, 2);
-    return;
-  }
-
-  for (int i=0;i<visible;i++) {
-    int idx = scrollLine + i;
-    if (idx >= lineCount) break;
-    tft->drawString(pageLines[idx], x, y, 2);
-    y += lineH;
-  }
+  drawPageText(false);
 }
 
 static void drawAllUI() {
@@ -208,9 +241,8 @@ static void drawAllUI() {
   drawPage();
 }
 
-void internet_app_init(TFT_eSPI* display) {
+void internet_app_init(Display* display) {
   tft = display;
-  buildFakePage();
 }
 
 bool internet_app_isOpen() { return opened; }
@@ -218,7 +250,9 @@ bool internet_app_isOpen() { return opened; }
 void internet_app_open() {
   if (!tft) return;
   opened = true;
-  scrollLine = 0;
+  buildFakePage();
+  scrolling = false;
+  gesture_reset(&gesture);
   drawAllUI();
 }
 
@@ -229,11 +263,21 @@ void internet_app_tick() {
     system_ui_tick(statusX, statusY, XP_BLUE2);
     lastStatusTick = now;
   }
+  if (scrolling) {
+    if (kinetic_frame(&kinetic, now)) drawScrolled();
+    if (!gesture_active(&gesture) && !kinetic_moving(&kinetic)) settleScroll();
+  }
 }
 
 bool internet_app_handleTouch(bool pressed, bool lastPressed, int x, int y) {
   if (!opened) return false;
 
+  if (gesture_active(&gesture)) {
+    GestureEvent g;
+    if (gesture_feed(&gesture, pressed, x, y, input_time(), &g)) handleGesture(g);
+    return true;
+  }
+
   if (!(pressed && !lastPressed)) return true;
 
   int titleCloseX = WIN_W - PAD - 18;
@@ -243,9 +287,10 @@ bool internet_app_handleTouch(bool pressed, bool lastPressed, int x, int y) {
   }
 
   if (inRect(x,y, CONTENT_X, CONTENT_Y, CONTENT_W, CONTENT_H)) {
-    if (y < CONTENT_Y + CONTENT_H/2) scrollLine--;
-    else scrollLine++;
-    drawPage();
+    // A press while it glides catches it; the tap that follows is ignored.
+    if (scrolling) kinetic_stop(&kinetic);
+    GestureEvent g;
+    gesture_feed(&gesture, true, x, y, input_time(), &g);
     return true;
   }
 
@@ -1,7 +1,7 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "display.h"
 
-void internet_app_init(TFT_eSPI* display);
+void internet_app_init(Display* display);
 bool internet_app_isOpen();
 void internet_app_open();
 void internet_app_tick();
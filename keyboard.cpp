@@ -1,11 +1,13 @@
 #include "keyboard.h"
+#include "input.h"
 #include <Arduino.h>
 #include <ctype.h>
 
-static TFT_eSPI *tft = nullptr;
+static Display* tft = nullptr;
 
 static char text[KB_TEXT_MAX + 1];
 static int  cursor = 0;
+static KB_EditFn editor = nullptr;
 
 static bool visible = true;
 static bool mode123 = false;
@@ -48,18 +50,25 @@ static inline bool insidePad(int x,int y,int rx,int ry,int rw,int rh,int pad){
 }
 
 static void addChar(char c) {
+  if (editor) { editor(c); return; }
   if (cursor >= KB_TEXT_MAX) return;
   text[cursor++] = c;
   text[cursor] = 0;
 }
 
 static void backspaceOnce() {
+  if (editor) { editor('\b'); return; }
   if (cursor > 0) {
     cursor--;
     text[cursor] = 0;
   }
 }
 
+static void clearText() {
+  if (editor) { editor(0); return; }
+  keyboard_clear();
+}
+
 static int kbTopY() {
   int ty = KB_Y + KB_DY;
   if (ty < 0) ty = 0;
@@ -269,7 +278,7 @@ static KB_Action commitKey(const KeyRect &k) {
       backspaceOnce();
       delHeld = true; delStart = millis(); delLast = delStart;
       return KB_CHANGED;
-    case KT_CLR: keyboard_clear(); return KB_CHANGED;
+    case KT_CLR: clearText(); return KB_CHANGED;
     case KT_MODE: mode123 = !mode123; return KB_REDRAW;
     case KT_CAPS:
       caps = !caps;
@@ -301,7 +310,7 @@ static KB_Action handleHoldAt(bool pressedNow, int x, int y) {
       if (keys[i].type == KT_CAPS) {
         if (insidePad(x,y, keys[i].x, keys[i].y, keys[i].w, keys[i].h, HIT_PAD)) {
           if (now - capsDownAt >= CAPS_CLEAR_HOLD) {
-            keyboard_clear();
+            clearText();
             capsDidClear = true;
             return KB_CHANGED;
           }
@@ -330,7 +339,7 @@ static KB_Action handleHoldAt(bool pressedNow, int x, int y) {
   return KB_NONE;
 }
 
-void keyboard_init(TFT_eSPI *display) {
+void keyboard_init(Display* display) {
   tft = display;
   keyboard_clear();
 }
@@ -345,6 +354,8 @@ void keyboard_clear() {
 
 const char* keyboard_get_text(){ return text; }
 
+void keyboard_set_editor(KB_EditFn fn) { editor = fn; }
+
 void keyboard_set_text(const char* s) {
   if (!s) {
     keyboard_clear();
@@ -359,6 +370,15 @@ void keyboard_set_text(const char* s) {
   cursor = n;
 }
 
+int keyboard_type(const char* keys, int n) {
+  int i = 0;
+  for (; i < n && keys[i] != INPUT_KEY_ENTER; i++) {
+    if (keys[i] == INPUT_KEY_BACKSPACE) backspaceOnce();
+    else if (keys[i] >= ' ' && keys[i] <= '~') addChar(keys[i]);
+  }
+  return i;
+}
+
 void keyboard_release() {
   keyDown = false;
   delHeld = false;
@@ -1,5 +1,5 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "display.h"
 
 #ifndef KB_TEXT_MAX
 #define KB_TEXT_MAX 256
@@ -16,7 +16,7 @@ typedef enum {
   KB_HIDE
 } KB_Action;
 
-void keyboard_init(TFT_eSPI *display);
+void keyboard_init(Display* display);
 KB_Action keyboard_update(bool pressed, int x, int y);
 
 void keyboard_set_visible(bool v);
@@ -26,6 +26,17 @@ void keyboard_clear();
 const char* keyboard_get_text();
 void keyboard_set_text(const char* s);
 
+// Hands key presses to fn instead of the keyboard's own text buffer:
+// a character, '\b' for delete, or 0 for clear. nullptr restores the
+// buffer.
+typedef void (*KB_EditFn)(char c);
+void keyboard_set_editor(KB_EditFn fn);
+
+// Applies keys typed on the bridge (input_poll_keys()) as if their keys
+// had been tapped, up to the first INPUT_KEY_ENTER, which is the app's to
+// handle. Returns how many keys were used; nothing is drawn.
+int keyboard_type(const char* keys, int n);
+
 void keyboard_draw();
 
 KB_Action keyboard_touch(int x, int y);
@@ -0,0 +1,137 @@
+#include "kinetic_scroll.h"
+
+// Speed lost per second of a fling, and the speed it stops at.
+static const float FRICTION = 1400.0f;
+static const float MIN_SPEED = 40.0f;
+static const float MAX_SPEED = 3000.0f;
+
+// One strip of the view: full screen width, so any view fits across.
+static const int STRIP_W = 320;
+static const int STRIP_H = 16;
+
+static TFT_eSprite* strip = nullptr;
+static bool stripFailed = false;
+
+void kinetic_reset(KineticScroll* k, int pos, int maxPos) {
+  k->maxPos = maxPos > 0 ? maxPos : 0;
+  k->pos = constrain(pos, 0, k->maxPos);
+  k->drawnPos = k->pos;
+  k->fpos = (float)k->pos;
+  k->v = 0;
+  k->frameMs = 0;
+  k->stepMs = 0;
+  k->flinging = false;
+}
+
+void kinetic_drag(KineticScroll* k, int dy) {
+  k->flinging = false;
+  k->pos = constrain(k->pos - dy, 0, k->maxPos);
+  k->fpos = (float)k->pos;
+}
+
+void kinetic_fling(KineticScroll* k, float vy, uint32_t ms) {
+  k->v = constrain(-vy, -MAX_SPEED, MAX_SPEED);
+  k->fpos = (float)k->pos;
+  k->stepMs = ms;
+  k->flinging = fabsf(k->v) >= MIN_SPEED;
+}
+
+void kinetic_stop(KineticScroll* k) {
+  k->flinging = false;
+  k->v = 0;
+}
+
+bool kinetic_moving(const KineticScroll* k) {
+  return k->flinging || k->pos != k->drawnPos;
+}
+
+bool kinetic_frame(KineticScroll* k, uint32_t ms) {
+  if (ms - k->frameMs < KINETIC_FRAME_MS) return false;
+
+  if (k->flinging) {
+    float dt = (ms - k->stepMs) / 1000.0f;
+    k->stepMs = ms;
+    float speed = fabsf(k->v);
+    float slowed = speed - FRICTION * dt;
+    // Distance under constant deceleration, up to where it stops.
+    float t = slowed > 0 ? dt : speed / FRICTION;
+    float dist = (speed - FRICTION * t / 2) * t;
+    k->fpos += k->v > 0 ? dist : -dist;
+    k->v = slowed > 0 ? (k->v > 0 ? slowed : -slowed) : 0;
+    if (k->fpos <= 0 || k->fpos >= k->maxPos) {
+      k->fpos = constrain(k->fpos, 0.0f, (float)k->maxPos);
+      k->v = 0;
+    }
+    if (fabsf(k->v) < MIN_SPEED) k->flinging = false;
+    k->pos = (int)lroundf(k->fpos);
+  }
+
+  if (k->pos == k->drawnPos) return false;
+  k->drawnPos = k->pos;
+  k->frameMs = ms;
+  return true;
+}
+
+static bool ensureStrip(Display* tft) {
+  if (strip && strip->created()) return true;
+  if (stripFailed) return false;
+  if (!strip) strip = new TFT_eSprite(tft);
+  strip->setColorDepth(16);
+  if (!strip->createSprite(STRIP_W, STRIP_H)) {
+    stripFailed = true;
+    return false;
+  }
+  return true;
+}
+
+// Without the sprite: whole rows only, drawn in place.
+static void renderDirect(Display* tft, const KineticView* v, int offsetPx) {
+  int first = (offsetPx + v->rowH - 1) / v->rowH;
+  int n = v->h / v->rowH;
+  tft->fillRect(v->x, v->y, v->w, v->h, v->bg);
+  for (int r = first; r < first + n && r < v->rows; r++) {
+    v->drawRow(tft, r, v->y + (r - first) * v->rowH);
+  }
+}
+
+void kinetic_render(Display* tft, const KineticView* v, int offsetPx) {
+  if (!ensureStrip(tft)) {
+    renderDirect(tft, v, offsetPx);
+    return;
+  }
+
+  uint16_t* buf = (uint16_t*)strip->getPointer();
+  bool swap = tft->getSwapBytes();
+  tft->setSwapBytes(false);
+
+  for (int sy = 0; sy < v->h; sy += STRIP_H) {
+    int sh = min(STRIP_H, v->h - sy);
+    int top = v->y + sy;
+
+    // Datum at (-x, -top): rows are drawn in screen coordinates and
+    // clipped to the strip.
+    strip->setViewport(-v->x, -top, v->x + v->w, top + sh, true);
+    strip->fillRect(v->x, top, v->w, sh, v->bg);
+    int first = (offsetPx + sy) / v->rowH;
+    int last = (offsetPx + sy + sh - 1) / v->rowH;
+    for (int r = first; r <= last && r < v->rows; r++) {
+      v->drawRow(strip, r, v->y + r * v->rowH - offsetPx);
+    }
+    strip->resetViewport();
+
+    // Pack the rows so the strip is one contiguous block for pushImage.
+    if (v->w < STRIP_W) {
+      for (int yy = 1; yy < sh; yy++) {
+        memmove(buf + yy * v->w, buf + yy * STRIP_W, v->w * sizeof(uint16_t));
+      }
+    }
+    // Sprite pixels are already in SPI byte order.
+    tft->pushImage(v->x, top, v->w, sh, buf);
+  }
+  tft->setSwapBytes(swap);
+}
+
+void kinetic_release() {
+  if (strip) strip->deleteSprite();
+  stripFailed = false;
+}
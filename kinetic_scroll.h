@@ -0,0 +1,66 @@
+#pragma once
+#include "display.h"
+
+// Pixel-exact scrolling for the text views, with inertia.
+//
+// A KineticScroll holds the scroll position in pixels. Drags move it
+// directly, a fling hands it a velocity that decays under constant
+// friction. Either way nothing is drawn right away: kinetic_frame() says
+// when a new frame is due, at most one per KINETIC_FRAME_MS, so a burst
+// of move events costs one repaint.
+//
+// Frames are painted by kinetic_render() in horizontal strips through one
+// small sprite, each pushed with a single pushImage, so every pixel of
+// the view is sent once per frame and nothing flickers. (The ILI9341's
+// hardware scroll runs along the panel's long axis, which is horizontal
+// in the landscape rotation used here, so it cannot scroll these views.)
+
+#define KINETIC_FRAME_MS 33
+
+struct KineticScroll {
+  int pos;            // content pixels above the top of the view
+  int maxPos;
+  int drawnPos;       // position of the last frame
+  float fpos;         // exact position while flinging
+  float v;            // px/s, positive moves pos towards maxPos
+  uint32_t frameMs;   // when the last frame was drawn
+  uint32_t stepMs;    // when the fling was last advanced
+  bool flinging;
+};
+
+// Starts at `pos` with the last frame assumed to be drawn there.
+void kinetic_reset(KineticScroll* k, int pos, int maxPos);
+
+// The finger moved by dy: the content follows it.
+void kinetic_drag(KineticScroll* k, int dy);
+
+// The finger left with velocity vy (px/s, screen direction).
+void kinetic_fling(KineticScroll* k, float vy, uint32_t ms);
+
+void kinetic_stop(KineticScroll* k);
+
+// Still flinging, or moved since the last frame.
+bool kinetic_moving(const KineticScroll* k);
+
+// Advances a fling to `ms`. Returns true when a frame is due and k->pos
+// differs from the last one drawn; the caller then draws it.
+bool kinetic_frame(KineticScroll* k, uint32_t ms);
+
+// Draws content row `row` with its top at screen y. Drawing goes to `g`
+// in screen coordinates and is clipped to the strip being composed.
+typedef void (*KineticRowFn)(TFT_eSPI* g, int row, int y);
+
+struct KineticView {
+  int x, y, w, h;     // the view on screen
+  int rowH;
+  int rows;           // content rows
+  uint16_t bg;
+  KineticRowFn drawRow;
+};
+
+// Paints the view scrolled to offsetPx.
+void kinetic_render(Display* tft, const KineticView* v, int offsetPx);
+
+// The strip sprite is allocated by the first kinetic_render(); a view
+// that is closed gives it back with kinetic_release().
+void kinetic_release();
@@ -0,0 +1,288 @@
+#include "mirror.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <atomic>
+
+// Update packets (little-endian), sent to the port the bridge's requests
+// came from:
+//
+//   0  u8   version (2, as the bridge's own packets)
+//   1  u8   MIRROR_PKT_UPDATE
+//   2  u16  sequence number, +1 per packet
+//   4  records until the end of the datagram:
+//        u8 kind, i16 x, i16 y, u16 w, u16 h, then
+//        REC_FILL: u16 color
+//        REC_RLE:  runs covering w*h pixels row by row; a control byte
+//                  c < 128 is followed by c+1 literal colors, c >= 128
+//                  by one color repeated c-126 times
+//
+// Colors are RGB565 values. A record never spans two datagrams: an image
+// that does not fit is split into bands of whole rows, so a lost packet
+// loses whole rows and the rest still lands in the right place.
+#define MIRROR_VERSION 2
+#define MIRROR_PKT_UPDATE 16
+#define REC_FILL 1
+#define REC_RLE 2
+
+#define PKT_HEADER 4
+#define REC_HEADER 9
+// Stays under a typical 1500 byte MTU with IP and UDP headers.
+#define PKT_MAX 1400
+#define ROW_MAX (TFT_HEIGHT > TFT_WIDTH ? TFT_HEIGHT : TFT_WIDTH)
+// Worst case for one row: all literals.
+#define ROW_BYTES_MAX (ROW_MAX * 2 + (ROW_MAX + 127) / 128)
+
+#define DIRTY_MAX 8
+// Pixels read back from the panel per mirror_flush(), so a full frame is
+// spread over several passes instead of stalling one.
+#define READ_BUDGET (320 * 40)
+// A full frame at most this often, however many packets go missing.
+#define FULL_MIN_INTERVAL_MS 1000
+// A packet that is not full yet waits this long for more records, so a
+// pass that only moves the cursor is not a datagram of its own.
+#define SEND_INTERVAL_MS 20
+
+static Display* tft = nullptr;
+static WiFiUDP mirrorUdp;
+
+// Written by the input task, read by loop().
+static std::atomic<uint32_t> peerIp(0);
+static std::atomic<uint16_t> peerPort(0);
+static std::atomic<uint32_t> requestMs(0);
+static std::atomic<bool> fullWanted(false);
+
+static bool active = false;
+static IPAddress sendIp;
+static uint16_t sendPort = 0;
+static uint32_t lastFullMs = 0;
+static uint32_t lastSendMs = 0;
+
+static uint8_t pkt[PKT_MAX];
+static int pktLen = 0;
+static uint16_t seq = 0;
+// The RLE record rows are being added to, or -1.
+static int rleRec = -1;
+
+struct Rect { int32_t x, y, w, h; };
+static Rect dirty[DIRTY_MAX];
+static int dirtyCount = 0;
+
+void mirror_init(Display* display) { tft = display; }
+
+void mirror_request(IPAddress ip, uint16_t port, bool full) {
+  peerIp.store((uint32_t)ip[0] | (uint32_t)ip[1] << 8 | (uint32_t)ip[2] << 16 | (uint32_t)ip[3] << 24,
+               std::memory_order_relaxed);
+  peerPort.store(port, std::memory_order_relaxed);
+  if (full) fullWanted.store(true, std::memory_order_relaxed);
+  // Never 0, which means no request yet.
+  requestMs.store(millis() | 1, std::memory_order_release);
+}
+
+bool mirror_active() { return active; }
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void sendPacket() {
+  if (pktLen <= PKT_HEADER) return;
+  pkt[0] = MIRROR_VERSION;
+  pkt[1] = MIRROR_PKT_UPDATE;
+  put16(pkt + 2, seq++);
+  mirrorUdp.beginPacket(sendIp, sendPort);
+  mirrorUdp.write(pkt, pktLen);
+  mirrorUdp.endPacket();
+  lastSendMs = millis();
+  pktLen = PKT_HEADER;
+  rleRec = -1;
+}
+
+static uint8_t* beginRecord(uint8_t kind, int32_t x, int32_t y, int32_t w, int32_t h, int bodyLen) {
+  if (pktLen + REC_HEADER + bodyLen > PKT_MAX) sendPacket();
+  uint8_t* r = pkt + pktLen;
+  r[0] = kind;
+  put16(r + 1, (uint16_t)x);
+  put16(r + 3, (uint16_t)y);
+  put16(r + 5, (uint16_t)w);
+  put16(r + 7, (uint16_t)h);
+  pktLen += REC_HEADER + bodyLen;
+  return r;
+}
+
+static bool clipToScreen(int32_t& x, int32_t& y, int32_t& w, int32_t& h) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > tft->width()) w = tft->width() - x;
+  if (y + h > tft->height()) h = tft->height() - y;
+  return w > 0 && h > 0;
+}
+
+void mirror_fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color) {
+  if (!active || !clipToScreen(x, y, w, h)) return;
+  uint8_t* r = beginRecord(REC_FILL, x, y, w, h, 2);
+  put16(r + REC_HEADER, color);
+  rleRec = -1;
+}
+
+// Run-length encodes n colors into out; returns the bytes written.
+static int encodeRow(const uint16_t* px, int n, bool swap, uint8_t* out) {
+  int len = 0;
+  int litStart = -1;   // control byte of the literal run being built
+  int i = 0;
+  while (i < n) {
+    uint16_t c = swap ? px[i] : (uint16_t)(px[i] >> 8 | px[i] << 8);
+    int run = 1;
+    while (i + run < n && run < 129 && px[i + run] == px[i]) run++;
+    if (run >= 2) {
+      out[len++] = (uint8_t)(run + 126);
+      put16(out + len, c);
+      len += 2;
+      litStart = -1;
+      i += run;
+      continue;
+    }
+    if (litStart < 0 || out[litStart] == 127) {
+      litStart = len;
+      out[len++] = 0;
+    } else {
+      out[litStart]++;
+    }
+    put16(out + len, c);
+    len += 2;
+    i++;
+  }
+  return len;
+}
+
+// Adds one encoded row at (x, y) to the RLE record it continues, or to a
+// new one.
+static void addRow(int32_t x, int32_t y, int32_t w, const uint8_t* row, int rowLen) {
+  if (rleRec >= 0 && pktLen + rowLen <= PKT_MAX) {
+    uint8_t* r = pkt + rleRec;
+    int32_t rx = (int16_t)(r[1] | r[2] << 8);
+    int32_t ry = (int16_t)(r[3] | r[4] << 8);
+    int32_t rw = r[5] | r[6] << 8;
+    int32_t rh = r[7] | r[8] << 8;
+    if (rx == x && rw == w && ry + rh == y) {
+      put16(r + 7, (uint16_t)(rh + 1));
+      memcpy(pkt + pktLen, row, rowLen);
+      pktLen += rowLen;
+      return;
+    }
+  }
+  uint8_t* r = beginRecord(REC_RLE, x, y, w, 1, rowLen);
+  memcpy(r + REC_HEADER, row, rowLen);
+  rleRec = (int)(r - pkt);
+}
+
+void mirror_image(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, bool swap) {
+  if (!active || !data) return;
+  int32_t cx = x, cy = y, cw = w, ch = h;
+  if (!clipToScreen(cx, cy, cw, ch)) return;
+  static uint8_t row[ROW_BYTES_MAX];
+  for (int32_t yy = 0; yy < ch; yy++) {
+    const uint16_t* src = data + (size_t)(cy - y + yy) * w + (cx - x);
+    addRow(cx, cy + yy, cw, row, encodeRow(src, cw, swap, row));
+  }
+}
+
+static int32_t area(const Rect& r) { return r.w * r.h; }
+
+static Rect unite(const Rect& a, const Rect& b) {
+  int32_t x0 = min(a.x, b.x), y0 = min(a.y, b.y);
+  int32_t x1 = max(a.x + a.w, b.x + b.w), y1 = max(a.y + a.h, b.y + b.h);
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+static bool touches(const Rect& a, const Rect& b) {
+  return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+void mirror_dirty(int32_t x, int32_t y, int32_t w, int32_t h) {
+  if (!active || !clipToScreen(x, y, w, h)) return;
+  Rect r = {x, y, w, h};
+  // Fold in every rectangle it touches; the union may touch more.
+  for (int i = 0; i < dirtyCount;) {
+    if (touches(dirty[i], r)) {
+      r = unite(dirty[i], r);
+      dirty[i] = dirty[--dirtyCount];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+  if (dirtyCount == DIRTY_MAX) {
+    // Merge with the one that grows the least.
+    int best = 0;
+    int32_t bestGrowth = INT32_MAX;
+    for (int i = 0; i < dirtyCount; i++) {
+      int32_t g = area(unite(dirty[i], r)) - area(dirty[i]);
+      if (g < bestGrowth) { bestGrowth = g; best = i; }
+    }
+    dirty[best] = unite(dirty[best], r);
+    return;
+  }
+  dirty[dirtyCount++] = r;
+}
+
+// Starts or stops mirroring as requests come and go, and turns a full
+// frame request into one dirty rectangle.
+static void updatePeer() {
+  uint32_t req = requestMs.load(std::memory_order_acquire);
+  bool wanted = req != 0 && millis() - req < MIRROR_LEASE_MS;
+  if (!wanted) {
+    if (active) Serial.println("Mirror: stopped");
+    active = false;
+    dirtyCount = 0;
+    return;
+  }
+  uint32_t ip = peerIp.load(std::memory_order_relaxed);
+  IPAddress peer((uint8_t)ip, (uint8_t)(ip >> 8), (uint8_t)(ip >> 16), (uint8_t)(ip >> 24));
+  uint16_t port = peerPort.load(std::memory_order_relaxed);
+  bool full = fullWanted.load(std::memory_order_relaxed);
+  if (!active || peer != sendIp || port != sendPort) {
+    Serial.printf("Mirror: sending to %d.%d.%d.%d:%u\n", peer[0], peer[1], peer[2], peer[3], port);
+    sendIp = peer;
+    sendPort = port;
+    pktLen = PKT_HEADER;
+    rleRec = -1;
+    active = true;
+    full = true;
+  }
+  if (full && millis() - lastFullMs >= FULL_MIN_INTERVAL_MS) {
+    fullWanted.store(false, std::memory_order_relaxed);
+    lastFullMs = millis();
+    dirtyCount = 0;
+    mirror_dirty(0, 0, tft->width(), tft->height());
+  }
+}
+
+void mirror_flush() {
+  if (!tft) return;
+  updatePeer();
+  if (!active) return;
+
+  if (dirtyCount > 0) {
+    DisplayScope prevScope = display_stats_scope();
+    display_stats_set_scope(DS_SCOPE_MIRROR);
+    static uint16_t px[ROW_MAX];
+    static uint8_t row[ROW_BYTES_MAX];
+    int32_t budget = READ_BUDGET;
+    while (dirtyCount > 0 && budget > 0) {
+      Rect& r = dirty[0];
+      int32_t rows = min(r.h, max((int32_t)1, budget / r.w));
+      for (int32_t yy = 0; yy < rows; yy++) {
+        tft->readRect(r.x, r.y + yy, r.w, 1, px);
+        addRow(r.x, r.y + yy, r.w, row, encodeRow(px, r.w, false, row));
+      }
+      budget -= rows * r.w;
+      r.y += rows;
+      r.h -= rows;
+      if (r.h == 0) dirty[0] = dirty[--dirtyCount];
+    }
+
+    display_stats_set_scope(prevScope);
+  }
+  if (millis() - lastSendMs >= SEND_INTERVAL_MS) sendPacket();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "display.h"
+
+// Screen mirroring to the mouse bridge window.
+//
+// While a bridge has asked for it, every draw call the firmware makes on
+// the screen (see StatsTFT in display.h) is also sent to the bridge as a
+// UDP update for the rectangle it touched:
+//
+//   - fills, fast lines, rectangle outlines and pixels as a solid
+//     rectangle;
+//   - pushImage() data run-length encoded as it is pushed;
+//   - everything drawn in a way the call does not describe pixel for
+//     pixel (text, diagonal lines, circles, keyed images) as a dirty
+//     rectangle, read back from the panel and encoded in mirror_flush().
+//
+// The bridge renews its request a few times a second and asks for a full
+// frame when it missed a packet. Mirroring stops MIRROR_LEASE_MS after
+// the last request. With DISPLAY_STATS=0 there are no draw hooks and
+// nothing is mirrored.
+
+#define MIRROR_LEASE_MS 2000
+
+// display is read back from for dirty rectangles.
+void mirror_init(Display* display);
+
+// A bridge request (from the input task): keep mirroring to ip:port, and
+// resend the whole screen if full is set.
+void mirror_request(IPAddress ip, uint16_t port, bool full);
+
+// True while a bridge is subscribed; the draw hooks do nothing otherwise.
+bool mirror_active();
+
+// Draw hooks, in screen coordinates.
+void mirror_fill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+// swap is the screen's setSwapBytes() state: false means data is already
+// in SPI (big-endian) byte order.
+void mirror_image(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, bool swap);
+void mirror_dirty(int32_t x, int32_t y, int32_t w, int32_t h);
+
+// Reads back the dirty rectangles (a budget of pixels per call) and sends
+// what is pending. Called from loop() once per pass.
+void mirror_flush();
@@ -1,27 +1,40 @@
 #!/usr/bin/env python3
 # Simple mouse-to-ESP32 bridge over UDP
-# Usage: python3 mouse_bridge.py <ESP32_IP>
+# Usage: python3 mouse_bridge.py <ESP32_IP> [--keys]
 # Example: python3 mouse_bridge.py 192.168.1.42
+#
+# With --keys, everything typed anywhere on the laptop is typed on the
+# device too.
 
-import socket
 import sys
+import threading
 import time
 
 try:
-    from pynput import mouse
+    from pynput import keyboard, mouse
 except ImportError:
     print("Missing dependency: pynput")
     print("Install with: pip3 install pynput")
     sys.exit(1)
 
-if len(sys.argv) < 2:
-    print("Usage: python3 mouse_bridge.py <ESP32_IP>")
+from bridge_protocol import (PointerSender, KeySender, ESP32_PORT,
+                             BUTTON_LEFT, BUTTON_MIDDLE, BUTTON_RIGHT)
+
+args = [a for a in sys.argv[1:] if not a.startswith("--")]
+if not args:
+    print("Usage: python3 mouse_bridge.py <ESP32_IP> [--keys]")
     sys.exit(1)
 
-ESP32_IP = sys.argv[1]
-ESP32_PORT = 4210
+ESP32_IP = args[0]
+KEYS = "--keys" in sys.argv
+
+# Packets per second at most; OS events in between are batched.
+SEND_HZ = 100
 
-sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+sender = PointerSender(ESP32_IP)
+keys = KeySender(sender)
+# pynput calls back on its own thread.
+lock = threading.Lock()
 
 # Screen size from OS (approx) - use pynput for current position only.
 # We'll map full desktop to 320x240.
@@ -36,47 +49,75 @@ except Exception:
     SCREEN_W = 1920
     SCREEN_H = 1080
 
-state = {
-    "x": 0,
-    "y": 0,
-    "pressed": 0,
+BUTTONS = {
+    mouse.Button.left: BUTTON_LEFT,
+    mouse.Button.middle: BUTTON_MIDDLE,
+    mouse.Button.right: BUTTON_RIGHT,
 }
 
+state = {"buttons": 0}
+
 
 def clamp(v, lo, hi):
     return lo if v < lo else hi if v > hi else v
 
 
-def send_state():
-    x = int(state["x"] * 320 / max(1, SCREEN_W - 1))
-    y = int(state["y"] * 240 / max(1, SCREEN_H - 1))
-    x = clamp(x, 0, 319)
-    y = clamp(y, 0, 239)
-    p = 1 if state["pressed"] else 0
-    msg = f"{x},{y},{p}".encode("utf-8")
-    sock.sendto(msg, (ESP32_IP, ESP32_PORT))
+def to_device(x, y):
+    dx = clamp(int(x * 320 / max(1, SCREEN_W - 1)), 0, 319)
+    dy = clamp(int(y * 240 / max(1, SCREEN_H - 1)), 0, 239)
+    return dx, dy
 
 
 def on_move(x, y):
-    state["x"] = x
-    state["y"] = y
-    send_state()
+    with lock:
+        sender.move(*to_device(x, y))
 
 
 def on_click(x, y, button, pressed):
-    state["x"] = x
-    state["y"] = y
-    state["pressed"] = 1 if pressed else 0
-    send_state()
+    bit = BUTTONS.get(button, 0)
+    with lock:
+        sender.move(*to_device(x, y))
+        if pressed:
+            state["buttons"] |= bit
+        else:
+            state["buttons"] &= ~bit
+        sender.set_buttons(state["buttons"])
+
+
+def on_scroll(x, y, dx, dy):
+    with lock:
+        sender.wheel(dy)
+
+
+def on_press(key):
+    with lock:
+        if key == keyboard.Key.backspace:
+            keys.backspace()
+        elif key == keyboard.Key.enter:
+            keys.enter()
+        elif key == keyboard.Key.space:
+            keys.type(" ")
+        elif getattr(key, "char", None):
+            keys.type(key.char)
 
 
 print(f"Sending mouse to {ESP32_IP}:{ESP32_PORT} (screen {SCREEN_W}x{SCREEN_H})")
+if KEYS:
+    print("Sending keys too")
 print("Press Ctrl+C to stop")
 
-with mouse.Listener(on_move=on_move, on_click=on_click) as listener:
+key_listener = keyboard.Listener(on_press=on_press) if KEYS else None
+if key_listener:
+    key_listener.start()
+
+with mouse.Listener(on_move=on_move, on_click=on_click, on_scroll=on_scroll) as listener:
     try:
         while True:
-            time.sleep(1)
+            with lock:
+                sender.pump()
+                for pkt in sender.receive():
+                    keys.handle(pkt)
+                keys.pump()
+            time.sleep(1.0 / SEND_HZ)
     except KeyboardInterrupt:
         pass
-
@@ -1,9 +1,16 @@
 #!/usr/bin/env python3
 # Mouse bridge using a local window (no system-wide hooks)
-# Usage: python3 mouse_bridge_window.py <ESP32_IP>
+# Usage: python3 mouse_bridge_window.py <ESP32_IP> [--mirror]
+#
+# Typing in the window types into the text field of the app on screen;
+# Ctrl+V pastes the clipboard.
+#
+# With --mirror the window shows the device screen, rebuilt from the
+# rectangles it redraws. Press F1 to flash every redrawn rectangle (redraw
+# hot spots light up).
 
-import socket
 import sys
+import time
 
 try:
     import pygame
@@ -12,59 +19,136 @@ except ImportError:
     print("Install with: pip3 install pygame")
     sys.exit(1)
 
-if len(sys.argv) < 2:
-    print("Usage: python3 mouse_bridge_window.py <ESP32_IP>")
-    sys.exit(1)
+from bridge_protocol import (PointerSender, KeySender, MirrorFrame, ESP32_PORT, MIRROR_RENEW_S,
+                             BUTTON_LEFT, BUTTON_MIDDLE, BUTTON_RIGHT)
 
-ESP32_IP = sys.argv[1]
-ESP32_PORT = 4210
+args = [a for a in sys.argv[1:] if not a.startswith("--")]
+if not args:
+    print("Usage: python3 mouse_bridge_window.py <ESP32_IP> [--mirror]")
+    sys.exit(1)
 
-sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+ESP32_IP = args[0]
+MIRROR = "--mirror" in sys.argv
 
 WIDTH, HEIGHT = 320, 240
 SCALE = 2
 WIN_W, WIN_H = WIDTH * SCALE, HEIGHT * SCALE
+# Packets per second at most; every motion event in between is batched.
+SEND_HZ = 100
+# How long a redrawn rectangle stays lit in the hot spot view.
+HEAT_S = 0.5
+
+BUTTONS = {1: BUTTON_LEFT, 2: BUTTON_MIDDLE, 3: BUTTON_RIGHT}
+
+sender = PointerSender(ESP32_IP)
+keys = KeySender(sender)
+frame = MirrorFrame(WIDTH, HEIGHT)
 
 pygame.init()
 screen = pygame.display.set_mode((WIN_W, WIN_H))
 pygame.display.set_caption("ESP32 Mouse Bridge (click + drag inside)")
 clock = pygame.time.Clock()
+pygame.key.start_text_input()
+try:
+    pygame.scrap.init()
+except (AttributeError, pygame.error):
+    pass
+
+
+def to_device(pos):
+    x = min(max(int(pos[0] / SCALE), 0), WIDTH - 1)
+    y = min(max(int(pos[1] / SCALE), 0), HEIGHT - 1)
+    return x, y
+
+
+def clipboard_text():
+    try:
+        if hasattr(pygame.scrap, "get_text"):
+            return pygame.scrap.get_text()
+        data = pygame.scrap.get(pygame.SCRAP_TEXT)
+    except (AttributeError, pygame.error):
+        return ""
+    if not data:
+        return ""
+    return data.decode("utf-8", "ignore").rstrip("\0")
+
+
+def draw_heat(updates, now):
+    overlay = pygame.Surface((WIN_W, WIN_H), pygame.SRCALPHA)
+    for t, (x, y, w, h) in updates:
+        alpha = int(160 * (1.0 - (now - t) / HEAT_S))
+        if alpha > 0:
+            overlay.fill((255, 0, 0, alpha), (x * SCALE, y * SCALE, w * SCALE, h * SCALE))
+    screen.blit(overlay, (0, 0))
 
-pressed = False
-wheel_delta = 0
 
 print(f"Sending mouse to {ESP32_IP}:{ESP32_PORT}")
-print("Use mouse inside this window. Close window to stop.")
+print("Use mouse and keyboard inside this window. Close window to stop.")
+if MIRROR:
+    print("Mirroring the screen; press F1 to show redraws")
 
+buttons = 0
+show_heat = False
+heat = []
+need_full = True
+renewed_at = 0.0
 running = True
 while running:
     for event in pygame.event.get():
         if event.type == pygame.QUIT:
             running = False
-        elif event.type == pygame.MOUSEBUTTONDOWN:
-            pressed = True
-        elif event.type == pygame.MOUSEBUTTONUP:
-            pressed = False
+        elif event.type == pygame.KEYDOWN:
+            if event.key == pygame.K_F1:
+                show_heat = not show_heat
+            elif event.key == pygame.K_v and event.mod & (pygame.KMOD_CTRL | pygame.KMOD_META):
+                keys.type(clipboard_text())
+            elif event.key == pygame.K_BACKSPACE:
+                keys.backspace()
+            elif event.key in (pygame.K_RETURN, pygame.K_KP_ENTER):
+                keys.enter()
+        elif event.type == pygame.TEXTINPUT:
+            keys.type(event.text)
+        elif event.type == pygame.MOUSEMOTION:
+            sender.move(*to_device(event.pos))
+        elif event.type in (pygame.MOUSEBUTTONDOWN, pygame.MOUSEBUTTONUP):
+            bit = BUTTONS.get(event.button)
+            if bit is None:
+                continue   # wheel clicks also arrive as buttons 4 and 5
+            sender.move(*to_device(event.pos))
+            if event.type == pygame.MOUSEBUTTONDOWN:
+                buttons |= bit
+            else:
+                buttons &= ~bit
+            sender.set_buttons(buttons)
         elif event.type == pygame.MOUSEWHEEL:
-            wheel_delta += event.y
+            sender.wheel(event.y)
+    sender.pump()
+    keys.pump()
+
+    now = time.monotonic()
+    for pkt in sender.receive():
+        if not keys.handle(pkt) and MIRROR and not frame.apply(pkt):
+            need_full = True
+    if MIRROR:
+        if need_full or now - renewed_at >= MIRROR_RENEW_S:
+            sender.request_mirror(full=need_full)
+            need_full = False
+            renewed_at = now
+        heat = [(t, r) for t, r in heat if now - t < HEAT_S]
+        heat += [(now, r) for r in frame.take_updates()]
 
     mx, my = pygame.mouse.get_pos()
-    x = int(mx / SCALE)
-    y = int(my / SCALE)
-    if x < 0: x = 0
-    if y < 0: y = 0
-    if x > 319: x = 319
-    if y > 239: y = 239
-
-    msg = f"{x},{y},{1 if pressed else 0},{wheel_delta}".encode("utf-8")
-    wheel_delta = 0
-    sock.sendto(msg, (ESP32_IP, ESP32_PORT))
-
-    # simple UI
-    screen.fill((30, 60, 120))
-    pygame.draw.rect(screen, (255, 255, 255), (0, 0, WIN_W-1, WIN_H-1), 1)
-    pygame.draw.circle(screen, (255, 255, 255), (mx, my), 4)
+    if MIRROR:
+        image = pygame.image.frombuffer(bytes(frame.rgb), (WIDTH, HEIGHT), "RGB")
+        screen.blit(pygame.transform.scale(image, (WIN_W, WIN_H)), (0, 0))
+        if show_heat:
+            draw_heat(heat, now)
+    else:
+        # simple UI
+        screen.fill((30, 60, 120))
+        pygame.draw.rect(screen, (255, 255, 255), (0, 0, WIN_W-1, WIN_H-1), 1)
+        pygame.draw.circle(screen, (255, 255, 255), (mx, my), 4)
     pygame.display.flip()
-    clock.tick(60)
+    clock.tick(SEND_HZ)
 
 pygame.quit()
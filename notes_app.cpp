@@ -1,10 +1,16 @@
 #include "notes_app.h"
 #include "keyboard.h"
 #include "system_ui.h"
-#include <Preferences.h>
+#include "text_layout.h"
+#include "notes_store.h"
+#include "persist.h"
+#include "gesture.h"
+#include "kinetic_scroll.h"
+#include "input.h"
+#include "app_arena.h"
 #include <Arduino.h>
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 
 static const int SCREEN_W = 320;
 static const int SCREEN_H = 240;
@@ -29,138 +35,39 @@ static const int LINE_H = 16;
 static const int TEXT_X = 6;
 static const int TEXT_W = 308;
 
-static const char* NVS_NS = "notes";
-static const char* NVS_KEY = "text";
-
 static uint32_t lastStatusTick = 0;
-static bool dragging = false;
-static int dragLastY = 0;
-static int dragAccum = 0;
+// Text area gestures. While `scrolling` the view belongs to the kinetic
+// scroller, drawn at pixel offsets without the caret; once it comes to
+// rest it snaps to a whole line and scrollLine takes over again.
+static GestureTracker gesture;
+static KineticScroll kinetic;
+static bool scrolling = false;
+static bool caughtFling = false;   // the current press stopped a fling
 static const char* statusMsg = "";
+static char statusBuf[32];
 static uint32_t statusMsgUntil = 0;
 static int statusLine = 1;
 static int statusCol = 1;
 
-#define NOTES_MAX KB_TEXT_MAX
-#define WRAP_MAX_LINES 100
-#define WRAP_LINE_MAX 44
+// Every line but the last uses up at least one byte, so a full note
+// never runs out of lines.
+#define WRAP_MAX_LINES (NOTES_CAP + 1)
+#define WRAP_LINE_MAX 160
+
+// Line table of the layout; from the app arena while Notes is open.
+static uint16_t* lineStarts = nullptr;
+static_assert(WRAP_MAX_LINES * sizeof(uint16_t) + NOTES_CAP <= APP_ARENA_BYTES,
+              "Notes' line table and text must fit in the app arena");
+static TextLayout layout;
 
-static char notesText[NOTES_MAX + 1];
-static char wrapLinesBuf[WRAP_MAX_LINES][WRAP_LINE_MAX];
-static int wrapCount = 0;
+// Line the caret is drawn on (-1: not drawn) and its x.
+static int caretRow = -1;
+static int caretX = 0;
 
 static inline bool inRect(int x,int y,int rx,int ry,int rw,int rh){
   return (x>=rx && x<rx+rw && y>=ry && y<ry+rh);
 }
 
-static void nvsLoad() {
-  Preferences p;
-  p.begin(NVS_NS, true);
-  size_t len = p.getBytesLength(NVS_KEY);
-  if (len > 0 && len <= (size_t)(NOTES_MAX + 1)) {
-    p.getBytes(NVS_KEY, notesText, len);
-    notesText[min((size_t)NOTES_MAX, len - 1)] = 0;
-  } else {
-    notesText[0] = 0;
-  }
-  p.end();
-}
-
-static void nvsSave() {
-  Preferences p;
-  p.begin(NVS_NS, false);
-  size_t len = strnlen(notesText, NOTES_MAX);
-  notesText[len] = 0;
-  p.putBytes(NVS_KEY, notesText, len + 1);
-  p.end();
-}
-
-static void wrapText(const char* s, int maxW) {
-  wrapCount = 0;
-  char line[WRAP_LINE_MAX] = {0};
-  char word[WRAP_LINE_MAX] = {0};
-  int lineLen = 0;
-  int wordLen = 0;
-
-  auto pushLine = [&](const char* ln) {
-    if (wrapCount >= WRAP_MAX_LINES) return;
-    strncpy(wrapLinesBuf[wrapCount], ln, WRAP_LINE_MAX - 1);
-    wrapLinesBuf[wrapCount][WRAP_LINE_MAX - 1] = 0;
-    wrapCount++;
-  };
-
-  auto flushWord = [&]() {
-    if (wordLen == 0) return;
-
-    if (lineLen == 0 && tft->textWidth(word, 2) > maxW) {
-      char chunk[WRAP_LINE_MAX] = {0};
-      int chunkLen = 0;
-      for (int i = 0; i < wordLen; i++) {
-        if (chunkLen >= WRAP_LINE_MAX - 1) {
-          pushLine(chunk);
-          chunk[0] = 0;
-          chunkLen = 0;
-        }
-        chunk[chunkLen++] = word[i];
-        chunk[chunkLen] = 0;
-        if (tft->textWidth(chunk, 2) > maxW) {
-          chunk[chunkLen - 1] = 0;
-          pushLine(chunk);
-          chunk[0] = word[i];
-          chunk[1] = 0;
-          chunkLen = 1;
-        }
-      }
-      if (chunkLen > 0) pushLine(chunk);
-      word[0] = 0;
-      wordLen = 0;
-      return;
-    }
-
-    char test[WRAP_LINE_MAX] = {0};
-    if (lineLen == 0) {
-      strncpy(test, word, WRAP_LINE_MAX - 1);
-    } else {
-      snprintf(test, sizeof(test), "%s %s", line, word);
-    }
-
-    if (tft->textWidth(test, 2) <= maxW) {
-      strncpy(line, test, WRAP_LINE_MAX - 1);
-      line[WRAP_LINE_MAX - 1] = 0;
-      lineLen = strlen(line);
-    } else {
-      if (lineLen > 0) pushLine(line);
-      strncpy(line, word, WRAP_LINE_MAX - 1);
-      line[WRAP_LINE_MAX - 1] = 0;
-      lineLen = wordLen;
-    }
-
-    word[0] = 0;
-    wordLen = 0;
-  };
-
-  for (int i = 0; s[i] != 0; i++) {
-    char c = s[i];
-    if (c == '\n') {
-      flushWord();
-      if (lineLen > 0) pushLine(line);
-      line[0] = 0;
-      lineLen = 0;
-      continue;
-    }
-    if (c == ' ') {
-      flushWord();
-      continue;
-    }
-    if (wordLen >= WRAP_LINE_MAX - 1) flushWord();
-    word[wordLen++] = c;
-    word[wordLen] = 0;
-  }
-
-  flushWord();
-  if (lineLen > 0) pushLine(line);
-}
-
 static void drawHeader() {
   tft->fillRect(0, 0, SCREEN_W, HEADER_H, 0x047F);
   tft->fillRect(0, 0, SCREEN_W, HEADER_H/2, 0x1C9F);
@@ -200,53 +107,273 @@ static void drawStatusBar() {
   }
   // No Ln/Col per request
 }
-static void drawTextArea() {
-  tft->fillRect(0, textTop, SCREEN_W, textBottom - textTop, TFT_WHITE);
+// The store's buffer, with the layout told where its gap is now.
+static const char* storeText() {
+  int gapAt, gapLen;
+  const char* text = notes_store_text(&gapAt, &gapLen);
+  text_layout_set_gap(&layout, gapAt, gapLen);
+  return text;
+}
+
+// Lays out the whole text again, after it was replaced.
+static void relayoutText() {
+  text_layout_set(&layout, storeText(), notes_store_length());
+  totalLines = layout.count;
+}
+
+// Draws rows [from, to) of the window scrolled to scrollLine; rows past
+// the end of the text are blanked. Glyphs paint their own background, so
+// each row only clears what its text does not cover.
+static void drawTextRows(int from, int to) {
+  char line[WRAP_LINE_MAX];
+  tft->setTextColor(TFT_BLACK, TFT_WHITE);
+  for (int i = from; i < to; i++) {
+    int y = textTop + 2 + (i - scrollLine) * LINE_H;
+    int w = 0;
+    if (i < layout.count) {
+      text_layout_copy_line(&layout, i, line, sizeof(line));
+      w = tft->drawString(line, TEXT_X, y, 2);
+    }
+    tft->fillRect(TEXT_X + w, y, SCREEN_W - TEXT_X - w, LINE_H, TFT_WHITE);
+  }
+  if (caretRow >= from && caretRow < to) caretRow = -1;
+}
+
+// Draws the caret as a 1 px bar before the cursor byte, first repainting
+// the row the old one is on unless a text repaint already did.
+static void drawCaret() {
+  int pos = notes_store_cursor();
+  int line = text_layout_line_at(&layout, pos);
+  int x = min(TEXT_X + text_layout_x_of(&layout, pos), SCREEN_W - 2);
+  if (caretRow == line && caretX == x) return;
 
-  const char* text = keyboard_get_text();
-  wrapText(text, TEXT_W);
+  if (caretRow >= scrollLine && caretRow < scrollLine + visibleLines) {
+    drawTextRows(caretRow, caretRow + 1);
+  }
+  caretRow = -1;
+  if (line < scrollLine || line >= scrollLine + visibleLines) return;
+  int y = textTop + 2 + (line - scrollLine) * LINE_H;
+  tft->drawFastVLine(x, y, LINE_H - 2, TFT_BLACK);
+  caretRow = line;
+  caretX = x;
+}
 
+static void drawTextArea() {
   visibleLines = (textBottom - textTop) / LINE_H;
-  totalLines = max(1, wrapCount);
-  int maxScroll = max(0, totalLines - visibleLines);
-  scrollLine = constrain(scrollLine, 0, maxScroll);
+  totalLines = layout.count;
+  TextWindow win = text_layout_window(&layout, scrollLine, visibleLines);
+  scrollLine = win.first;
+
+  int rowsBottom = textTop + 2 + visibleLines * LINE_H;
+  tft->fillRect(0, textTop, SCREEN_W, 2, TFT_WHITE);
+  tft->fillRect(0, textTop + 2, TEXT_X, rowsBottom - textTop - 2, TFT_WHITE);
+  caretRow = -1;
+  drawTextRows(win.first, win.first + visibleLines);
+  if (rowsBottom < textBottom) {
+    tft->fillRect(0, rowsBottom, SCREEN_W, textBottom - rowsBottom, TFT_WHITE);
+  }
+  drawCaret();
+}
 
-  int first = scrollLine;
-  int last = scrollLine + visibleLines;
+// `delta` bytes were inserted (> 0) or removed (< 0) at `from`. Only the
+// lines from the edited one until the breaks match the old layout are
+// wrapped again, and only their rows are repainted, so a keystroke costs
+// the same on a long note as on a short one.
+static void textEdited(int from, int delta) {
+  int oldCount = layout.count;
+  int changedEnd;
+  int first = text_layout_update(&layout, storeText(), notes_store_length(),
+                                 from, delta, &changedEnd);
+  totalLines = layout.count;
+
+  if (text_layout_window(&layout, scrollLine, visibleLines).first != scrollLine) {
+    drawTextArea();   // the text got shorter than the scroll position
+    return;
+  }
+  int last = (layout.count == oldCount) ? changedEnd : max(layout.count, oldCount);
+  drawTextRows(max(first, scrollLine), min(last, scrollLine + visibleLines));
+}
 
-  int y = textTop + 2;
-  int lineIndex = 0;
-  tft->setTextColor(TFT_BLACK, TFT_WHITE);
+static void drawScrolledRow(TFT_eSPI* g, int row, int y) {
+  char line[WRAP_LINE_MAX];
+  text_layout_copy_line(&layout, row, line, sizeof(line));
+  g->setTextColor(TFT_BLACK, TFT_WHITE);
+  g->drawString(line, TEXT_X, y, 2);
+}
+
+static void drawScrolled() {
+  KineticView v = {0, textTop + 2, SCREEN_W, visibleLines * LINE_H, LINE_H, layout.count,
+                   TFT_WHITE, drawScrolledRow};
+  kinetic_render(tft, &v, kinetic.pos);
+  caretRow = -1;
+}
+
+static void startScroll() {
+  if (scrolling) return;
+  kinetic_reset(&kinetic, scrollLine * LINE_H, max(0, layout.count - visibleLines) * LINE_H);
+  scrolling = true;
+}
+
+// Hands the view back to the line-based drawing at the nearest line.
+static void settleScroll() {
+  if (!scrolling) return;
+  scrolling = false;
+  kinetic_stop(&kinetic);
+  scrollLine = (kinetic.pos + LINE_H / 2) / LINE_H;
+  drawTextArea();
+}
+
+// Scrolls the cursor's line into view after typing, else just moves the
+// caret.
+static void followCaret() {
+  int line = text_layout_line_at(&layout, notes_store_cursor());
+  if (line < scrollLine || line >= scrollLine + visibleLines) {
+    scrollLine = (line < scrollLine) ? line : line - visibleLines + 1;
+    drawTextArea();
+  } else {
+    drawCaret();
+  }
+}
 
-  for (int i = 0; i < wrapCount; i++) {
-    if (lineIndex >= first && lineIndex < last) {
-      tft->drawString(wrapLinesBuf[i], TEXT_X, y, 2);
-      y += LINE_H;
+static void showStatus(const char* msg) {
+  statusMsg = msg;
+  statusMsgUntil = millis() + 1500;
+  drawStatusBar();
+}
+
+// Keyboard edits, applied at the cursor (see keyboard_set_editor()).
+static void editText(char c) {
+  settleScroll();
+  int pos = notes_store_cursor();
+  persist_mark_dirty(PERSIST_NOTES);
+  if (c == 0) {
+    notes_store_clear();
+    relayoutText();
+    scrollLine = 0;
+    drawTextArea();
+    return;
+  }
+  if (c == '\b') {
+    if (!notes_store_backspace()) return;
+    textEdited(pos - 1, -1);
+  } else {
+    if (!notes_store_insert(c)) {
+      showStatus("Note is full");
+      return;
+    }
+    textEdited(pos, 1);
+  }
+  followCaret();
+}
+
+// Keys typed on the bridge. Runs of characters and of deletes are each
+// one edit of the layout and one repaint, so a pasted paragraph costs
+// about what a keystroke does.
+void notes_app_keys(const char* keys, int n) {
+  if (!openState || !tft) return;
+  settleScroll();
+  bool full = false, edited = false;
+  for (int i = 0; i < n;) {
+    int pos = notes_store_cursor();
+    int k = 0;
+    if (keys[i] == INPUT_KEY_BACKSPACE) {
+      for (; i < n && keys[i] == INPUT_KEY_BACKSPACE; i++) {
+        if (notes_store_backspace()) k++;
+      }
+      if (k > 0) { textEdited(pos - k, -k); edited = true; }
+    } else {
+      // INPUT_KEY_ENTER is '\n', a line break in a note.
+      for (; i < n && keys[i] != INPUT_KEY_BACKSPACE; i++) {
+        char c = keys[i];
+        if (c != INPUT_KEY_ENTER && (c < ' ' || c > '~')) continue;
+        if (notes_store_insert(c)) k++;
+        else full = true;
+      }
+      if (k > 0) { textEdited(pos, k); edited = true; }
     }
-    lineIndex++;
-    if (lineIndex >= last) break;
   }
+  if (edited) persist_mark_dirty(PERSIST_NOTES);
+  if (full) showStatus("Note is full");
+  followCaret();
+}
+
+// Moves the cursor to the tapped spot.
+static void placeCursor(int x, int y) {
+  int line = scrollLine + (y - textTop - 2) / LINE_H;
+  if (line >= layout.count) notes_store_set_cursor(notes_store_length());
+  else notes_store_set_cursor(text_layout_offset_at(&layout, max(line, 0), x - TEXT_X));
+  drawCaret();
+}
+
+static void saveNotes() {
+  int n = notes_store_save();
+  snprintf(statusBuf, sizeof(statusBuf), "Saved (%d block%s written)", n, n == 1 ? "" : "s");
+  showStatus(statusBuf);
+}
+
+// Autosave (see persist.h).
+static void commitNotes() {
+  notes_store_save();
+}
+
+static void handleGesture(const GestureEvent& g) {
+  switch (g.type) {
+    case GESTURE_TAP:
+    case GESTURE_DOUBLE_TAP:
+      if (!caughtFling) placeCursor(g.x, g.y);
+      break;
+    case GESTURE_DRAG:
+      startScroll();
+      kinetic_drag(&kinetic, g.dy);
+      break;
+    case GESTURE_FLING:
+      kinetic_fling(&kinetic, g.vy, input_time());
+      break;
+    default:
+      break;
+  }
+}
+
+static void closeNotes() {
+  keyboard_set_editor(nullptr);
+  gesture_reset(&gesture);
+  scrolling = false;
+  openState = false;
+}
+
+void notes_app_close() {
+  closeNotes();
+  kinetic_release();
+  notes_store_close();
+  lineStarts = nullptr;
 }
 
 void notes_app_scroll_steps(int steps) {
+  settleScroll();
   int maxScroll = max(0, totalLines - visibleLines);
   scrollLine = constrain(scrollLine - steps, 0, maxScroll);
   drawTextArea();
 }
 
-void notes_app_init(TFT_eSPI* display) {
+void notes_app_init(Display* display) {
   tft = display;
+  persist_register(PERSIST_NOTES, commitNotes);
 }
 
 void notes_app_open() {
   if (!tft) return;
   openState = true;
 
-  nvsLoad();
-  keyboard_set_text(notesText);
+  lineStarts = (uint16_t*)app_arena_alloc(WRAP_MAX_LINES * sizeof(uint16_t));
+  text_layout_init(&layout, lineStarts, WRAP_MAX_LINES, TEXT_W, 2);
+  notes_store_open();
+  keyboard_set_editor(editText);
+  relayoutText();
   kbVisible = true;
   keyboard_set_visible(true);
   scrollLine = 0;
+  scrolling = false;
+  gesture_reset(&gesture);
 
   textBottom = SCREEN_H - STATUS_H - 2;
   if (kbVisible) textBottom = KB_Y - STATUS_H - 2;
@@ -267,6 +394,20 @@ void notes_app_tick() {
     system_ui_tick(SCREEN_W - 92 - 22, 2, 0x047F);
     lastStatusTick = now;
   }
+  if (scrolling) {
+    if (kinetic_frame(&kinetic, now)) drawScrolled();
+    if (!gesture_active(&gesture) && !kinetic_moving(&kinetic)) settleScroll();
+  }
+  // Page in the rest of the note, a block per tick (not while the view
+  // is moving: the rows on screen are not at line positions).
+  if (!notes_store_loaded() && !scrolling) {
+    int oldLen = notes_store_length();
+    int added = notes_store_load_more();
+    if (added > 0) {
+      textEdited(oldLen, added);
+      drawCaret();
+    }
+  }
   if (statusMsgUntil && now > statusMsgUntil) {
     statusMsgUntil = 0;
     statusMsg = "";
@@ -277,56 +418,64 @@ void notes_app_tick() {
 bool notes_app_handleTouch(bool pressed, bool lastPressed, int x, int y) {
   if (!openState || !tft) return false;
 
+  // A gesture in the text area keeps the pointer until it is released,
+  // wherever the finger goes.
+  if (gesture_active(&gesture)) {
+    GestureEvent g;
+    if (gesture_feed(&gesture, pressed, x, y, input_time(), &g)) handleGesture(g);
+    if (pressed) return true;
+  }
+  bool inText = inRect(x, y, 0, textTop, SCREEN_W, textBottom - textTop);
+  if (pressed && !lastPressed && scrolling) {
+    // Touching the text catches a fling; anything else ends it first.
+    caughtFling = inText;
+    if (inText) kinetic_stop(&kinetic);
+    else settleScroll();
+  } else if (pressed && !lastPressed) {
+    caughtFling = false;
+  }
+
   if (pressed && kbVisible) {
+    // Edits reach the text through editText().
     KB_Action tickA = keyboard_tick(true, x, y);
-    if (tickA == KB_CHANGED) {
-      drawTextArea();
-      return true;
-    }
+    if (tickA == KB_CHANGED) return true;
   }
 
   if (pressed && !lastPressed && inRect(x, y, SCREEN_W - 52, 5, 46, 16)) {
-    openState = false;
+    closeNotes();
     return false;
   }
 
   int ty = HEADER_H;
   if (pressed && !lastPressed && inRect(x, y, SCREEN_W - 18, 1, 16, 16)) {
-    // Auto-save on exit
-    strncpy(notesText, keyboard_get_text(), NOTES_MAX);
-    notesText[NOTES_MAX] = 0;
-    nvsSave();
-    openState = false;
+    // Unsaved edits are flushed when the sketch leaves the app.
+    closeNotes();
     return false;
   }
 
   int menuY = HEADER_H;
   // Save/Load/Clear/Hide menu items
   if (pressed && !lastPressed && inRect(x, y, 4, menuY + 2, 42, MENU_H)) {
-    strncpy(notesText, keyboard_get_text(), NOTES_MAX);
-    notesText[NOTES_MAX] = 0;
-    nvsSave();
-    statusMsg = "Saved";
-    statusMsgUntil = millis() + 1500;
-    drawStatusBar();
+    saveNotes();
     return true;
   }
   if (pressed && !lastPressed && inRect(x, y, 48, menuY + 2, 42, MENU_H)) {
-    nvsLoad();
-    keyboard_set_text(notesText);
+    // Edits not written yet are saved first rather than thrown away.
+    persist_flush();
+    notes_store_open();
+    relayoutText();
+    scrollLine = 0;
     drawTextArea();
-    statusMsg = "Loaded";
-    statusMsgUntil = millis() + 1500;
-    drawStatusBar();
+    showStatus("Loaded");
     return true;
   }
   if (pressed && !lastPressed && inRect(x, y, 92, menuY + 2, 46, MENU_H)) {
-    notesText[0] = 0;
-    keyboard_clear();
+    notes_store_clear();
+    persist_mark_dirty(PERSIST_NOTES);
+    relayoutText();
+    scrollLine = 0;
     drawTextArea();
-    statusMsg = "Cleared";
-    statusMsgUntil = millis() + 1500;
-    drawStatusBar();
+    showStatus("Cleared");
     return true;
   }
   if (pressed && !lastPressed && inRect(x, y, 146, menuY + 2, 56, MENU_H)) {
@@ -342,38 +491,21 @@ bool notes_app_handleTouch(bool pressed, bool lastPressed, int x, int y) {
     return true;
   }
 
-  // Scroll by dragging in text area
-  if (pressed && inRect(x, y, 0, textTop, SCREEN_W, textBottom - textTop)) {
-    if (!dragging) {
-      dragging = true;
-      dragLastY = y;
-      dragAccum = 0;
-      return true;
-    }
-    int dy = y - dragLastY;
-    dragLastY = y;
-    dragAccum += dy;
-    if (abs(dragAccum) >= LINE_H) {
-      int steps = dragAccum / LINE_H;
-      dragAccum -= steps * LINE_H;
-      int maxScroll = max(0, totalLines - visibleLines);
-      scrollLine = constrain(scrollLine - steps, 0, maxScroll);
-      drawTextArea();
-    }
+  // In the text area a tap moves the cursor, a drag scrolls and a fling
+  // keeps it going.
+  if (pressed && !lastPressed && inText) {
+    GestureEvent g;
+    gesture_feed(&gesture, true, x, y, input_time(), &g);
     return true;
   }
 
   if (!pressed && lastPressed) {
-    dragging = false;
-    dragAccum = 0;
     keyboard_release();
   }
 
   if (kbVisible && pressed && !lastPressed) {
     KB_Action a = keyboard_touch(x, y);
-    if (a == KB_CHANGED) {
-      drawTextArea();
-    } else if (a == KB_REDRAW) {
+    if (a == KB_REDRAW) {
       keyboard_draw();
     } else if (a == KB_HIDE) {
       kbVisible = false;
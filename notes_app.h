@@ -1,9 +1,14 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "display.h"
 
-void notes_app_init(TFT_eSPI* display);
+void notes_app_init(Display* display);
 void notes_app_open();
+// Another app comes to the front: the note is saved and its buffers go
+// back to the app arena.
+void notes_app_close();
 void notes_app_tick();
 bool notes_app_handleTouch(bool pressed, bool lastPressed, int x, int y);
 bool notes_app_is_open();
 void notes_app_scroll_steps(int steps);
+// Keys typed on the bridge (input_poll_keys()), inserted at the cursor.
+void notes_app_keys(const char* keys, int n);
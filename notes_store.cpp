@@ -0,0 +1,354 @@
+#include "notes_store.h"
+#include "app_arena.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <Arduino.h>
+
+static const char* DIR_PATH = "/notes";
+static const char* IDX_PATH = "/notes/note.idx";
+static const char* IDX_TMP_PATH = "/notes/note.idx.tmp";
+static const char* BLK_PATH = "/notes/note.blk";
+static const uint32_t IDX_MAGIC = 0x3149544E;   // "NTI1"
+
+// Where notes lived before they moved to LittleFS.
+static const char* LEGACY_NS = "notes";
+static const char* LEGACY_KEY = "text";
+
+#define BLOCK_DATA (NOTES_BLOCK - 2)
+#define MAX_BLOCKS 128
+// Room for every block in RAM to move while the index on disk still
+// holds on to its old slot.
+#define MAX_SLOTS (2 * MAX_BLOCKS)
+
+// Text is buf[0, gapStart) followed by buf[gapEnd, NOTES_CAP). The gap
+// only moves when an edit lands somewhere else than the last one did.
+// buf is in the app arena while the store is open, nullptr otherwise.
+static char* buf = nullptr;
+static int gapStart = 0;
+static int gapEnd = NOTES_CAP;
+static int cursorPos = 0;
+
+struct Block {
+  uint16_t slot;    // position in note.blk, in NOTES_BLOCK units
+  uint16_t len;     // bytes of text, valid once loaded
+  bool dirty;
+};
+
+// Blocks in text order; [0, loadedBlocks) are in buf.
+static Block blocks[MAX_BLOCKS];
+static int blockCount = 0;
+static int loadedBlocks = 0;
+// Slots the blocks above use, and slots the index on disk lists. A save
+// that changes the index never writes into a slot of the second kind, so
+// until the new index is in place the old one still reads the old text.
+static bool slotUsed[MAX_SLOTS];
+static bool slotOnDisk[MAX_SLOTS];
+static bool indexDirty = false;
+static bool legacyPending = false;
+
+int notes_store_length() { return NOTES_CAP - (gapEnd - gapStart); }
+int notes_store_cursor() { return cursorPos; }
+bool notes_store_loaded() { return loadedBlocks == blockCount; }
+
+void notes_store_set_cursor(int pos) {
+  cursorPos = constrain(pos, 0, notes_store_length());
+}
+
+const char* notes_store_text(int* gapAt, int* gapLen) {
+  *gapAt = gapStart;
+  *gapLen = gapEnd - gapStart;
+  return buf;
+}
+
+static void moveGap(int pos) {
+  if (pos < gapStart) {
+    int n = gapStart - pos;
+    memmove(buf + gapEnd - n, buf + pos, n);
+    gapStart -= n;
+    gapEnd -= n;
+  } else if (pos > gapStart) {
+    int n = pos - gapStart;
+    memmove(buf + gapStart, buf + gapEnd, n);
+    gapStart += n;
+    gapEnd += n;
+  }
+}
+
+// Copies n bytes of text from `start` on to dst.
+static void copyOut(int start, int n, char* dst) {
+  for (int i = 0; i < n; i++) {
+    int p = start + i;
+    dst[i] = buf[p < gapStart ? p : p + (gapEnd - gapStart)];
+  }
+}
+
+static int allocSlot() {
+  for (int i = 0; i < MAX_SLOTS; i++) {
+    if (!slotUsed[i] && !slotOnDisk[i]) {
+      slotUsed[i] = true;
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void resetState() {
+  gapStart = 0;
+  gapEnd = NOTES_CAP;
+  cursorPos = 0;
+  blockCount = 0;
+  loadedBlocks = 0;
+  memset(slotUsed, 0, sizeof(slotUsed));
+  indexDirty = false;
+}
+
+static bool readIndex() {
+  memset(slotOnDisk, 0, sizeof(slotOnDisk));
+  File f = LittleFS.open(IDX_PATH, FILE_READ);
+  if (!f) return false;
+  uint32_t magic = 0;
+  uint16_t count = 0;
+  if (f.read((uint8_t*)&magic, 4) != 4 || magic != IDX_MAGIC) return false;
+  if (f.read((uint8_t*)&count, 2) != 2 || count > MAX_BLOCKS) return false;
+  for (int i = 0; i < count; i++) {
+    uint16_t slot;
+    if (f.read((uint8_t*)&slot, 2) != 2 || slot >= MAX_SLOTS || slotUsed[slot]) {
+      resetState();
+      return false;
+    }
+    slotUsed[slot] = true;
+    blocks[i] = {slot, 0, false};
+  }
+  blockCount = count;
+  memcpy(slotOnDisk, slotUsed, sizeof(slotOnDisk));
+  return true;
+}
+
+// Writes the index next to the old one and renames it over, so a reset
+// leaves one or the other whole. Slots only the old index listed are free
+// once it is gone.
+static bool writeIndex() {
+  File f = LittleFS.open(IDX_TMP_PATH, FILE_WRITE);
+  if (!f) return false;
+  uint32_t magic = IDX_MAGIC;
+  uint16_t count = (uint16_t)blockCount;
+  size_t want = 6 + 2 * blockCount;
+  size_t n = f.write((const uint8_t*)&magic, 4);
+  n += f.write((const uint8_t*)&count, 2);
+  for (int i = 0; i < blockCount; i++) n += f.write((const uint8_t*)&blocks[i].slot, 2);
+  f.close();
+  if (n != want || !LittleFS.rename(IDX_TMP_PATH, IDX_PATH)) return false;
+  memcpy(slotOnDisk, slotUsed, sizeof(slotOnDisk));
+  indexDirty = false;
+  return true;
+}
+
+// Notes from the NVS era (one string of at most a few hundred bytes)
+// become the first block.
+static void importLegacy() {
+  Preferences p;
+  p.begin(LEGACY_NS, true);
+  size_t len = p.getBytesLength(LEGACY_KEY);
+  if (len > 0) {
+    char tmp[BLOCK_DATA + 1];
+    size_t n = p.getBytes(LEGACY_KEY, tmp, min(len, (size_t)BLOCK_DATA));
+    n = strnlen(tmp, n);
+    int slot = allocSlot();
+    memcpy(buf, tmp, n);
+    gapStart = (int)n;
+    blocks[0] = {(uint16_t)slot, (uint16_t)n, true};
+    blockCount = loadedBlocks = 1;
+    indexDirty = true;
+    legacyPending = true;
+  }
+  p.end();
+}
+
+void notes_store_open() {
+  if (!buf) buf = (char*)app_arena_alloc(NOTES_CAP);
+  resetState();
+  memset(slotOnDisk, 0, sizeof(slotOnDisk));
+  legacyPending = false;
+  if (!buf) return;
+  LittleFS.begin(true);
+  if (!LittleFS.exists(DIR_PATH)) LittleFS.mkdir(DIR_PATH);
+  if (!readIndex()) importLegacy();
+  notes_store_load_more();
+}
+
+void notes_store_close() {
+  if (notes_store_dirty()) notes_store_save();
+  resetState();
+  legacyPending = false;
+  buf = nullptr;
+}
+
+int notes_store_load_more() {
+  if (loadedBlocks >= blockCount) return 0;
+  Block& b = blocks[loadedBlocks];
+  b.len = 0;
+  File f = LittleFS.open(BLK_PATH, FILE_READ);
+  uint16_t len = 0;
+  if (f && f.seek((uint32_t)b.slot * NOTES_BLOCK) && f.read((uint8_t*)&len, 2) == 2) {
+    int room = NOTES_CAP - notes_store_length();
+    len = (uint16_t)min((int)min(len, (uint16_t)BLOCK_DATA), room);
+    moveGap(notes_store_length());
+    b.len = (uint16_t)f.read((uint8_t*)buf + gapStart, len);
+    gapStart += b.len;
+  }
+  loadedBlocks++;
+  return b.len;
+}
+
+// Block holding the byte before `pos` (the first block at pos 0), and
+// the offset it starts at.
+static int blockBefore(int pos, int* start) {
+  int s = 0;
+  for (int i = 0; i < loadedBlocks; i++) {
+    if (pos <= s + blocks[i].len) {
+      *start = s;
+      return i;
+    }
+    s += blocks[i].len;
+  }
+  *start = s;
+  return -1;
+}
+
+// Re-chunks the whole text into full blocks, for when splits used up the
+// block table.
+static bool repack() {
+  if (!notes_store_loaded()) return false;
+  int len = notes_store_length();
+  memset(slotUsed, 0, sizeof(slotUsed));
+  blockCount = 0;
+  for (int s = 0; s < len; s += BLOCK_DATA) {
+    blocks[blockCount] = {(uint16_t)allocSlot(), (uint16_t)min(BLOCK_DATA, len - s), true};
+    blockCount++;
+  }
+  loadedBlocks = blockCount;
+  indexDirty = true;
+  return true;
+}
+
+// Moves the back half of block b into a new block after it.
+static bool splitBlock(int b) {
+  if (blockCount >= MAX_BLOCKS) return false;
+  memmove(blocks + b + 2, blocks + b + 1, (blockCount - b - 1) * sizeof(Block));
+  int half = blocks[b].len / 2;
+  blocks[b + 1] = {(uint16_t)allocSlot(), (uint16_t)(blocks[b].len - half), true};
+  blocks[b].len = (uint16_t)half;
+  blocks[b].dirty = true;
+  blockCount++;
+  loadedBlocks++;
+  indexDirty = true;
+  return true;
+}
+
+bool notes_store_insert(char c) {
+  if (!buf) return false;
+  // Blocks not paged in yet still need their room.
+  int pending = (blockCount - loadedBlocks) * BLOCK_DATA;
+  if (notes_store_length() + pending >= NOTES_CAP) return false;
+
+  if (blockCount == 0) {
+    blocks[0] = {(uint16_t)allocSlot(), 0, true};
+    blockCount = loadedBlocks = 1;
+    indexDirty = true;
+  }
+  int start;
+  int b = blockBefore(cursorPos, &start);
+  if (blocks[b].len >= BLOCK_DATA && !splitBlock(b)) {
+    if (!repack()) return false;
+    b = blockBefore(cursorPos, &start);
+    if (blocks[b].len >= BLOCK_DATA) splitBlock(b);
+  }
+  b = blockBefore(cursorPos, &start);
+
+  moveGap(cursorPos);
+  buf[gapStart++] = c;
+  cursorPos++;
+  blocks[b].len++;
+  blocks[b].dirty = true;
+  return true;
+}
+
+bool notes_store_backspace() {
+  if (cursorPos == 0) return false;
+  int start;
+  int b = blockBefore(cursorPos, &start);
+
+  moveGap(cursorPos);
+  gapStart--;
+  cursorPos--;
+  blocks[b].len--;
+  blocks[b].dirty = true;
+  if (blocks[b].len == 0) {
+    slotUsed[blocks[b].slot] = false;
+    memmove(blocks + b, blocks + b + 1, (blockCount - b - 1) * sizeof(Block));
+    blockCount--;
+    loadedBlocks--;
+    indexDirty = true;
+  }
+  return true;
+}
+
+void notes_store_clear() {
+  resetState();
+  indexDirty = true;
+}
+
+bool notes_store_dirty() {
+  if (!buf) return false;
+  if (indexDirty || legacyPending) return true;
+  for (int i = 0; i < loadedBlocks; i++) {
+    if (blocks[i].dirty) return true;
+  }
+  return false;
+}
+
+// Writes the dirty blocks, then the index if the block list changed. A
+// block that moves or changes length while the index changes goes to a
+// fresh slot; an edit that leaves the list alone is rewritten in place,
+// which LittleFS commits as a whole when the file is closed.
+int notes_store_save() {
+  if (!buf) return 0;
+  int written = 0;
+  bool ok = true;
+  File f;
+  int start = 0;
+  for (int i = 0; i < loadedBlocks; i++) {
+    Block& b = blocks[i];
+    if (b.dirty) {
+      if (!f) f = LittleFS.open(BLK_PATH, LittleFS.exists(BLK_PATH) ? "r+" : FILE_WRITE);
+      if (!f) { ok = false; break; }
+      if (indexDirty && slotOnDisk[b.slot]) {
+        int fresh = allocSlot();
+        if (fresh < 0) { ok = false; break; }
+        slotUsed[b.slot] = false;
+        b.slot = (uint16_t)fresh;
+      }
+      char slot[NOTES_BLOCK];
+      memcpy(slot, &b.len, 2);
+      copyOut(start, b.len, slot + 2);
+      f.seek((uint32_t)b.slot * NOTES_BLOCK);
+      if (f.write((const uint8_t*)slot, b.len + 2) != (size_t)(b.len + 2)) { ok = false; break; }
+      b.dirty = false;
+      written++;
+    }
+    start += b.len;
+  }
+  if (f) f.close();
+
+  // The old index stays until every block the new one lists is written.
+  if (!ok) return written;
+  if (indexDirty && !writeIndex()) return written;
+  if (legacyPending) {
+    Preferences p;
+    p.begin(LEGACY_NS, false);
+    p.remove(LEGACY_KEY);
+    p.end();
+    legacyPending = false;
+  }
+  return written;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+
+// The note being edited, kept in a gap buffer and stored on LittleFS in
+// fixed-size blocks.
+//
+// /notes/note.blk holds NOTES_BLOCK-byte slots (a 2-byte length, then the
+// text); /notes/note.idx lists the slots in text order. Opening reads the
+// index and the first block only, the rest is paged in by
+// notes_store_load_more(). Each edit marks the one block it lands in, so a
+// save writes just those slots, plus the index when blocks were split or
+// dropped. Such a save puts changed blocks in free slots and then swaps
+// the new index in whole, so a reset in the middle keeps the old note.
+
+#define NOTES_CAP   16384
+#define NOTES_BLOCK 512
+
+// Reads the index and the first block into a NOTES_CAP buffer from the
+// app arena (taken on the first open after a close). Notes saved by older
+// firmware as one NVS string are moved over on the first save.
+void notes_store_open();
+
+// Writes what is dirty and lets go of the buffer, before the arena is
+// handed to another app. Until the next open the store is empty.
+void notes_store_close();
+
+// Pages in the next block. Returns the number of bytes appended to the
+// text, 0 once everything is loaded.
+int notes_store_load_more();
+bool notes_store_loaded();
+
+int notes_store_length();
+int notes_store_cursor();
+void notes_store_set_cursor(int pos);
+
+// Edits at the cursor. Return false when nothing changed (text full,
+// cursor at the start).
+bool notes_store_insert(char c);
+bool notes_store_backspace();
+void notes_store_clear();
+
+// The buffer, with the gap at *gapAt for *gapLen bytes (see TextLayout).
+const char* notes_store_text(int* gapAt, int* gapLen);
+
+bool notes_store_dirty();
+
+// Writes the dirty blocks. Returns how many were written.
+int notes_store_save();
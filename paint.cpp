@@ -1,8 +1,9 @@
 #include "paint.h"
 #include "system_ui.h"
+#include "app_arena.h"
 #include <Arduino.h>
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 static uint32_t lastStatusTick = 0;
 
 #define SCREEN_W 320
@@ -76,10 +77,6 @@ static int lastGX  = -1, lastGY  = -1;
 static bool previewActive = false;
 static int prevGX0 = 0, prevGY0 = 0, prevGX1 = 0, prevGY1 = 0;
 
-static uint16_t* snap = nullptr;
-static bool      snapOk = false;
-static bool      snapWarned = false;
-
 static bool selActive = false;
 static bool selDragging = false;
 static int  selX=0, selY=0, selW=0, selH=0;
@@ -87,10 +84,15 @@ static int  selGrabOffX=0, selGrabOffY=0;
 static uint16_t* selBuf = nullptr;
 static int  selBufW=0, selBufH=0;
 
+// Taken from the app arena while Paint is open: room for a selection of
+// the whole canvas, and the flood fill's stack.
+static uint16_t* selMem = nullptr;
 static int16_t* ffX = nullptr;
 static int16_t* ffY = nullptr;
 static bool ffOk = false;
-static bool ffWarned = false;
+
+#define PAINT_ARENA_BYTES (sizeof(uint16_t) * GW * GH + 2 * sizeof(int16_t) * GW * GH)
+static_assert(PAINT_ARENA_BYTES <= APP_ARENA_BYTES, "Paint's buffers must fit in the app arena");
 
 static const char* statusMsg = nullptr;
 static uint32_t statusMsgUntil = 0;
@@ -132,25 +134,33 @@ static void clearCanvas() {
   for (int i = 0; i < GW * GH; i++) canvas[i] = TFT_WHITE;
 }
 
-static void renderCanvasAll() {
-
-  tft->fillRect(CANVAS_X, CANVAS_Y, CANVAS_W, CANVAS_H, TFT_WHITE);
+// One canvas row scaled up to PX screen rows, sent with a single pushImage
+// instead of a PX x PX fillRect per cell.
+static uint16_t rowBuf[CANVAS_W * PX];
 
-  for (int y = 0; y < GH; y++) {
-    for (int x = 0; x < GW; x++) {
-      uint16_t c = canvas[y * GW + x];
-      if (c != TFT_WHITE) renderPixel(x, y, c);
-    }
+static inline uint16_t cellColor(int gx, int gy) {
+  if (selActive && selBuf &&
+      gx >= selX && gx < selX + selBufW && gy >= selY && gy < selY + selBufH) {
+    uint16_t c = selBuf[(gy - selY) * selBufW + (gx - selX)];
+    if (c != TFT_WHITE) return c;
   }
+  return canvas[gy * GW + gx];
+}
 
-  if (selActive && selBuf && selBufW>0 && selBufH>0) {
-    for (int y = 0; y < selBufH; y++) {
-      for (int x = 0; x < selBufW; x++) {
-        uint16_t c = selBuf[y*selBufW + x];
-        if (c != TFT_WHITE) renderPixel(selX + x, selY + y, c);
-      }
-    }
+static void renderCanvasRow(int gy, int gx0, int gx1) {
+  int n = gx1 - gx0 + 1;
+  int w = n * PX;
+
+  uint16_t* p = rowBuf;
+  for (int x = gx0; x <= gx1; x++) {
+    uint16_t c = cellColor(x, gy);
+    for (int k = 0; k < PX; k++) *p++ = c;
   }
+  for (int k = 1; k < PX; k++) {
+    memcpy(rowBuf + k * w, rowBuf, w * sizeof(uint16_t));
+  }
+
+  tft->pushImage(CANVAS_X + gx0 * PX, CANVAS_Y + gy * PX, w, PX, rowBuf);
 }
 
 static void renderCanvasRect(int gx0, int gy0, int gx1, int gy1) {
@@ -160,63 +170,21 @@ static void renderCanvasRect(int gx0, int gy0, int gx1, int gy1) {
   if (gy0 < 0) gy0 = 0;
   if (gx1 >= GW) gx1 = GW - 1;
   if (gy1 >= GH) gy1 = GH - 1;
+  if (gx0 > gx1 || gy0 > gy1) return;
 
-  int px0 = CANVAS_X + gx0 * PX;
-  int py0 = CANVAS_Y + gy0 * PX;
-  int w = (gx1 - gx0 + 1) * PX;
-  int h = (gy1 - gy0 + 1) * PX;
-  tft->fillRect(px0, py0, w, h, TFT_WHITE);
-
-  for (int y = gy0; y <= gy1; y++) {
-    for (int x = gx0; x <= gx1; x++) {
-      uint16_t c = canvas[y * GW + x];
-      if (c != TFT_WHITE) renderPixel(x, y, c);
-    }
-  }
-
-  if (selActive && selBuf && selBufW>0 && selBufH>0) {
-    int sx0 = selX;
-    int sy0 = selY;
-    int sx1 = selX + selBufW - 1;
-    int sy1 = selY + selBufH - 1;
-    if (!(sx1 < gx0 || sx0 > gx1 || sy1 < gy0 || sy0 > gy1)) {
-      int x0 = max(gx0, sx0);
-      int y0 = max(gy0, sy0);
-      int x1 = min(gx1, sx1);
-      int y1 = min(gy1, sy1);
-      for (int y = y0; y <= y1; y++) {
-        for (int x = x0; x <= x1; x++) {
-          uint16_t c = selBuf[(y - selY) * selBufW + (x - selX)];
-          if (c != TFT_WHITE) renderPixel(x, y, c);
-        }
-      }
-    }
-  }
+  // rowBuf holds native RGB565.
+  bool swap = tft->getSwapBytes();
+  tft->setSwapBytes(true);
+  for (int y = gy0; y <= gy1; y++) renderCanvasRow(y, gx0, gx1);
+  tft->setSwapBytes(swap);
 }
 
-static void ensureSnapshot() {
-  if (snap) { snapOk = true; return; }
-  snap = (uint16_t*)malloc(sizeof(uint16_t) * GW * GH);
-  snapOk = (snap != nullptr);
-  if (!snapOk && !snapWarned) {
-    snapWarned = true;
-    setStatusMsg("Not enough RAM for Undo");
-  }
-}
-
-static void takeSnapshot() {
-  if (!snapOk) return;
-  memcpy(snap, canvas, sizeof(uint16_t) * GW * GH);
-
-}
-
-static void restoreSnapshotToCanvas() {
-  if (!snapOk) return;
-  memcpy(canvas, snap, sizeof(uint16_t) * GW * GH);
+static void renderCanvasAll() {
+  renderCanvasRect(0, 0, GW - 1, GH - 1);
 }
 
 static void freeSelection() {
-  if (selBuf) { free(selBuf); selBuf = nullptr; }
+  selBuf = nullptr;
   selBufW = selBufH = 0;
   selActive = false;
   selDragging = false;
@@ -276,18 +244,6 @@ static void drawEllipseOutlineGrid(int x0,int y0,int x1,int y1,uint16_t c,int r)
   }
 }
 
-static void ensureFloodFill() {
-  if (ffX && ffY) { ffOk = true; return; }
-
-  ffX = (int16_t*)malloc(sizeof(int16_t) * GW * GH);
-  ffY = (int16_t*)malloc(sizeof(int16_t) * GW * GH);
-  ffOk = (ffX && ffY);
-  if (!ffOk && !ffWarned) {
-    ffWarned = true;
-    setStatusMsg("Not enough RAM for Fill");
-  }
-}
-
 static void floodFill(int sx, int sy, uint16_t newC) {
   if (!ffOk) return;
   if (!inGrid(sx,sy)) return;
@@ -295,6 +251,10 @@ static void floodFill(int sx, int sy, uint16_t newC) {
   uint16_t oldC = getPixel(sx,sy);
   if (oldC == newC) return;
 
+  // Cells are written to the canvas only; the touched area is repainted
+  // row by row at the end.
+  int bx0 = sx, by0 = sy, bx1 = sx, by1 = sy;
+
   int top = 0;
   ffX[top] = sx;
   ffY[top] = sy;
@@ -308,7 +268,11 @@ static void floodFill(int sx, int sy, uint16_t newC) {
     if (!inGrid(x,y)) continue;
     if (getPixel(x,y) != oldC) continue;
 
-    setPixel(x,y,newC);
+    canvas[y * GW + x] = newC;
+    if (x < bx0) bx0 = x;
+    if (x > bx1) bx1 = x;
+    if (y < by0) by0 = y;
+    if (y > by1) by1 = y;
 
     if (top + 4 >= GW*GH) continue;
     ffX[top] = x+1; ffY[top] = y;   top++;
@@ -316,6 +280,8 @@ static void floodFill(int sx, int sy, uint16_t newC) {
     ffX[top] = x;   ffY[top] = y+1; top++;
     ffX[top] = x;   ffY[top] = y-1; top++;
   }
+
+  renderCanvasRect(bx0, by0, bx1, by1);
 }
 
 static void drawTitle() {
@@ -641,16 +607,30 @@ static void commitSelectionToCanvas() {
   }
 }
 
-void paint_init(TFT_eSPI* display) {
+void paint_init(Display* display) {
   tft = display;
   clearCanvas();
   selectedColorIdx = 0;
   color = palette[selectedColorIdx];
 
-  ensureSnapshot();
-  ensureFloodFill();
+  freeSelection();
+}
+
+void paint_open() {
+  selMem = (uint16_t*)app_arena_alloc(sizeof(uint16_t) * GW * GH);
+  ffX = (int16_t*)app_arena_alloc(sizeof(int16_t) * GW * GH);
+  ffY = (int16_t*)app_arena_alloc(sizeof(int16_t) * GW * GH);
+  ffOk = (ffX && ffY);
+  paint_draw();
+}
 
+void paint_close() {
+  // A selection still being moved is dropped where it is.
+  commitSelectionToCanvas();
   freeSelection();
+  selMem = nullptr;
+  ffX = ffY = nullptr;
+  ffOk = false;
 }
 
 void paint_draw() {
@@ -880,6 +860,19 @@ bool paint_handleTouch(int x, int y) {
     };
 
     auto previewLine = [&](int ax,int ay,int bx,int by,uint16_t pc,int pr){
+      if(ax==bx || ay==by){
+        // Axis-aligned edge: one rectangle instead of a stamp per cell.
+        int gx0 = min(ax,bx) - pr, gx1 = max(ax,bx) + pr;
+        int gy0 = min(ay,by) - pr, gy1 = max(ay,by) + pr;
+        if(gx0<0) gx0=0;
+        if(gy0<0) gy0=0;
+        if(gx1>=GW) gx1=GW-1;
+        if(gy1>=GH) gy1=GH-1;
+        if(gx0>gx1 || gy0>gy1) return;
+        tft->fillRect(CANVAS_X + gx0*PX, CANVAS_Y + gy0*PX,
+                      (gx1-gx0+1)*PX, (gy1-gy0+1)*PX, pc);
+        return;
+      }
       int dx = abs(bx - ax), sx = ax < bx ? 1 : -1;
       int dy = -abs(by - ay), sy = ay < by ? 1 : -1;
       int err = dx + dy;
@@ -967,7 +960,7 @@ static void finalizeSelectionFromDrag() {
   freeSelection();
   selBufW = w;
   selBufH = h;
-  selBuf = (uint16_t*)malloc(sizeof(uint16_t) * w * h);
+  selBuf = selMem;
   if (!selBuf) {
     selBufW = selBufH = 0;
     selActive = false;
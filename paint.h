@@ -1,7 +1,12 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "display.h"
 
-void paint_init(TFT_eSPI* display);
+void paint_init(Display* display);
+// Takes Paint's buffers from the app arena and draws it.
+void paint_open();
+// Paint is leaving the front: a floating selection is dropped onto the
+// canvas and the arena buffers are let go. The picture itself stays.
+void paint_close();
 void paint_draw();
 void paint_tick();
 void paint_release();
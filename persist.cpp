@@ -0,0 +1,54 @@
+#include "persist.h"
+#include <Arduino.h>
+
+struct PersistEntry {
+  PersistSaveFn save;
+  bool dirty;
+  uint32_t firstDirtyMs;
+  uint32_t lastDirtyMs;
+};
+
+static PersistEntry entries[PERSIST_COUNT];
+
+void persist_register(PersistKey key, PersistSaveFn save) {
+  entries[key].save = save;
+}
+
+void persist_mark_dirty(PersistKey key) {
+  PersistEntry& e = entries[key];
+  uint32_t now = millis();
+  if (!e.dirty) {
+    e.dirty = true;
+    e.firstDirtyMs = now;
+  }
+  e.lastDirtyMs = now;
+}
+
+bool persist_is_dirty(PersistKey key) {
+  return entries[key].dirty;
+}
+
+static void commit(PersistEntry& e) {
+  // Cleared first so a save that marks the key again is not lost.
+  e.dirty = false;
+  if (e.save) e.save();
+}
+
+void persist_idle() {
+  uint32_t now = millis();
+  for (int i = 0; i < PERSIST_COUNT; i++) {
+    PersistEntry& e = entries[i];
+    if (!e.dirty) continue;
+    if (now - e.lastDirtyMs >= PERSIST_DEBOUNCE_MS ||
+        now - e.firstDirtyMs >= PERSIST_MAX_DELAY_MS) {
+      commit(e);
+      return;   // at most one flash commit per loop pass
+    }
+  }
+}
+
+void persist_flush() {
+  for (int i = 0; i < PERSIST_COUNT; i++) {
+    if (entries[i].dirty) commit(entries[i]);
+  }
+}
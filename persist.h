@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+// Write-behind persistence.
+//
+// Stores that keep their state in RAM mark it dirty here instead of
+// writing flash from the UI path. A dirty key is committed by
+// persist_idle() once it has been quiet for PERSIST_DEBOUNCE_MS (so a run
+// of slider steps or keystrokes becomes one write), or at the latest
+// PERSIST_MAX_DELAY_MS after it first went dirty. persist_flush() commits
+// everything at once; the sketch calls it whenever the foreground app
+// changes.
+
+#define PERSIST_DEBOUNCE_MS  1500
+#define PERSIST_MAX_DELAY_MS 10000
+
+enum PersistKey : uint8_t {
+  PERSIST_CONFIG = 0,   // config.h blob: settings, trash, Wi-Fi, token
+  PERSIST_NOTES,
+  PERSIST_COUNT
+};
+
+typedef void (*PersistSaveFn)();
+
+// save writes the key's current state to flash.
+void persist_register(PersistKey key, PersistSaveFn save);
+
+void persist_mark_dirty(PersistKey key);
+bool persist_is_dirty(PersistKey key);
+
+// Commits keys whose debounce ran out. Call from loop() while no gesture
+// is in progress.
+void persist_idle();
+
+void persist_flush();
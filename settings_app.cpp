@@ -3,7 +3,7 @@
 #include "system_ui.h"
 #include <Arduino.h>
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 static bool openState = false;
 
 static const int SCREEN_W = 320;
@@ -93,7 +93,7 @@ static void drawAll() {
   tft->drawCentreString("SAVE", 160, SAVE_Y + 4, 2);
 }
 
-void settings_app_init(TFT_eSPI* display) {
+void settings_app_init(Display* display) {
   tft = display;
 }
 
@@ -1,7 +1,7 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "display.h"
 
-void settings_app_init(TFT_eSPI* display);
+void settings_app_init(Display* display);
 void settings_app_open();
 void settings_app_tick();
 bool settings_app_handleTouch(bool pressed, bool lastPressed, int x, int y);
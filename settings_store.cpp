@@ -1,65 +1,30 @@
 #include "settings_store.h"
-#include <Preferences.h>
+#include "config.h"
 #include <Arduino.h>
 
-static const char* NVS_NS = "settings";
-static const char* KEY_BRIGHT = "bright";
-static const char* KEY_AUTO   = "autoc";
-
-static bool inited = false;
-static uint8_t gBright = 220;
-static bool gAuto = true;
-
 static const int BL_PIN = 27;
 static const int BL_CH  = 0;
 static const int BL_FREQ = 5000;
 static const int BL_RES  = 8;
 static bool blInited = false;
 
-static void loadOnce() {
-  if (inited) return;
-  Preferences p;
-  p.begin(NVS_NS, true);
-  gBright = (uint8_t)p.getUChar(KEY_BRIGHT, gBright);
-  gAuto   = p.getBool(KEY_AUTO, gAuto);
-  p.end();
-  inited = true;
-}
-
-void settings_store_init() {
-  loadOnce();
-}
-
-uint8_t settings_get_brightness() { loadOnce(); return gBright; }
-bool settings_get_autoconnect() { loadOnce(); return gAuto; }
-
-static void saveAll() {
-  Preferences p;
-  p.begin(NVS_NS, false);
-  p.putUChar(KEY_BRIGHT, gBright);
-  p.putBool(KEY_AUTO, gAuto);
-  p.end();
-}
+uint8_t settings_get_brightness() { return config_get_brightness(); }
+bool settings_get_autoconnect() { return config_get_autoconnect(); }
 
 void settings_set_brightness(uint8_t val) {
-  loadOnce();
-  gBright = val;
-  saveAll();
+  config_set_brightness(val);
   settings_apply_brightness();
 }
 
 void settings_set_autoconnect(bool on) {
-  loadOnce();
-  gAuto = on;
-  saveAll();
+  config_set_autoconnect(on);
 }
 
 void settings_apply_brightness() {
-  loadOnce();
   if (!blInited) {
     ledcSetup(BL_CH, BL_FREQ, BL_RES);
     ledcAttachPin(BL_PIN, BL_CH);
     blInited = true;
   }
-  ledcWrite(BL_CH, gBright);
+  ledcWrite(BL_CH, config_get_brightness());
 }
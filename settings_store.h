@@ -1,7 +1,7 @@
 #pragma once
 #include <stdint.h>
 
-void settings_store_init();
+// Settings backed by config.h, plus the backlight they drive.
 
 uint8_t settings_get_brightness();
 bool settings_get_autoconnect();
@@ -0,0 +1,75 @@
+#include <Arduino.h>
+#include <deque>
+#include <string>
+#include "sim.h"
+
+// ============================================================
+// Virtual clock
+// ============================================================
+static uint64_t g_clockUs = 0;
+
+uint64_t sim_clock_us() { return g_clockUs; }
+void sim_clock_advance_us(uint64_t us) { g_clockUs += us; }
+
+unsigned long millis() { return (unsigned long)(g_clockUs / 1000ULL); }
+unsigned long micros() { return (unsigned long)g_clockUs; }
+void delay(unsigned long ms) { sim_block_us((uint64_t)ms * 1000ULL); }
+void delayMicroseconds(unsigned int us) { g_clockUs += us; }
+void yield() {}
+
+// ============================================================
+// GPIO interrupts
+// ============================================================
+static const int SIM_GPIO_COUNT = 40;
+static void (*g_isr[SIM_GPIO_COUNT])() = {};
+
+void pinMode(uint8_t, uint8_t) {}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int) {
+  if (pin < SIM_GPIO_COUNT) g_isr[pin] = isr;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < SIM_GPIO_COUNT) g_isr[pin] = nullptr;
+}
+
+void sim_gpio_interrupt(uint8_t pin) {
+  if (pin < SIM_GPIO_COUNT && g_isr[pin]) g_isr[pin]();
+}
+
+// ============================================================
+// LEDC / SNTP
+// ============================================================
+static uint32_t g_ledcDuty = 0;
+
+double ledcSetup(uint8_t, double freq, uint8_t) { return freq; }
+void ledcAttachPin(uint8_t, uint8_t) {}
+void ledcWrite(uint8_t, uint32_t duty) { g_ledcDuty = duty; }
+
+void configTime(long, int, const char*, const char*, const char*) {}
+
+// ============================================================
+// Serial
+// ============================================================
+// Scripted input: the driver queues whole lines, the firmware sees bytes.
+static std::deque<char> g_serialIn;
+
+void sim_serial_push_line(const char* line) {
+  for (const char* p = line; *p; p++) g_serialIn.push_back(*p);
+  g_serialIn.push_back('\n');
+}
+
+int HardwareSerial::available() { return (int)g_serialIn.size(); }
+
+int HardwareSerial::read() {
+  if (g_serialIn.empty()) return -1;
+  char c = g_serialIn.front();
+  g_serialIn.pop_front();
+  return (unsigned char)c;
+}
+
+int HardwareSerial::peek() {
+  return g_serialIn.empty() ? -1 : (unsigned char)g_serialIn.front();
+}
+
+HardwareSerial Serial;
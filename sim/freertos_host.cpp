@@ -0,0 +1,209 @@
+#include <Arduino.h>
+#include <ucontext.h>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "sim.h"
+
+// ============================================================
+// Cooperative tasks
+// ============================================================
+// Each task gets a ucontext and its own stack. sim_tasks_run() (called by
+// the driver after every loop()) switches into every task that is ready
+// and gets control back as soon as the task blocks again, so runs stay
+// deterministic.
+struct SimTask {
+  TaskFunction_t fn;
+  void* param;
+  ucontext_t ctx;
+  std::vector<uint8_t> stack;
+  uint64_t wakeUs;
+  std::function<bool()> ready;   // extra wake condition while blocked
+  uint32_t notify;               // pending task notifications
+  bool done;
+};
+
+static const size_t SIM_TASK_STACK = 256 * 1024;
+
+static std::vector<SimTask*> g_tasks;
+static SimTask* g_current = nullptr;
+static ucontext_t g_loopCtx;
+
+bool sim_in_task() { return g_current != nullptr; }
+
+static void taskEntry(unsigned lo, unsigned hi) {
+  SimTask* t = (SimTask*)(((uintptr_t)hi << 32) | (uintptr_t)lo);
+  t->fn(t->param);
+  t->done = true;
+  g_current = nullptr;
+  setcontext(&g_loopCtx);
+}
+
+// Parks the current task until `cond` holds or the clock reaches `untilUs`.
+// Returns whether the condition was met.
+static bool waitFor(std::function<bool()> cond, uint64_t untilUs) {
+  if (!g_current) return cond && cond();
+
+  SimTask* t = g_current;
+  while (true) {
+    if (cond && cond()) return true;
+    if (sim_clock_us() >= untilUs) return false;
+    t->wakeUs = untilUs;
+    t->ready = cond;
+    g_current = nullptr;
+    swapcontext(&t->ctx, &g_loopCtx);
+    g_current = t;
+  }
+}
+
+static uint64_t deadlineFor(TickType_t ticks) {
+  if (ticks == portMAX_DELAY) return UINT64_MAX;
+  return sim_clock_us() + (uint64_t)ticks * portTICK_PERIOD_MS * 1000ULL;
+}
+
+void sim_block_us(uint64_t us) {
+  if (!g_current) {
+    sim_clock_advance_us(us);
+    return;
+  }
+  waitFor(nullptr, sim_clock_us() + us);
+}
+
+void sim_tasks_run() {
+  for (size_t i = 0; i < g_tasks.size(); i++) {
+    SimTask* t = g_tasks[i];
+    if (t->done) continue;
+    bool wake = sim_clock_us() >= t->wakeUs || (t->ready && t->ready());
+    if (!wake) continue;
+    t->ready = nullptr;
+    g_current = t;
+    swapcontext(&g_loopCtx, &t->ctx);
+    g_current = nullptr;
+  }
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t,
+                                   void* param, UBaseType_t, TaskHandle_t* handle,
+                                   BaseType_t) {
+  SimTask* t = new SimTask();
+  t->fn = fn;
+  t->param = param;
+  t->stack.resize(SIM_TASK_STACK);
+  t->wakeUs = 0;
+  t->notify = 0;
+  t->done = false;
+
+  getcontext(&t->ctx);
+  t->ctx.uc_stack.ss_sp = t->stack.data();
+  t->ctx.uc_stack.ss_size = t->stack.size();
+  t->ctx.uc_link = nullptr;
+  uintptr_t p = (uintptr_t)t;
+  makecontext(&t->ctx, (void (*)())taskEntry, 2, (unsigned)(p & 0xFFFFFFFFu), (unsigned)(p >> 32));
+
+  g_tasks.push_back(t);
+  if (handle) *handle = t;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, param, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  SimTask* t = task ? task : g_current;
+  if (!t) return;
+  t->done = true;
+  if (t == g_current) {
+    g_current = nullptr;
+    setcontext(&g_loopCtx);
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  sim_block_us((uint64_t)ticks * portTICK_PERIOD_MS * 1000ULL);
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)(sim_clock_us() / 1000ULL); }
+
+BaseType_t xPortGetCoreID() { return g_current ? 0 : 1; }
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+  SimTask* t = g_current;
+  if (!t) return 0;
+  if (t->notify == 0 && ticksToWait != 0) {
+    waitFor([t]() { return t->notify > 0; }, deadlineFor(ticksToWait));
+  }
+  uint32_t n = t->notify;
+  if (n) t->notify = clearCountOnExit ? 0 : n - 1;
+  return n;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  if (task) task->notify++;
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+  xTaskNotifyGive(task);
+  if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+}
+
+// ============================================================
+// Queues
+// ============================================================
+struct SimQueue {
+  size_t length;
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  SimQueue* q = new SimQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t q) { delete q; }
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+  if (!q) return errQUEUE_FULL;
+  auto hasSpace = [q]() { return q->items.size() < q->length; };
+  if (!hasSpace() && (wait == 0 || !waitFor(hasSpace, deadlineFor(wait)))) return errQUEUE_FULL;
+  const uint8_t* p = (const uint8_t*)item;
+  q->items.emplace_back(p, p + q->itemSize);
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t wait) {
+  return xQueueSend(q, item, wait);
+}
+
+static BaseType_t takeItem(QueueHandle_t q, void* out, TickType_t wait, bool remove) {
+  if (!q) return pdFALSE;
+  auto hasItem = [q]() { return !q->items.empty(); };
+  if (!hasItem() && (wait == 0 || !waitFor(hasItem, deadlineFor(wait)))) return pdFALSE;
+  memcpy(out, q->items.front().data(), q->itemSize);
+  if (remove) q->items.pop_front();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* out, TickType_t wait) {
+  return takeItem(q, out, wait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void* out, TickType_t wait) {
+  return takeItem(q, out, wait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return q ? (UBaseType_t)q->items.size() : 0; }
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+  return q ? (UBaseType_t)(q->length - q->items.size()) : 0;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+  if (q) q->items.clear();
+  return pdPASS;
+}
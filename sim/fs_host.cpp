@@ -0,0 +1,151 @@
+#include <LittleFS.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "sim.h"
+
+// Rough cost of LittleFS on the board's SPI NOR flash: a metadata walk per
+// open, ~10 MB/s reads, and writes that include program/erase time.
+static const uint32_t FS_OPEN_US = 800;
+static const uint32_t FS_READ_BYTES_PER_MS = 10000;
+static const uint32_t FS_WRITE_BYTES_PER_MS = 500;
+
+static std::map<std::string, std::vector<uint8_t>> g_files;
+static SimFsStat g_fsStats;
+
+LittleFSFS LittleFS;
+
+const SimFsStat* sim_fs_stats() { return &g_fsStats; }
+void sim_fs_stats_reset() { g_fsStats = SimFsStat(); }
+
+namespace fs {
+
+struct SimFileHandle {
+  std::string path;
+  size_t pos;
+  bool canRead;
+  bool canWrite;
+  bool append;
+};
+
+static std::vector<uint8_t>* dataOf(const std::shared_ptr<SimFileHandle>& h) {
+  auto it = g_files.find(h->path);
+  return it == g_files.end() ? nullptr : &it->second;
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+  if (!_h || !_h->canWrite) return 0;
+  std::vector<uint8_t>* d = dataOf(_h);
+  if (!d) return 0;
+  if (_h->append) _h->pos = d->size();
+  if (d->size() < _h->pos + size) d->resize(_h->pos + size, 0);
+  memcpy(d->data() + _h->pos, buf, size);
+  _h->pos += size;
+  g_fsStats.bytesWritten += size;
+  sim_block_us((uint64_t)size * 1000 / FS_WRITE_BYTES_PER_MS);
+  return size;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+  if (!_h || !_h->canRead) return 0;
+  std::vector<uint8_t>* d = dataOf(_h);
+  if (!d || _h->pos >= d->size()) return 0;
+  size_t n = std::min(size, d->size() - _h->pos);
+  memcpy(buf, d->data() + _h->pos, n);
+  _h->pos += n;
+  g_fsStats.bytesRead += n;
+  sim_block_us((uint64_t)n * 1000 / FS_READ_BYTES_PER_MS);
+  return n;
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::available() {
+  if (!_h) return 0;
+  std::vector<uint8_t>* d = dataOf(_h);
+  return (d && _h->pos < d->size()) ? (int)(d->size() - _h->pos) : 0;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_h) return false;
+  size_t base = mode == SeekSet ? 0 : mode == SeekCur ? _h->pos : size();
+  _h->pos = base + pos;
+  return true;
+}
+
+size_t File::position() const { return _h ? _h->pos : 0; }
+
+size_t File::size() const {
+  if (!_h) return 0;
+  std::vector<uint8_t>* d = dataOf(_h);
+  return d ? d->size() : 0;
+}
+
+const char* File::path() const { return _h ? _h->path.c_str() : nullptr; }
+
+File FS::open(const char* path, const char* mode, const bool create) {
+  if (!path || !mode) return File();
+  g_fsStats.opens++;
+  sim_block_us(FS_OPEN_US);
+
+  bool exists = g_files.count(path) > 0;
+  bool plus = strchr(mode, '+') != nullptr;
+  auto h = std::make_shared<SimFileHandle>();
+  h->path = path;
+  h->pos = 0;
+  h->append = false;
+
+  if (mode[0] == 'r') {
+    if (!exists && !create) return File();
+    if (!exists) g_files[path];
+    h->canRead = true;
+    h->canWrite = plus;
+  } else if (mode[0] == 'w') {
+    g_files[path].clear();
+    h->canRead = plus;
+    h->canWrite = true;
+  } else if (mode[0] == 'a') {
+    g_files[path];
+    h->canRead = plus;
+    h->canWrite = true;
+    h->append = true;
+  } else {
+    return File();
+  }
+  return File(h);
+}
+
+bool FS::exists(const char* path) { return path && g_files.count(path) > 0; }
+
+bool FS::remove(const char* path) { return path && g_files.erase(path) > 0; }
+
+bool FS::rename(const char* from, const char* to) {
+  auto it = g_files.find(from);
+  if (it == g_files.end()) return false;
+  g_files[to] = it->second;
+  g_files.erase(from);
+  return true;
+}
+
+// LittleFS has real directories, but nothing here lists them, so paths
+// are just keys.
+bool FS::mkdir(const char*) { return true; }
+bool FS::rmdir(const char*) { return true; }
+
+}  // namespace fs
+
+bool LittleFSFS::begin(bool, const char*, uint8_t, const char*) { return true; }
+
+bool LittleFSFS::format() {
+  g_files.clear();
+  return true;
+}
+
+size_t LittleFSFS::usedBytes() {
+  size_t n = 0;
+  for (auto& f : g_files) n += f.second.size();
+  return n;
+}
@@ -0,0 +1,163 @@
+#pragma once
+// Host stand-in for the ESP32 Arduino core.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+#include <time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "WString.h"
+#include "IPAddress.h"
+
+// The ESP32 core pulls these in for every sketch.
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+using std::min;
+using std::max;
+using std::abs;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// LEDC backlight PWM (no-op on host, value is remembered)
+double ledcSetup(uint8_t chan, double freq, uint8_t bits);
+void   ledcAttachPin(uint8_t pin, uint8_t chan);
+void   ledcWrite(uint8_t chan, uint32_t duty);
+
+// GPIO: only what the touch interrupt needs. Interrupts are raised by the
+// device models through sim_gpio_interrupt().
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+#define RISING       0x01
+#define FALLING      0x02
+#define CHANGE       0x03
+#define digitalPinToInterrupt(pin) (pin)
+
+void pinMode(uint8_t pin, uint8_t mode);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (len--) n += write(*buf++);
+    return n;
+  }
+  size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t print(const IPAddress& ip) { return print(ip.toString()); }
+  size_t println() { return write((uint8_t)'\n'); }
+  template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n <= 0) return 0;
+    if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;
+    return write((const uint8_t*)buf, (size_t)n);
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  size_t write(uint8_t) override { return 0; }
+
+  void setTimeout(unsigned long ms) { _timeout = ms; }
+
+  size_t readBytes(char* buf, size_t len) {
+    size_t n = 0;
+    while (n < len) {
+      int c = timedRead();
+      if (c < 0) break;
+      buf[n++] = (char)c;
+    }
+    return n;
+  }
+  size_t readBytes(uint8_t* buf, size_t len) { return readBytes((char*)buf, len); }
+
+  String readStringUntil(char term) {
+    String out;
+    int c = timedRead();
+    while (c >= 0 && c != term) {
+      out += (char)c;
+      c = timedRead();
+    }
+    return out;
+  }
+
+  String readString() {
+    String out;
+    int c = timedRead();
+    while (c >= 0) {
+      out += (char)c;
+      c = timedRead();
+    }
+    return out;
+  }
+
+protected:
+  // The host streams never block: data is either there or it is not.
+  int timedRead() { return available() > 0 ? read() : -1; }
+  unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  int available() override;
+  int read() override;
+  int peek() override;
+
+  using Print::write;
+  size_t write(uint8_t c) override { fputc(c, stdout); return 1; }
+  size_t write(const uint8_t* buf, size_t len) override { return fwrite(buf, 1, len, stdout); }
+  void flush() { fflush(stdout); }
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,68 @@
+#pragma once
+// Host stand-in for the slice of ArduinoJson the firmware uses: a flat
+// object of string / number / bool members, serialize and deserialize.
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+class JsonVariant {
+public:
+  enum Kind { NUL, STR, NUM, BOOL, RAW };
+
+  JsonVariant& operator=(const char* s) { _k = STR; _s = s ? s : ""; return *this; }
+  JsonVariant& operator=(const String& s) { _k = STR; _s = s.str(); return *this; }
+  JsonVariant& operator=(bool b) { _k = BOOL; _n = b ? 1 : 0; return *this; }
+  JsonVariant& operator=(int v) { _k = NUM; _n = v; return *this; }
+  JsonVariant& operator=(long v) { _k = NUM; _n = (double)v; return *this; }
+  JsonVariant& operator=(double v) { _k = NUM; _n = v; return *this; }
+
+  template <typename T> T as() const;
+  bool isNull() const { return _k == NUL; }
+
+  Kind _k = NUL;
+  std::string _s;
+  double _n = 0;
+};
+
+template <> inline String JsonVariant::as<String>() const {
+  if (_k == STR || _k == RAW) return String(_s);
+  if (_k == BOOL) return String(_n ? "true" : "false");
+  if (_k == NUM) { char b[32]; snprintf(b, sizeof(b), "%g", _n); return String(b); }
+  return String("null");
+}
+template <> inline const char* JsonVariant::as<const char*>() const { return _k == STR ? _s.c_str() : nullptr; }
+template <> inline int JsonVariant::as<int>() const { return (int)_n; }
+template <> inline long JsonVariant::as<long>() const { return (long)_n; }
+template <> inline bool JsonVariant::as<bool>() const { return _n != 0; }
+
+class JsonDocument {
+public:
+  JsonVariant& operator[](const char* key) { return _members[key]; }
+  JsonVariant operator[](const char* key) const {
+    auto it = _members.find(key);
+    return it == _members.end() ? JsonVariant() : it->second;
+  }
+  void clear() { _members.clear(); }
+
+  std::map<std::string, JsonVariant> _members;
+};
+
+template <size_t N> class StaticJsonDocument : public JsonDocument {};
+class DynamicJsonDocument : public JsonDocument {
+public:
+  explicit DynamicJsonDocument(size_t) {}
+};
+
+class DeserializationError {
+public:
+  enum Code { Ok, InvalidInput, NoMemory };
+  DeserializationError(Code c = Ok) : _c(c) {}
+  explicit operator bool() const { return _c != Ok; }
+  const char* c_str() const { return _c == Ok ? "Ok" : (_c == NoMemory ? "NoMemory" : "InvalidInput"); }
+private:
+  Code _c;
+};
+
+size_t serializeJson(const JsonDocument& doc, String& out);
+DeserializationError deserializeJson(JsonDocument& doc, const String& in);
+DeserializationError deserializeJson(JsonDocument& doc, const char* in);
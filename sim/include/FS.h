@@ -0,0 +1,63 @@
+#pragma once
+// Host stand-in for the ESP32 core's fs::FS / fs::File.
+// Files live in process memory (see fs_host.cpp); opens and bytes moved are
+// counted so flash traffic can be compared between runs (sim_fs_stats()).
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct SimFileHandle;
+
+class File {
+public:
+  File() {}
+  explicit File(std::shared_ptr<SimFileHandle> h) : _h(h) {}
+
+  operator bool() const { return (bool)_h; }
+
+  size_t write(const uint8_t* buf, size_t size);
+  size_t write(uint8_t c) { return write(&c, 1); }
+  int read();
+  size_t read(uint8_t* buf, size_t size);
+  int available();
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void flush() {}
+  void close() { _h.reset(); }
+  const char* path() const;
+
+private:
+  std::shared_ptr<SimFileHandle> _h;
+};
+
+class FS {
+public:
+  File open(const char* path, const char* mode = FILE_READ, const bool create = false);
+  File open(const String& path, const char* mode = FILE_READ, const bool create = false) {
+    return open(path.c_str(), mode, create);
+  }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool mkdir(const char* path);
+  bool rmdir(const char* path);
+};
+
+}  // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
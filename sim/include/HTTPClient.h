@@ -0,0 +1,39 @@
+#pragma once
+// Host stand-in for the ESP32 HTTPClient. A POST costs the modeled round
+// trip on the virtual clock and returns the scripted reply. With
+// "stream":true in the payload the reply arrives as chunked SSE, one word
+// per event, spread over the generation time.
+#include <WiFi.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_CONNECTION_LOST    (-5)
+#define HTTPC_ERROR_READ_TIMEOUT       (-11)
+
+class HTTPClient {
+public:
+  bool begin(WiFiClient& client, const String& url);
+  void end();
+  void addHeader(const String& name, const String& value) { (void)name; (void)value; }
+  void setReuse(bool reuse) { _reuse = reuse; }
+  void setTimeout(uint16_t ms) { (void)ms; }
+  void setConnectTimeout(int32_t ms) { (void)ms; }
+
+  int POST(const String& payload);
+  int POST(const uint8_t* payload, size_t len);
+  int GET();
+
+  int getSize() { return _size; }
+  void collectHeaders(const char* keys[], size_t count) { (void)keys; (void)count; }
+  String header(const char* name);
+  String getString();
+  WiFiClient* getStreamPtr() { return _client; }
+  WiFiClient& getStream() { return *_client; }
+  bool connected() { return _client && _client->connected(); }
+
+private:
+  WiFiClient* _client = nullptr;
+  String _url;
+  bool _reuse = true;
+  int _size = -1;
+  bool _chunked = false;
+};
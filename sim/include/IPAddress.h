@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include "WString.h"
+
+class IPAddress {
+public:
+  IPAddress() : _a{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _a{a, b, c, d} {}
+
+  uint8_t operator[](int i) const { return _a[i & 3]; }
+  bool operator==(const IPAddress& o) const {
+    return _a[0] == o._a[0] && _a[1] == o._a[1] && _a[2] == o._a[2] && _a[3] == o._a[3];
+  }
+  bool operator!=(const IPAddress& o) const { return !(*this == o); }
+
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _a[0], _a[1], _a[2], _a[3]);
+    return String(buf);
+  }
+
+private:
+  uint8_t _a[4];
+};
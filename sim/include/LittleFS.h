@@ -0,0 +1,15 @@
+#pragma once
+// Host stand-in for the ESP32 LittleFS library.
+#include <FS.h>
+
+class LittleFSFS : public fs::FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+             uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+  void end() {}
+  bool format();
+  size_t totalBytes() { return 1441792; }   // default 1.4 MB spiffs partition
+  size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,47 @@
+#pragma once
+// Host stand-in for the ESP32 Preferences (NVS) library.
+// Values live in process memory; opens/reads/writes are counted so flash
+// traffic can be compared between runs (see sim_nvs_stats()).
+#include <Arduino.h>
+#include <string>
+
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false);
+  void end();
+
+  bool clear();
+  bool remove(const char* key);
+  bool isKey(const char* key);
+
+  size_t putBytes(const char* key, const void* value, size_t len);
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+  size_t putString(const char* key, const char* value);
+  size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+  String getString(const char* key, const String& defaultValue = String());
+
+  size_t  putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return getScalar(key, defaultValue); }
+  size_t  putBool(const char* key, bool value) { return putUChar(key, value ? 1 : 0); }
+  bool    getBool(const char* key, bool defaultValue = false) { return getUChar(key, defaultValue ? 1 : 0) != 0; }
+  size_t  putUShort(const char* key, uint16_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint16_t getUShort(const char* key, uint16_t defaultValue = 0) { return getScalar(key, defaultValue); }
+  size_t  putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+  int32_t getInt(const char* key, int32_t defaultValue = 0) { return getScalar(key, defaultValue); }
+  size_t  putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return getScalar(key, defaultValue); }
+
+private:
+  template <typename T> T getScalar(const char* key, T defaultValue) {
+    T v;
+    if (getBytesLength(key) != sizeof(T)) return defaultValue;
+    getBytes(key, &v, sizeof(T));
+    return v;
+  }
+
+  std::string _ns;
+  bool _open = false;
+  bool _readOnly = false;
+};
@@ -0,0 +1,185 @@
+#pragma once
+// Host stand-in for Bodmer's TFT_eSPI.
+//
+// Draws into an in-memory 320x240 RGB565 framebuffer and charges every call
+// against an ILI9341 SPI bus model (window setup + pixel payload), so draw
+// paths can be compared by bytes on the wire rather than by eye.
+//
+// Text is "greeked": each glyph is a solid block with the real advance width
+// and cell height of the font, which keeps layout and bus cost faithful
+// without shipping the font bitmaps.
+#include <Arduino.h>
+
+#define TFT_WIDTH  240
+#define TFT_HEIGHT 320
+
+#define TFT_BLACK       0x0000
+#define TFT_NAVY        0x000F
+#define TFT_DARKGREEN   0x03E0
+#define TFT_DARKCYAN    0x03EF
+#define TFT_MAROON      0x7800
+#define TFT_PURPLE      0x780F
+#define TFT_OLIVE       0x7BE0
+#define TFT_LIGHTGREY   0xD69A
+#define TFT_DARKGREY    0x7BEF
+#define TFT_BLUE        0x001F
+#define TFT_GREEN       0x07E0
+#define TFT_CYAN        0x07FF
+#define TFT_RED         0xF800
+#define TFT_MAGENTA     0xF81F
+#define TFT_YELLOW      0xFFE0
+#define TFT_WHITE       0xFFFF
+#define TFT_ORANGE      0xFDA0
+#define TFT_GREENYELLOW 0xB7E0
+#define TFT_PINK        0xFE19
+#define TFT_BROWN       0x9A60
+#define TFT_GOLD        0xFEA0
+#define TFT_SILVER      0xC618
+#define TFT_SKYBLUE     0x867D
+#define TFT_VIOLET      0x915C
+
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define CL_DATUM 3
+#define MC_DATUM 4
+#define CC_DATUM 4
+#define MR_DATUM 5
+#define CR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+class TFT_eSPI {
+public:
+  TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+  virtual ~TFT_eSPI() {}
+
+  void init(uint8_t tc = 0);
+  void begin(uint8_t tc = 0) { init(tc); }
+  void setRotation(uint8_t r);
+  uint8_t getRotation() const { return _rotation; }
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+  void setSwapBytes(bool swap) { _swapBytes = swap; }
+  bool getSwapBytes() const { return _swapBytes; }
+
+  void startWrite() {}
+  void endWrite() {}
+
+  void setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum = true);
+  void resetViewport();
+
+  void fillScreen(uint32_t color);
+  virtual void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  virtual void drawPixel(int32_t x, int32_t y, uint32_t color);
+  virtual void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+  virtual void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+  virtual void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+  void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color);
+  void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+  void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color);
+
+  uint16_t readPixel(int32_t x, int32_t y);
+  void readRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data);
+
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data, uint16_t transparent);
+  void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, uint16_t transparent);
+
+  void setTextColor(uint16_t color);
+  void setTextColor(uint16_t fg, uint16_t bg, bool bgfill = false);
+  void setTextDatum(uint8_t datum) { textdatum = datum; }
+  uint8_t getTextDatum() const { return textdatum; }
+  void setTextFont(uint8_t font) { textfont = font; }
+  void setTextSize(uint8_t size) { textsize = size ? size : 1; }
+
+  int16_t textWidth(const char* s, uint8_t font);
+  int16_t textWidth(const char* s) { return textWidth(s, textfont); }
+  int16_t textWidth(const String& s, uint8_t font) { return textWidth(s.c_str(), font); }
+  int16_t textWidth(const String& s) { return textWidth(s.c_str(), textfont); }
+  int16_t fontHeight(int16_t font);
+  int16_t fontHeight() { return fontHeight(textfont); }
+
+  int16_t drawString(const char* s, int32_t x, int32_t y, uint8_t font);
+  int16_t drawString(const char* s, int32_t x, int32_t y) { return drawString(s, x, y, textfont); }
+  int16_t drawString(const String& s, int32_t x, int32_t y, uint8_t font) { return drawString(s.c_str(), x, y, font); }
+  int16_t drawString(const String& s, int32_t x, int32_t y) { return drawString(s.c_str(), x, y, textfont); }
+  int16_t drawCentreString(const char* s, int32_t x, int32_t y, uint8_t font);
+  int16_t drawCentreString(const String& s, int32_t x, int32_t y, uint8_t font) { return drawCentreString(s.c_str(), x, y, font); }
+  int16_t drawRightString(const char* s, int32_t x, int32_t y, uint8_t font);
+  int16_t drawRightString(const String& s, int32_t x, int32_t y, uint8_t font) { return drawRightString(s.c_str(), x, y, font); }
+
+  virtual void drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size);
+  virtual int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font);
+
+  // Public in the real library too; sketches read them directly.
+  uint16_t textcolor = 0xFFFF;
+  uint16_t textbgcolor = 0xFFFF;
+  uint8_t  textdatum = TL_DATUM;
+  uint8_t  textfont = 1;
+  uint8_t  textsize = 1;
+
+protected:
+  // Surface the primitives write to. The screen instance points at the
+  // simulator framebuffer.
+  uint16_t* _buf = nullptr;
+  int32_t   _bufW = 0;
+  int32_t   _bufH = 0;
+  bool      _onBus = true;
+
+  int32_t _width, _height;
+  uint8_t _rotation = 0;
+  bool    _swapBytes = false;
+
+  int32_t _vpX = 0, _vpY = 0, _vpW = 0, _vpH = 0;
+  int32_t _xDatum = 0, _yDatum = 0;
+  bool    _vpOoB = false;
+
+  // Raw primitives in surface coordinates (datum already applied), clipped
+  // to the viewport. Bus cost is charged by the caller's op scope.
+  void rawFill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color, bool charge = true);
+  void rawPixel(int32_t x, int32_t y, uint16_t color);
+  void rawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color);
+  void rawCircleQuadrants(int32_t x0, int32_t y0, int32_t r, uint8_t mask, uint16_t color);
+  void rawFillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t mask, int32_t delta, uint16_t color);
+  void rawImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, bool keyed, uint16_t key);
+  int16_t rawText(const char* s, int32_t x, int32_t y, uint8_t font);
+  void rawGlyph(int32_t x, int32_t y, char ch, uint8_t font, uint16_t fg, uint16_t bg, bool opaque);
+
+  void     store(int32_t x, int32_t y, uint16_t color);
+  uint16_t fetch(int32_t x, int32_t y) const;
+};
+
+// 16-bit sprite. Pixels are stored in SPI byte order like the real
+// library, so a sprite buffer can be pushed to the screen with
+// setSwapBytes(false) + pushImage().
+class TFT_eSprite : public TFT_eSPI {
+public:
+  explicit TFT_eSprite(TFT_eSPI* parent) : TFT_eSPI(0, 0), _parent(parent) {
+    _buf = nullptr;
+    _bufW = _bufH = 0;
+    _onBus = false;
+    resetViewport();
+  }
+  ~TFT_eSprite() { deleteSprite(); }
+
+  void* createSprite(int16_t w, int16_t h, uint8_t frames = 1);
+  void  deleteSprite();
+  bool  created() const { return _buf != nullptr; }
+  void* getPointer() { return _buf; }
+  void  setColorDepth(int8_t) {}
+  void  fillSprite(uint32_t color) { fillRect(0, 0, _width, _height, color); }
+  void  pushSprite(int32_t x, int32_t y);
+
+private:
+  TFT_eSPI* _parent;
+};
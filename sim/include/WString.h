@@ -0,0 +1,116 @@
+#pragma once
+#include <ctype.h>
+// Host stand-in for the Arduino String class (only what the firmware uses).
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+
+class String {
+public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  String(char c) : _s(1, c) {}
+  String(int v) : _s(std::to_string(v)) {}
+  String(unsigned int v) : _s(std::to_string(v)) {}
+  String(long v) : _s(std::to_string(v)) {}
+  String(unsigned long v) : _s(std::to_string(v)) {}
+
+  unsigned int length() const { return (unsigned int)_s.size(); }
+  const char* c_str() const { return _s.c_str(); }
+  bool reserve(unsigned int n) { _s.reserve(n); return true; }
+
+  char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  char& operator[](unsigned int i) { return _s[i]; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+
+  String& operator+=(const String& o) { _s += o._s; return *this; }
+  String& operator+=(const char* o) { if (o) _s += o; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  String& operator+=(int v) { _s += std::to_string(v); return *this; }
+  bool concat(const String& o) { _s += o._s; return true; }
+  bool concat(const char* o, unsigned int n) { if (o) _s.append(o, n); return true; }
+  bool concat(char c) { _s += c; return true; }
+
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator==(const char* o) const { return o && _s == o; }
+  bool operator!=(const String& o) const { return _s != o._s; }
+  bool operator!=(const char* o) const { return !(*this == o); }
+  bool equals(const String& o) const { return _s == o._s; }
+  bool equalsIgnoreCase(const String& o) const {
+    if (_s.size() != o._s.size()) return false;
+    for (size_t i = 0; i < _s.size(); i++) {
+      if (tolower((unsigned char)_s[i]) != tolower((unsigned char)o._s[i])) return false;
+    }
+    return true;
+  }
+
+  bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+  bool endsWith(const String& p) const {
+    return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0;
+  }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t p = _s.find(c, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int indexOf(const String& s, unsigned int from = 0) const {
+    size_t p = _s.find(s._s, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int lastIndexOf(char c) const {
+    size_t p = _s.rfind(c);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+  int lastIndexOf(char c, unsigned int from) const {
+    if (_s.empty()) return -1;
+    size_t p = _s.rfind(c, from);
+    return p == std::string::npos ? -1 : (int)p;
+  }
+
+  String substring(unsigned int from) const {
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from));
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) { unsigned int t = from; from = to; to = t; }
+    if (from >= _s.size()) return String();
+    if (to > _s.size()) to = (unsigned int)_s.size();
+    return String(_s.substr(from, to - from));
+  }
+
+  void remove(unsigned int idx) { if (idx < _s.size()) _s.erase(idx); }
+  void remove(unsigned int idx, unsigned int count) { if (idx < _s.size()) _s.erase(idx, count); }
+
+  void trim() {
+    size_t a = 0, b = _s.size();
+    while (a < b && isSpace(_s[a])) a++;
+    while (b > a && isSpace(_s[b - 1])) b--;
+    _s = _s.substr(a, b - a);
+  }
+  void toUpperCase() { for (auto& c : _s) c = (char)toupper((unsigned char)c); }
+  void toLowerCase() { for (auto& c : _s) c = (char)tolower((unsigned char)c); }
+
+  void toCharArray(char* buf, unsigned int n) const {
+    if (!buf || n == 0) return;
+    size_t k = _s.size() < n - 1 ? _s.size() : n - 1;
+    memcpy(buf, _s.data(), k);
+    buf[k] = 0;
+  }
+
+  long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+
+  const std::string& str() const { return _s; }
+
+private:
+  static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+  std::string _s;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, int b) { String r(a); r += b; return r; }
@@ -0,0 +1,94 @@
+#pragma once
+// Host stand-in for the ESP32 WiFi library. The link is scripted by the
+// simulator driver; scans return a fixed set of networks after a modeled
+// delay.
+#include <Arduino.h>
+#include <deque>
+#include <string>
+#include <utility>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+typedef enum {
+  WIFI_AUTH_OPEN = 0,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK,
+  WIFI_AUTH_WPA_WPA2_PSK
+} wifi_auth_mode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED  (-2)
+
+class WiFiClass {
+public:
+  wl_status_t status();
+  bool mode(wifi_mode_t m) { _mode = m; return true; }
+  wifi_mode_t getMode() const { return _mode; }
+  bool setSleep(bool) { return true; }
+
+  wl_status_t begin(const char* ssid, const char* pass = nullptr);
+  bool disconnect(bool wifiOff = false);
+
+  int16_t scanNetworks(bool async = false, bool showHidden = false);
+  int16_t scanComplete();
+  void scanDelete();
+
+  String SSID();
+  String SSID(uint8_t i);
+  int32_t RSSI(uint8_t i);
+  wifi_auth_mode_t encryptionType(uint8_t i);
+
+  IPAddress localIP();
+
+private:
+  wifi_mode_t _mode = WIFI_OFF;
+};
+
+extern WiFiClass WiFi;
+
+// ------------------------------------------------------------
+// TCP client (also the base of the TLS client)
+// ------------------------------------------------------------
+class WiFiClient : public Stream {
+public:
+  virtual ~WiFiClient() {}
+  virtual int connect(const char* host, uint16_t port);
+  virtual void stop();
+  virtual uint8_t connected();
+  operator bool() { return connected(); }
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  int read(uint8_t* buf, size_t len);
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len) override { (void)buf; _txBytes += len; return len; }
+  void setTimeout(uint32_t ms) { Stream::setTimeout(ms); }
+
+  // Used by the simulated HTTP layer to hand a response body to the reader.
+  // simFeedAt() queues bytes that only become readable at the given time.
+  void simFeed(const std::string& data, bool keepOpen);
+  void simFeedAt(uint64_t atUs, const std::string& data);
+  uint32_t simTxBytes() const { return _txBytes; }
+
+protected:
+  void simRelease();
+
+  std::string _rx;
+  size_t _rxPos = 0;
+  std::deque<std::pair<uint64_t, std::string>> _rxLater;
+  bool _open = false;
+  uint32_t _txBytes = 0;
+};
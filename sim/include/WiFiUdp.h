@@ -0,0 +1,34 @@
+#pragma once
+#include <WiFi.h>
+#include <vector>
+
+// Host stand-in for WiFiUDP. Incoming datagrams are injected by the driver
+// with sim_udp_push(); outgoing ones are counted and, if the driver asked
+// for it, captured to a file (sim_udp_capture()).
+class WiFiUDP {
+public:
+  uint8_t begin(uint16_t port) { _port = port; _bound = true; return 1; }
+  void stop() { _bound = false; }
+
+  int parsePacket();
+  int available() { return (int)(_cur.size() - _pos); }
+  int read();
+  int read(unsigned char* buf, size_t len);
+  int read(char* buf, size_t len) { return read((unsigned char*)buf, len); }
+  void flush() { _cur.clear(); _pos = 0; }
+
+  IPAddress remoteIP() { return IPAddress(192, 168, 1, 2); }
+  uint16_t remotePort() { return 4211; }
+
+  int beginPacket(IPAddress ip, uint16_t port) { (void)ip; (void)port; _tx.clear(); return 1; }
+  size_t write(uint8_t b) { _tx.push_back(b); return 1; }
+  size_t write(const uint8_t* buf, size_t len) { _tx.insert(_tx.end(), buf, buf + len); return len; }
+  int endPacket();
+
+private:
+  uint16_t _port = 0;
+  bool _bound = false;
+  std::vector<uint8_t> _cur;
+  size_t _pos = 0;
+  std::vector<uint8_t> _tx;
+};
@@ -0,0 +1,20 @@
+#pragma once
+// Host stand-in for bb_captouch. Reports the touch point set by the driver
+// in the controller's native (portrait) frame, like the CST820 does.
+#include <Wire.h>
+
+#define CT_SUCCESS 0
+#define CT_ERROR  -1
+
+typedef struct {
+  uint8_t count;
+  uint16_t x[5], y[5];
+  uint8_t pressure[5], area[5];
+} TOUCHINFO;
+
+class BBCapTouch {
+public:
+  int init(int sda, int scl, int rst = -1, int irq = -1, uint32_t speed = 400000, TwoWire* wire = &Wire);
+  void setOrientation(int orientation, int width, int height) { (void)orientation; (void)width; (void)height; }
+  int getSamples(TOUCHINFO* ti);
+};
@@ -0,0 +1,23 @@
+#pragma once
+// Host stand-in for the FreeRTOS types the ESP32 Arduino core exposes.
+// Tasks are cooperative (see sim/freertos_host.cpp); one tick is 1 ms.
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  0
+#define pdPASS  1
+#define errQUEUE_FULL  0
+#define errQUEUE_EMPTY 0
+
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define tskNO_AFFINITY      0x7FFFFFFF
+
+TickType_t xTaskGetTickCount();
@@ -0,0 +1,24 @@
+#pragma once
+// Mutexes are one-slot queues, as in FreeRTOS itself.
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+  QueueHandle_t q = xQueueCreate(1, 1);
+  uint8_t token = 0;
+  xQueueSend(q, &token, 0);
+  return q;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) {
+  uint8_t token;
+  return xQueueReceive(s, &token, wait);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+  uint8_t token = 0;
+  return xQueueSend(s, &token, 0);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t s) { vQueueDelete(s); }
@@ -0,0 +1,80 @@
+#include <Preferences.h>
+#include <map>
+#include <vector>
+#include "sim.h"
+
+typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+static std::map<std::string, Namespace> g_nvs;
+static SimNvsStat g_nvsStats;
+
+const SimNvsStat* sim_nvs_stats() { return &g_nvsStats; }
+void sim_nvs_stats_reset() { g_nvsStats = SimNvsStat(); }
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  if (!name) return false;
+  _ns = name;
+  _open = true;
+  _readOnly = readOnly;
+  g_nvsStats.opens++;
+  return true;
+}
+
+void Preferences::end() { _open = false; }
+
+bool Preferences::clear() {
+  if (!_open || _readOnly) return false;
+  g_nvs[_ns].clear();
+  g_nvsStats.writes++;
+  return true;
+}
+
+bool Preferences::remove(const char* key) {
+  if (!_open || _readOnly || !key) return false;
+  g_nvsStats.writes++;
+  return g_nvs[_ns].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+  if (!_open || !key) return false;
+  Namespace& ns = g_nvs[_ns];
+  return ns.find(key) != ns.end();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (!_open || _readOnly || !key || (!value && len)) return 0;
+  const uint8_t* p = (const uint8_t*)value;
+  g_nvs[_ns][key].assign(p, p + len);
+  g_nvsStats.writes++;
+  return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!_open || !key) return 0;
+  Namespace& ns = g_nvs[_ns];
+  auto it = ns.find(key);
+  return it == ns.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  if (!_open || !key || !buf) return 0;
+  Namespace& ns = g_nvs[_ns];
+  auto it = ns.find(key);
+  if (it == ns.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  g_nvsStats.reads++;
+  return it->second.size();
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+  if (!value) return 0;
+  return putBytes(key, value, strlen(value) + 1) ? strlen(value) : 0;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+  if (!_open || !key) return defaultValue;
+  Namespace& ns = g_nvs[_ns];
+  auto it = ns.find(key);
+  if (it == ns.end() || it->second.empty()) return defaultValue;
+  g_nvsStats.reads++;
+  return String(std::string((const char*)it->second.data(), strnlen((const char*)it->second.data(), it->second.size())));
+}
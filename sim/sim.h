@@ -0,0 +1,128 @@
+#pragma once
+// Host simulator control surface.
+// The shims in sim/include implement the Arduino / TFT_eSPI / WiFi APIs the
+// firmware uses; this header is how the driver (sim_main.cpp) pokes at them.
+#include <stdint.h>
+#include <stddef.h>
+
+// ------------------------------------------------------------
+// Virtual clock
+// ------------------------------------------------------------
+// Time only moves when the driver says so, when firmware calls delay(),
+// or when the display bus model charges for a transfer. This keeps every
+// run deterministic regardless of host speed.
+uint64_t sim_clock_us();
+void     sim_clock_advance_us(uint64_t us);
+
+// ------------------------------------------------------------
+// FreeRTOS model
+// ------------------------------------------------------------
+// Tasks run on their own stacks, one at a time, between loop() iterations.
+// A task that blocks (delay, queue wait, network latency) sleeps on the
+// virtual clock while loop() keeps going, like work on the second core.
+void sim_tasks_run();
+bool sim_in_task();
+
+// Spends modelled time. Inside a task only that task waits; on the loop
+// the clock advances, as before.
+void sim_block_us(uint64_t us);
+
+// ------------------------------------------------------------
+// Display bus model
+// ------------------------------------------------------------
+static const int SIM_SCREEN_W = 320;
+static const int SIM_SCREEN_H = 240;
+
+// ILI9341 on the CYD boards runs at 40 MHz write / 20 MHz read.
+static const uint32_t SIM_SPI_WRITE_HZ = 40000000;
+static const uint32_t SIM_SPI_READ_HZ  = 20000000;
+
+enum SimDrawOp {
+  SIM_OP_FILL_SCREEN = 0,
+  SIM_OP_FILL_RECT,
+  SIM_OP_DRAW_PIXEL,
+  SIM_OP_READ_PIXEL,
+  SIM_OP_PUSH_IMAGE,
+  SIM_OP_DRAW_STRING,
+  SIM_OP_DRAW_CHAR,
+  SIM_OP_LINE,
+  SIM_OP_SHAPE,
+  SIM_OP_COUNT
+};
+
+struct SimDrawStat {
+  uint32_t calls;
+  uint64_t pixels;
+  uint64_t bytes;
+  uint64_t busUs;
+};
+
+const uint16_t*    sim_framebuffer();
+const SimDrawStat* sim_draw_stats();          // SIM_OP_COUNT entries
+const char*        sim_draw_op_name(int op);
+void               sim_draw_stats_reset();
+bool               sim_dump_ppm(const char* path);
+
+// ------------------------------------------------------------
+// Inputs
+// ------------------------------------------------------------
+// Runs the ISR attached to `pin`, if any, on the driver's stack.
+void sim_gpio_interrupt(uint8_t pin);
+
+// The CST820 pulls its INT line (GPIO 21 on the board) for every new
+// report: finger down, each move, and the release.
+static const uint8_t SIM_TOUCH_INT_PIN = 21;
+
+struct SimTouchStat {
+  uint32_t irqs;
+  uint32_t reads;   // I2C sample bursts
+};
+
+void sim_touch_set(bool pressed, int x, int y);
+const SimTouchStat* sim_touch_stats();
+void                sim_touch_stats_reset();
+void sim_serial_push_line(const char* line);
+void sim_udp_push(const uint8_t* data, size_t len);
+
+// Datagrams the firmware sent. With a capture file set, each one is also
+// appended to it as a little-endian u16 length and the payload.
+struct SimUdpStat {
+  uint32_t sent;
+  uint64_t bytes;
+};
+
+void                sim_udp_capture(const char* path);
+const SimUdpStat*   sim_udp_stats();
+void                sim_udp_stats_reset();
+
+// ------------------------------------------------------------
+// Network model
+// ------------------------------------------------------------
+void     sim_wifi_set_connected(bool on);
+void     sim_http_set_latency_ms(uint32_t ms);       // full generation time
+void     sim_http_set_first_token_ms(uint32_t ms);   // time to first streamed token
+void     sim_http_set_response(const char* text);
+
+// ------------------------------------------------------------
+// NVS model
+// ------------------------------------------------------------
+struct SimNvsStat {
+  uint32_t opens;
+  uint32_t reads;
+  uint32_t writes;
+};
+
+const SimNvsStat* sim_nvs_stats();
+void              sim_nvs_stats_reset();
+
+// ------------------------------------------------------------
+// LittleFS model
+// ------------------------------------------------------------
+struct SimFsStat {
+  uint32_t opens;
+  uint64_t bytesRead;
+  uint64_t bytesWritten;
+};
+
+const SimFsStat* sim_fs_stats();
+void             sim_fs_stats_reset();
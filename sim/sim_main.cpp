@@ -0,0 +1,253 @@
+// Host simulator driver.
+//
+// Runs the firmware's setup()/loop() against the shims in sim/include and
+// replays a scenario script against it. Time is virtual: every loop pass
+// costs SIM_LOOP_US plus whatever the display bus and network models
+// charge, so two runs of the same script produce the same numbers.
+//
+//   xp_sim [scenario.sim]
+//
+// Scenario commands (one per line, '#' starts a comment):
+//   wait <ms>                 run loop() for <ms> of virtual time
+//   tap <x> <y>               press, hold 60 ms, release
+//   down <x> <y> / up         finger down / up
+//   move <x> <y> [steps]      slide the finger (10 ms per step)
+//   wifi connect|disconnect   force the Wi-Fi link state
+//   serial <line>             feed a line to Serial
+//   udp <payload>             deliver a datagram to the firmware
+//   mouse <x> <y> <buttons> [wheel]
+//                             one mouse bridge packet (absolute position,
+//                             button bitmask, wheel steps)
+//   mouse lose                use up a sequence number, as a lost packet
+//   keys <text>               typed on the bridge; \b is backspace, \n enter
+//   keys repeat               send the last keys packet again
+//   keys seq <n>              number the next keys packet n, as a
+//                             restarted bridge would
+//   mirror [full]             the bridge asks for the screen (and a full
+//                             frame); repeat within 2 s to keep it going
+//   udpcap <file>             append every datagram the firmware sends
+//   reply <text>              canned AI reply for the next requests
+//   latency <ms>              modeled AI round-trip time
+//   ttft <ms>                 time to the first streamed token
+//   dump <file.ppm>           write the framebuffer
+//   stats [label]             print draw/NVS counters, then reset them
+#include <Arduino.h>
+#include <string>
+#include "sim.h"
+
+void setup();
+void loop();
+
+static const uint64_t SIM_LOOP_US = 1000;
+
+static bool g_down = false;
+static int  g_x = 0, g_y = 0;
+
+// Mouse bridge state, as mouse_bridge_window.py keeps it.
+static uint16_t g_mouseSeq = 0;
+static uint8_t g_wheelTotal = 0;
+
+static uint16_t g_keySeq = 0x4000;
+static std::string g_lastKeys;
+
+static void keysPacket(const std::string& text) {
+  g_lastKeys = std::string("\x02\x04") + (char)g_keySeq + (char)(g_keySeq >> 8);
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '\\' && i + 1 < text.size() && (text[i + 1] == 'b' || text[i + 1] == 'n')) {
+      g_lastKeys += text[++i] == 'b' ? '\b' : '\n';
+    } else {
+      g_lastKeys += text[i];
+    }
+  }
+  g_keySeq++;
+  sim_udp_push((const uint8_t*)g_lastKeys.data(), g_lastKeys.size());
+}
+
+static void mousePacket(int x, int y, int buttons, int wheel) {
+  g_wheelTotal = (uint8_t)(g_wheelTotal + wheel);
+  uint8_t pkt[11] = {2, 1, (uint8_t)g_mouseSeq, (uint8_t)(g_mouseSeq >> 8),
+                     (uint8_t)buttons, g_wheelTotal, 1,
+                     (uint8_t)x, (uint8_t)(x >> 8), (uint8_t)y, (uint8_t)(y >> 8)};
+  g_mouseSeq++;
+  sim_udp_push(pkt, sizeof(pkt));
+}
+
+static void runFor(uint32_t ms) {
+  uint64_t end = sim_clock_us() + (uint64_t)ms * 1000ULL;
+  while (sim_clock_us() < end) {
+    loop();
+    sim_tasks_run();
+    sim_clock_advance_us(SIM_LOOP_US);
+  }
+  fflush(stdout);
+}
+
+static void printStats(const char* label) {
+  const SimDrawStat* st = sim_draw_stats();
+  SimDrawStat total = {0, 0, 0, 0};
+
+  printf("\n== stats: %s (t=%.3f s) ==\n", label, sim_clock_us() / 1e6);
+  printf("%-12s %10s %12s %12s %10s\n", "op", "calls", "pixels", "bus_bytes", "bus_ms");
+  for (int i = 0; i < SIM_OP_COUNT; i++) {
+    if (st[i].calls == 0) continue;
+    printf("%-12s %10u %12llu %12llu %10.2f\n", sim_draw_op_name(i), st[i].calls,
+           (unsigned long long)st[i].pixels, (unsigned long long)st[i].bytes, st[i].busUs / 1000.0);
+    total.calls += st[i].calls;
+    total.pixels += st[i].pixels;
+    total.bytes += st[i].bytes;
+    total.busUs += st[i].busUs;
+  }
+  printf("%-12s %10u %12llu %12llu %10.2f\n", "TOTAL", total.calls,
+         (unsigned long long)total.pixels, (unsigned long long)total.bytes, total.busUs / 1000.0);
+
+  const SimNvsStat* nv = sim_nvs_stats();
+  printf("nvs: opens=%u reads=%u writes=%u\n", nv->opens, nv->reads, nv->writes);
+  const SimTouchStat* ts = sim_touch_stats();
+  printf("touch: irqs=%u i2c_reads=%u\n", ts->irqs, ts->reads);
+  const SimFsStat* fs = sim_fs_stats();
+  if (fs->opens) {
+    printf("fs: opens=%u read=%llu B written=%llu B\n", fs->opens,
+           (unsigned long long)fs->bytesRead, (unsigned long long)fs->bytesWritten);
+  }
+  const SimUdpStat* us = sim_udp_stats();
+  if (us->sent) {
+    printf("udp: sent=%u bytes=%llu\n", us->sent, (unsigned long long)us->bytes);
+  }
+  fflush(stdout);
+
+  sim_draw_stats_reset();
+  sim_udp_stats_reset();
+  sim_nvs_stats_reset();
+  sim_fs_stats_reset();
+  sim_touch_stats_reset();
+}
+
+static void touchStep(bool down, int x, int y) {
+  g_down = down;
+  g_x = x;
+  g_y = y;
+  sim_touch_set(down, x, y);
+}
+
+static std::string restOf(const std::string& line, size_t skipWords) {
+  size_t p = 0;
+  for (size_t i = 0; i < skipWords; i++) {
+    p = line.find_first_not_of(" \t", p);
+    if (p == std::string::npos) return "";
+    p = line.find_first_of(" \t", p);
+    if (p == std::string::npos) return "";
+  }
+  p = line.find_first_not_of(" \t", p);
+  return p == std::string::npos ? "" : line.substr(p);
+}
+
+static bool runCommand(const std::string& raw) {
+  std::string line = raw;
+  size_t hash = line.find('#');
+  if (hash != std::string::npos && line.compare(0, 6, "serial") != 0 && line.compare(0, 3, "udp") != 0 &&
+      line.compare(0, 4, "keys") != 0) {
+    line = line.substr(0, hash);
+  }
+  char cmd[32] = {0};
+  if (sscanf(line.c_str(), "%31s", cmd) != 1) return true;
+  std::string c = cmd;
+
+  int a = 0, b = 0, n = 0;
+  if (c == "wait") {
+    if (sscanf(line.c_str(), "%*s %d", &a) == 1) runFor((uint32_t)a);
+  } else if (c == "tap") {
+    if (sscanf(line.c_str(), "%*s %d %d", &a, &b) != 2) return false;
+    touchStep(true, a, b);
+    runFor(60);
+    touchStep(false, a, b);
+    runFor(60);
+  } else if (c == "down") {
+    if (sscanf(line.c_str(), "%*s %d %d", &a, &b) != 2) return false;
+    touchStep(true, a, b);
+    runFor(20);
+  } else if (c == "move") {
+    int k = sscanf(line.c_str(), "%*s %d %d %d", &a, &b, &n);
+    if (k < 2) return false;
+    if (k < 3 || n < 1) n = 1;
+    int x0 = g_x, y0 = g_y;
+    for (int i = 1; i <= n; i++) {
+      touchStep(g_down, x0 + (a - x0) * i / n, y0 + (b - y0) * i / n);
+      runFor(10);
+    }
+  } else if (c == "up") {
+    touchStep(false, g_x, g_y);
+    runFor(20);
+  } else if (c == "wifi") {
+    sim_wifi_set_connected(restOf(line, 1).compare(0, 7, "connect") == 0);
+  } else if (c == "serial") {
+    sim_serial_push_line(restOf(line, 1).c_str());
+  } else if (c == "udp") {
+    std::string p = restOf(line, 1);
+    sim_udp_push((const uint8_t*)p.data(), p.size());
+  } else if (c == "mouse") {
+    int w = 0;
+    if (restOf(line, 1) == "lose") {
+      g_mouseSeq++;
+    } else {
+      if (sscanf(line.c_str(), "%*s %d %d %d %d", &a, &b, &n, &w) < 3) return false;
+      mousePacket(a, b, n, w);
+    }
+  } else if (c == "keys") {
+    std::string text = restOf(line, 1);
+    if (text == "repeat") sim_udp_push((const uint8_t*)g_lastKeys.data(), g_lastKeys.size());
+    else if (sscanf(line.c_str(), "%*s seq %d", &a) == 1) g_keySeq = (uint16_t)a;
+    else keysPacket(text);
+  } else if (c == "mirror") {
+    uint8_t pkt[3] = {2, 3, (uint8_t)(restOf(line, 1) == "full" ? 1 : 0)};
+    sim_udp_push(pkt, sizeof(pkt));
+  } else if (c == "udpcap") {
+    sim_udp_capture(restOf(line, 1).c_str());
+  } else if (c == "reply") {
+    sim_http_set_response(restOf(line, 1).c_str());
+  } else if (c == "latency") {
+    if (sscanf(line.c_str(), "%*s %d", &a) == 1) sim_http_set_latency_ms((uint32_t)a);
+  } else if (c == "ttft") {
+    if (sscanf(line.c_str(), "%*s %d", &a) == 1) sim_http_set_first_token_ms((uint32_t)a);
+  } else if (c == "dump") {
+    std::string path = restOf(line, 1);
+    if (!sim_dump_ppm(path.c_str())) fprintf(stderr, "sim: cannot write %s\n", path.c_str());
+  } else if (c == "stats") {
+    std::string label = restOf(line, 1);
+    printStats(label.empty() ? "-" : label.c_str());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  setup();
+  printStats("boot");
+
+  if (argc < 2) {
+    runFor(2000);
+    printStats("idle 2s");
+    return 0;
+  }
+
+  FILE* f = fopen(argv[1], "r");
+  if (!f) {
+    fprintf(stderr, "sim: cannot open %s\n", argv[1]);
+    return 1;
+  }
+
+  char buf[512];
+  int lineNo = 0;
+  while (fgets(buf, sizeof(buf), f)) {
+    lineNo++;
+    std::string line = buf;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+    if (!runCommand(line)) {
+      fprintf(stderr, "sim: %s:%d: bad command: %s\n", argv[1], lineNo, line.c_str());
+      fclose(f);
+      return 1;
+    }
+  }
+  fclose(f);
+  return 0;
+}
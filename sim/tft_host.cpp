@@ -0,0 +1,588 @@
+#include <TFT_eSPI.h>
+#include "sim.h"
+#include "text_metrics.h"
+
+// ============================================================
+// Framebuffer + bus accounting
+// ============================================================
+static uint16_t g_fb[SIM_SCREEN_W * SIM_SCREEN_H];
+
+static SimDrawStat g_stats[SIM_OP_COUNT];
+
+// Only the outermost public call on a bus surface is counted; shapes that
+// are built from lines, or text built from glyphs, are charged to the call
+// the firmware actually made.
+static int      g_depth = 0;
+static int      g_op = -1;
+static uint64_t g_opPixels = 0;
+static double   g_opWriteBytes = 0;
+static double   g_opReadBytes = 0;
+
+// Cost of a CASET + PASET + RAMWR window setup on the ILI9341.
+static const int WINDOW_BYTES = 11;
+
+static const char* OP_NAMES[SIM_OP_COUNT] = {
+  "fillScreen", "fillRect", "drawPixel", "readPixel", "pushImage",
+  "drawString", "drawChar", "lines", "shapes"
+};
+
+namespace {
+struct OpScope {
+  bool active;
+  OpScope(bool onBus, int op) : active(onBus) {
+    if (!active) return;
+    if (g_depth++ == 0) {
+      g_op = op;
+      g_opPixels = 0;
+      g_opWriteBytes = 0;
+      g_opReadBytes = 0;
+    }
+  }
+  ~OpScope() {
+    if (!active) return;
+    if (--g_depth != 0) return;
+    double us = g_opWriteBytes * 8.0 * 1e6 / SIM_SPI_WRITE_HZ +
+                g_opReadBytes * 8.0 * 1e6 / SIM_SPI_READ_HZ;
+    SimDrawStat& s = g_stats[g_op];
+    s.calls++;
+    s.pixels += g_opPixels;
+    s.bytes += (uint64_t)(g_opWriteBytes + g_opReadBytes);
+    s.busUs += (uint64_t)us;
+    sim_clock_advance_us((uint64_t)us);
+    g_op = -1;
+  }
+};
+}
+
+static inline void chargeWindow(bool onBus, uint64_t pixels) {
+  if (!onBus || g_depth == 0) return;
+  g_opPixels += pixels;
+  g_opWriteBytes += WINDOW_BYTES + 2.0 * pixels;
+}
+
+static inline void chargeRead(bool onBus, uint64_t pixels) {
+  if (!onBus || g_depth == 0) return;
+  // Window setup, RAMRD, one dummy byte, then 3 bytes per pixel (18 bit).
+  g_opReadBytes += WINDOW_BYTES + 2 + 3.0 * pixels;
+}
+
+static inline uint16_t bswap16(uint16_t v) { return (uint16_t)((v >> 8) | (v << 8)); }
+
+const uint16_t* sim_framebuffer() { return g_fb; }
+const SimDrawStat* sim_draw_stats() { return g_stats; }
+const char* sim_draw_op_name(int op) { return (op >= 0 && op < SIM_OP_COUNT) ? OP_NAMES[op] : "?"; }
+void sim_draw_stats_reset() { memset(g_stats, 0, sizeof(g_stats)); }
+
+bool sim_dump_ppm(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %d\n255\n", SIM_SCREEN_W, SIM_SCREEN_H);
+  for (int i = 0; i < SIM_SCREEN_W * SIM_SCREEN_H; i++) {
+    uint16_t c = g_fb[i];
+    uint8_t rgb[3] = {
+      (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+      (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+      (uint8_t)((c & 0x1F) * 255 / 31)
+    };
+    fwrite(rgb, 1, 3, f);
+  }
+  fclose(f);
+  return true;
+}
+
+// ============================================================
+// Font metrics
+// ============================================================
+// Glyph advances come from the firmware's table (text_metrics.h), which
+// mirrors the real fonts, so textWidth() and the firmware's own
+// measurement always agree.
+static int glyphAdvance(uint8_t font, unsigned char ch) {
+  return text_advance(font, ch);
+}
+
+int16_t TFT_eSPI::fontHeight(int16_t font) {
+  if (font == 2) return 16;
+  if (font == 4) return 26;
+  return 8 * textsize;
+}
+
+int16_t TFT_eSPI::textWidth(const char* s, uint8_t font) {
+  if (!s) return 0;
+  int w = 0;
+  for (const unsigned char* p = (const unsigned char*)s; *p; p++) w += glyphAdvance(font, *p);
+  if (font != 2 && font != 4) w *= textsize;
+  return (int16_t)w;
+}
+
+// ============================================================
+// Construction / surface
+// ============================================================
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : _width(w), _height(h) {
+  _buf = g_fb;
+  _bufW = SIM_SCREEN_W;
+  _bufH = SIM_SCREEN_H;
+  resetViewport();
+}
+
+void TFT_eSPI::init(uint8_t) {
+  _rotation = 0;
+  _width = TFT_WIDTH;
+  _height = TFT_HEIGHT;
+  resetViewport();
+}
+
+void TFT_eSPI::setRotation(uint8_t r) {
+  _rotation = r & 3;
+  // The simulated panel is always stored landscape; portrait rotations
+  // only swap the reported size.
+  if (_rotation & 1) { _width = TFT_HEIGHT; _height = TFT_WIDTH; }
+  else               { _width = TFT_WIDTH;  _height = TFT_HEIGHT; }
+  resetViewport();
+}
+
+void TFT_eSPI::resetViewport() {
+  _vpX = 0; _vpY = 0;
+  _vpW = min((int32_t)_width, _bufW);
+  _vpH = min((int32_t)_height, _bufH);
+  _xDatum = 0; _yDatum = 0;
+  _vpOoB = false;
+}
+
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h, bool vpDatum) {
+  _xDatum = x;
+  _yDatum = y;
+  _vpOoB = false;
+
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > _width)  w = _width - x;
+  if (y + h > _height) h = _height - y;
+
+  if (w < 1 || h < 1) {
+    _xDatum = 0; _yDatum = 0;
+    _vpX = _vpY = _vpW = _vpH = 0;
+    _vpOoB = true;
+    return;
+  }
+
+  if (!vpDatum) { _xDatum = 0; _yDatum = 0; }
+
+  _vpX = x;
+  _vpY = y;
+  _vpW = x + w;
+  _vpH = y + h;
+}
+
+void TFT_eSPI::store(int32_t x, int32_t y, uint16_t color) {
+  if (!_buf) return;
+  // Sprites keep pixels in SPI byte order, like the real library.
+  _buf[y * _bufW + x] = _onBus ? color : bswap16(color);
+}
+
+uint16_t TFT_eSPI::fetch(int32_t x, int32_t y) const {
+  if (!_buf) return 0;
+  uint16_t v = _buf[y * _bufW + x];
+  return _onBus ? v : bswap16(v);
+}
+
+// ============================================================
+// Raw primitives
+// ============================================================
+void TFT_eSPI::rawFill(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color, bool charge) {
+  if (_vpOoB) return;
+  if (x < _vpX) { w -= _vpX - x; x = _vpX; }
+  if (y < _vpY) { h -= _vpY - y; y = _vpY; }
+  if (x + w > _vpW) w = _vpW - x;
+  if (y + h > _vpH) h = _vpH - y;
+  if (w <= 0 || h <= 0) return;
+
+  for (int32_t yy = y; yy < y + h; yy++) {
+    for (int32_t xx = x; xx < x + w; xx++) store(xx, yy, color);
+  }
+  if (charge) chargeWindow(_onBus, (uint64_t)w * h);
+}
+
+void TFT_eSPI::rawPixel(int32_t x, int32_t y, uint16_t color) {
+  if (_vpOoB) return;
+  if (x < _vpX || y < _vpY || x >= _vpW || y >= _vpH) return;
+  store(x, y, color);
+  chargeWindow(_onBus, 1);
+}
+
+void TFT_eSPI::rawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color) {
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+  if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+  if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+
+  int32_t dx = x1 - x0, dy = abs(y1 - y0);
+  int32_t err = dx >> 1, ystep = (y0 < y1) ? 1 : -1;
+  int32_t runStart = x0;
+
+  // Emit straight runs as one window each, as TFT_eSPI does.
+  for (int32_t x = x0; x <= x1; x++) {
+    err -= dy;
+    bool stepNow = (err < 0) || x == x1;
+    if (stepNow) {
+      int32_t len = x - runStart + 1;
+      if (steep) rawFill(y0, runStart, 1, len, color);
+      else       rawFill(runStart, y0, len, 1, color);
+      runStart = x + 1;
+      if (err < 0) { y0 += ystep; err += dx; }
+    }
+  }
+}
+
+void TFT_eSPI::rawCircleQuadrants(int32_t x0, int32_t y0, int32_t r, uint8_t mask, uint16_t color) {
+  int32_t f = 1 - r, ddx = 1, ddy = -2 * r, x = 0, y = r;
+  while (x < y) {
+    if (f >= 0) { y--; ddy += 2; f += ddy; }
+    x++; ddx += 2; f += ddx;
+    if (mask & 0x4) { rawPixel(x0 + x, y0 + y, color); rawPixel(x0 + y, y0 + x, color); }
+    if (mask & 0x2) { rawPixel(x0 + x, y0 - y, color); rawPixel(x0 + y, y0 - x, color); }
+    if (mask & 0x8) { rawPixel(x0 - y, y0 + x, color); rawPixel(x0 - x, y0 + y, color); }
+    if (mask & 0x1) { rawPixel(x0 - y, y0 - x, color); rawPixel(x0 - x, y0 - y, color); }
+  }
+}
+
+void TFT_eSPI::rawFillCircleHelper(int32_t x0, int32_t y0, int32_t r, uint8_t mask, int32_t delta, uint16_t color) {
+  int32_t f = 1 - r, ddx = 1, ddy = -2 * r, x = 0, y = r;
+  while (x < y) {
+    if (f >= 0) { y--; ddy += 2; f += ddy; }
+    x++; ddx += 2; f += ddx;
+    if (mask & 0x1) {
+      rawFill(x0 + x, y0 - y, 1, 2 * y + 1 + delta, color);
+      rawFill(x0 + y, y0 - x, 1, 2 * x + 1 + delta, color);
+    }
+    if (mask & 0x2) {
+      rawFill(x0 - x, y0 - y, 1, 2 * y + 1 + delta, color);
+      rawFill(x0 - y, y0 - x, 1, 2 * x + 1 + delta, color);
+    }
+  }
+}
+
+void TFT_eSPI::rawImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, bool keyed, uint16_t key) {
+  if (!data || _vpOoB) return;
+  int32_t dx = 0, dy = 0, dw = w, dh = h;
+  if (x < _vpX) { dx = _vpX - x; dw -= dx; x = _vpX; }
+  if (y < _vpY) { dy = _vpY - y; dh -= dy; y = _vpY; }
+  if (x + dw > _vpW) dw = _vpW - x;
+  if (y + dh > _vpH) dh = _vpH - y;
+  if (dw <= 0 || dh <= 0) return;
+
+  // Sprites: _swapBytes=true means the source is native RGB565, which the
+  // sprite stores swapped; the screen treats it the same way on the wire.
+  for (int32_t row = 0; row < dh; row++) {
+    const uint16_t* src = data + (dy + row) * w + dx;
+    int32_t runLen = 0;
+    for (int32_t col = 0; col < dw; col++) {
+      uint16_t raw = src[col];
+      if (keyed && raw == key) {
+        if (runLen) { chargeWindow(_onBus, runLen); runLen = 0; }
+        continue;
+      }
+      uint16_t c = _swapBytes ? raw : bswap16(raw);
+      store(x + col, y + row, c);
+      runLen++;
+    }
+    if (keyed && runLen) chargeWindow(_onBus, runLen);
+  }
+  if (!keyed) chargeWindow(_onBus, (uint64_t)dw * dh);
+}
+
+void TFT_eSPI::rawGlyph(int32_t x, int32_t y, char ch, uint8_t font, uint16_t fg, uint16_t bg, bool opaque) {
+  unsigned char uc = (unsigned char)ch;
+  int adv = glyphAdvance(font, uc);
+  if (adv <= 0) return;
+  int scale = (font == 2 || font == 4) ? 1 : textsize;
+  if (scale > 1) adv *= scale;
+  int cellH = fontHeight(font);
+
+  if (opaque) rawFill(x, y, adv, cellH, bg);
+  if (uc == ' ') return;
+
+  // Greeked glyph: capitals and digits stand taller than lower case.
+  int top, bottom;
+  if (font == 2)      { top = 3; bottom = 13; }
+  else if (font == 4) { top = 4; bottom = 22; }
+  else                { top = 1 * scale; bottom = 7 * scale; }
+  if (islower(uc)) top += (bottom - top) / 3;
+
+  int gw = adv > 2 ? adv - 1 : 1;
+  int gh = bottom - top;
+  // When the cell was filled opaquely the glyph rides in the same window.
+  rawFill(x, y + top, gw, gh, fg, !opaque);
+}
+
+int16_t TFT_eSPI::rawText(const char* s, int32_t x, int32_t y, uint8_t font) {
+  if (!s) return 0;
+  int16_t w = textWidth(s, font);
+  int16_t h = fontHeight(font);
+
+  switch (textdatum) {
+    case TC_DATUM: x -= w / 2; break;
+    case TR_DATUM: x -= w; break;
+    case ML_DATUM: y -= h / 2; break;
+    case MC_DATUM: x -= w / 2; y -= h / 2; break;
+    case MR_DATUM: x -= w; y -= h / 2; break;
+    case BL_DATUM: y -= h; break;
+    case BC_DATUM: x -= w / 2; y -= h; break;
+    case BR_DATUM: x -= w; y -= h; break;
+    default: break;
+  }
+
+  bool opaque = (textbgcolor != textcolor);
+  int32_t cx = x;
+  for (const char* p = s; *p; p++) {
+    rawGlyph(cx, y, *p, font, textcolor, textbgcolor, opaque);
+    int adv = glyphAdvance(font, (unsigned char)*p);
+    if (font != 2 && font != 4) adv *= textsize;
+    cx += adv;
+  }
+  return w;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+void TFT_eSPI::fillScreen(uint32_t color) {
+  OpScope op(_onBus, SIM_OP_FILL_SCREEN);
+  rawFill(_vpX, _vpY, _vpW - _vpX, _vpH - _vpY, (uint16_t)color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_FILL_RECT);
+  rawFill(x + _xDatum, y + _yDatum, w, h, (uint16_t)color);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_DRAW_PIXEL);
+  rawPixel(x + _xDatum, y + _yDatum, (uint16_t)color);
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_LINE);
+  rawFill(x + _xDatum, y + _yDatum, w, 1, (uint16_t)color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_LINE);
+  rawFill(x + _xDatum, y + _yDatum, 1, h, (uint16_t)color);
+}
+
+void TFT_eSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_LINE);
+  rawLine(x0 + _xDatum, y0 + _yDatum, x1 + _xDatum, y1 + _yDatum, (uint16_t)color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_SHAPE);
+  x += _xDatum; y += _yDatum;
+  rawFill(x, y, w, 1, (uint16_t)color);
+  rawFill(x, y + h - 1, w, 1, (uint16_t)color);
+  rawFill(x, y + 1, 1, h - 2, (uint16_t)color);
+  rawFill(x + w - 1, y + 1, 1, h - 2, (uint16_t)color);
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_SHAPE);
+  x += _xDatum; y += _yDatum;
+  uint16_t c = (uint16_t)color;
+  rawFill(x + r, y, w - 2 * r, 1, c);
+  rawFill(x + r, y + h - 1, w - 2 * r, 1, c);
+  rawFill(x, y + r, 1, h - 2 * r, c);
+  rawFill(x + w - 1, y + r, 1, h - 2 * r, c);
+  rawCircleQuadrants(x + r, y + r, r, 0x1, c);
+  rawCircleQuadrants(x + w - r - 1, y + r, r, 0x2, c);
+  rawCircleQuadrants(x + w - r - 1, y + h - r - 1, r, 0x4, c);
+  rawCircleQuadrants(x + r, y + h - r - 1, r, 0x8, c);
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_SHAPE);
+  x += _xDatum; y += _yDatum;
+  uint16_t c = (uint16_t)color;
+  rawFill(x + r, y, w - 2 * r, h, c);
+  rawFillCircleHelper(x + w - r - 1, y + r, r, 0x1, h - 2 * r - 1, c);
+  rawFillCircleHelper(x + r, y + r, r, 0x2, h - 2 * r - 1, c);
+  rawFill(x, y + r, r, h - 2 * r, c);
+  rawFill(x + w - r, y + r, r, h - 2 * r, c);
+}
+
+void TFT_eSPI::drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_SHAPE);
+  x += _xDatum; y += _yDatum;
+  uint16_t c = (uint16_t)color;
+  rawPixel(x, y + r, c);
+  rawPixel(x, y - r, c);
+  rawPixel(x + r, y, c);
+  rawPixel(x - r, y, c);
+  rawCircleQuadrants(x, y, r, 0xF, c);
+}
+
+void TFT_eSPI::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_SHAPE);
+  x += _xDatum; y += _yDatum;
+  rawFill(x, y - r, 1, 2 * r + 1, (uint16_t)color);
+  rawFillCircleHelper(x, y, r, 0x3, 0, (uint16_t)color);
+}
+
+void TFT_eSPI::drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_SHAPE);
+  int32_t dx = _xDatum, dy = _yDatum;
+  rawLine(x0 + dx, y0 + dy, x1 + dx, y1 + dy, (uint16_t)color);
+  rawLine(x1 + dx, y1 + dy, x2 + dx, y2 + dy, (uint16_t)color);
+  rawLine(x2 + dx, y2 + dy, x0 + dx, y0 + dy, (uint16_t)color);
+}
+
+void TFT_eSPI::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+  OpScope op(_onBus, SIM_OP_SHAPE);
+  x0 += _xDatum; x1 += _xDatum; x2 += _xDatum;
+  y0 += _yDatum; y1 += _yDatum; y2 += _yDatum;
+  if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+  if (y1 > y2) { std::swap(y2, y1); std::swap(x2, x1); }
+  if (y0 > y1) { std::swap(y0, y1); std::swap(x0, x1); }
+
+  uint16_t c = (uint16_t)color;
+  if (y0 == y2) {
+    int32_t a = min(x0, min(x1, x2)), b = max(x0, max(x1, x2));
+    rawFill(a, y0, b - a + 1, 1, c);
+    return;
+  }
+
+  for (int32_t y = y0; y <= y2; y++) {
+    float ta = (float)(y - y0) / (float)(y2 - y0);
+    int32_t a = x0 + (int32_t)lroundf((x2 - x0) * ta);
+    int32_t b;
+    if (y < y1 || y1 == y2) {
+      float tb = (y1 == y0) ? 1.0f : (float)(y - y0) / (float)(y1 - y0);
+      b = x0 + (int32_t)lroundf((x1 - x0) * tb);
+    } else {
+      float tb = (float)(y - y1) / (float)(y2 - y1);
+      b = x1 + (int32_t)lroundf((x2 - x1) * tb);
+    }
+    if (a > b) std::swap(a, b);
+    rawFill(a, y, b - a + 1, 1, c);
+  }
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) {
+  OpScope op(_onBus, SIM_OP_READ_PIXEL);
+  x += _xDatum; y += _yDatum;
+  if (x < 0 || y < 0 || x >= _bufW || y >= _bufH) return 0;
+  chargeRead(_onBus, 1);
+  return fetch(x, y);
+}
+
+// Like the real library, pixels come back in SPI byte order whatever
+// setSwapBytes() says, as pushImage() takes them with swapping off.
+void TFT_eSPI::readRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data) {
+  OpScope op(_onBus, SIM_OP_READ_PIXEL);
+  x += _xDatum; y += _yDatum;
+  if (w <= 0 || h <= 0) return;
+  chargeRead(_onBus, (uint64_t)w * h);
+  for (int32_t row = 0; row < h; row++) {
+    for (int32_t col = 0; col < w; col++) {
+      int32_t px = x + col, py = y + row;
+      uint16_t c = (px < 0 || py < 0 || px >= _bufW || py >= _bufH) ? 0 : fetch(px, py);
+      *data++ = bswap16(c);
+    }
+  }
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data) {
+  OpScope op(_onBus, SIM_OP_PUSH_IMAGE);
+  rawImage(x + _xDatum, y + _yDatum, w, h, data, false, 0);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data) {
+  OpScope op(_onBus, SIM_OP_PUSH_IMAGE);
+  rawImage(x + _xDatum, y + _yDatum, w, h, data, false, 0);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* data, uint16_t transparent) {
+  pushImage(x, y, w, h, (const uint16_t*)data, transparent);
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* data, uint16_t transparent) {
+  OpScope op(_onBus, SIM_OP_PUSH_IMAGE);
+  uint16_t key = _swapBytes ? transparent : bswap16(transparent);
+  rawImage(x + _xDatum, y + _yDatum, w, h, data, true, key);
+}
+
+void TFT_eSPI::setTextColor(uint16_t color) {
+  textcolor = color;
+  textbgcolor = color;
+}
+
+void TFT_eSPI::setTextColor(uint16_t fg, uint16_t bg, bool) {
+  textcolor = fg;
+  textbgcolor = bg;
+}
+
+int16_t TFT_eSPI::drawString(const char* s, int32_t x, int32_t y, uint8_t font) {
+  OpScope op(_onBus, SIM_OP_DRAW_STRING);
+  return rawText(s, x + _xDatum, y + _yDatum, font);
+}
+
+int16_t TFT_eSPI::drawCentreString(const char* s, int32_t x, int32_t y, uint8_t font) {
+  OpScope op(_onBus, SIM_OP_DRAW_STRING);
+  uint8_t saved = textdatum;
+  textdatum = TC_DATUM;
+  int16_t w = rawText(s, x + _xDatum, y + _yDatum, font);
+  textdatum = saved;
+  return w;
+}
+
+int16_t TFT_eSPI::drawRightString(const char* s, int32_t x, int32_t y, uint8_t font) {
+  OpScope op(_onBus, SIM_OP_DRAW_STRING);
+  uint8_t saved = textdatum;
+  textdatum = TR_DATUM;
+  int16_t w = rawText(s, x + _xDatum, y + _yDatum, font);
+  textdatum = saved;
+  return w;
+}
+
+void TFT_eSPI::drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size) {
+  OpScope op(_onBus, SIM_OP_DRAW_CHAR);
+  uint8_t saved = textsize;
+  textsize = size ? size : 1;
+  rawGlyph(x + _xDatum, y + _yDatum, (char)c, 1, (uint16_t)color, (uint16_t)bg, color != bg);
+  textsize = saved;
+}
+
+int16_t TFT_eSPI::drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font) {
+  OpScope op(_onBus, SIM_OP_DRAW_CHAR);
+  rawGlyph(x + _xDatum, y + _yDatum, (char)uniCode, font, textcolor, textbgcolor, textbgcolor != textcolor);
+  int adv = glyphAdvance(font, (unsigned char)uniCode);
+  return (int16_t)((font == 2 || font == 4) ? adv : adv * textsize);
+}
+
+// ============================================================
+// Sprites
+// ============================================================
+void* TFT_eSprite::createSprite(int16_t w, int16_t h, uint8_t) {
+  if (_buf) return _buf;
+  if (w <= 0 || h <= 0) return nullptr;
+  _buf = (uint16_t*)calloc((size_t)w * h, sizeof(uint16_t));
+  if (!_buf) return nullptr;
+  _bufW = _width = w;
+  _bufH = _height = h;
+  resetViewport();
+  return _buf;
+}
+
+void TFT_eSprite::deleteSprite() {
+  free(_buf);
+  _buf = nullptr;
+  _bufW = _bufH = 0;
+  _width = _height = 0;
+  resetViewport();
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+  if (!_buf || !_parent) return;
+  bool swap = _parent->getSwapBytes();
+  _parent->setSwapBytes(false);
+  _parent->pushImage(x, y, _width, _height, _buf);
+  _parent->setSwapBytes(swap);
+}
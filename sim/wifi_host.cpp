@@ -0,0 +1,475 @@
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <WiFiUdp.h>
+#include <HTTPClient.h>
+#include <ArduinoJson.h>
+#include <bb_captouch.h>
+#include <deque>
+#include <vector>
+#include "sim.h"
+
+// ============================================================
+// Link model
+// ============================================================
+static const uint32_t ASSOC_MS = 1200;   // begin() -> WL_CONNECTED
+static const uint32_t SCAN_MS  = 1500;   // async scan duration
+static const uint32_t TCP_CONNECT_MS = 40;
+static const uint32_t TLS_HANDSHAKE_MS = 350;
+
+static wl_status_t g_status = WL_DISCONNECTED;
+static bool     g_linkUp = true;            // AP reachable when begin() is called
+static uint64_t g_assocDoneUs = 0;
+static bool     g_associating = false;
+static String   g_ssid;
+
+static bool     g_scanning = false;
+static bool     g_scanReady = false;
+static uint64_t g_scanDoneUs = 0;
+
+struct SimNet { const char* ssid; int32_t rssi; wifi_auth_mode_t auth; };
+static const SimNet SIM_NETS[] = {
+  { "HomeNet",      -48, WIFI_AUTH_WPA2_PSK },
+  { "Office-5G",    -61, WIFI_AUTH_WPA_WPA2_PSK },
+  { "CoffeeShop",   -70, WIFI_AUTH_OPEN },
+  { "Neighbor_2.4", -83, WIFI_AUTH_WPA2_PSK },
+};
+static const int SIM_NET_COUNT = sizeof(SIM_NETS) / sizeof(SIM_NETS[0]);
+
+void sim_wifi_set_connected(bool on) {
+  g_linkUp = on;
+  g_associating = false;
+  g_status = on ? WL_CONNECTED : WL_DISCONNECTED;
+  if (on && g_ssid.length() == 0) g_ssid = SIM_NETS[0].ssid;
+}
+
+wl_status_t WiFiClass::status() {
+  if (g_associating && sim_clock_us() >= g_assocDoneUs) {
+    g_associating = false;
+    g_status = g_linkUp ? WL_CONNECTED : WL_NO_SSID_AVAIL;
+  }
+  return g_status;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char*) {
+  g_ssid = ssid ? ssid : "";
+  g_associating = true;
+  g_assocDoneUs = sim_clock_us() + (uint64_t)ASSOC_MS * 1000ULL;
+  g_status = WL_DISCONNECTED;
+  return g_status;
+}
+
+bool WiFiClass::disconnect(bool) {
+  g_associating = false;
+  g_status = WL_DISCONNECTED;
+  return true;
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool) {
+  g_scanning = true;
+  g_scanReady = false;
+  g_scanDoneUs = sim_clock_us() + (uint64_t)SCAN_MS * 1000ULL;
+  if (async) return WIFI_SCAN_RUNNING;
+  sim_clock_advance_us((uint64_t)SCAN_MS * 1000ULL);
+  return scanComplete();
+}
+
+int16_t WiFiClass::scanComplete() {
+  if (g_scanning && sim_clock_us() >= g_scanDoneUs) {
+    g_scanning = false;
+    g_scanReady = true;
+  }
+  if (g_scanning) return WIFI_SCAN_RUNNING;
+  if (!g_scanReady) return WIFI_SCAN_FAILED;
+  return SIM_NET_COUNT;
+}
+
+void WiFiClass::scanDelete() {
+  g_scanReady = false;
+}
+
+String WiFiClass::SSID() { return status() == WL_CONNECTED ? g_ssid : String(); }
+String WiFiClass::SSID(uint8_t i) { return i < SIM_NET_COUNT ? String(SIM_NETS[i].ssid) : String(); }
+int32_t WiFiClass::RSSI(uint8_t i) { return i < SIM_NET_COUNT ? SIM_NETS[i].rssi : 0; }
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t i) { return i < SIM_NET_COUNT ? SIM_NETS[i].auth : WIFI_AUTH_OPEN; }
+IPAddress WiFiClass::localIP() { return status() == WL_CONNECTED ? IPAddress(192, 168, 1, 50) : IPAddress(); }
+
+WiFiClass WiFi;
+
+// ============================================================
+// TCP / TLS clients
+// ============================================================
+int WiFiClient::connect(const char*, uint16_t) {
+  if (WiFi.status() != WL_CONNECTED) return 0;
+  sim_block_us((uint64_t)TCP_CONNECT_MS * 1000ULL);
+  _open = true;
+  _rx.clear();
+  _rxPos = 0;
+  return 1;
+}
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+  if (!WiFiClient::connect(host, port)) return 0;
+  sim_block_us((uint64_t)TLS_HANDSHAKE_MS * 1000ULL);
+  return 1;
+}
+
+void WiFiClient::stop() {
+  _open = false;
+  _rx.clear();
+  _rxPos = 0;
+  _rxLater.clear();
+}
+
+void WiFiClient::simRelease() {
+  while (!_rxLater.empty() && _rxLater.front().first <= sim_clock_us()) {
+    _rx += _rxLater.front().second;
+    _rxLater.pop_front();
+  }
+}
+
+uint8_t WiFiClient::connected() {
+  if (WiFi.status() != WL_CONNECTED) return available() > 0;
+  return _open || !_rxLater.empty() || available() > 0;
+}
+
+int WiFiClient::available() {
+  simRelease();
+  return (int)(_rx.size() - _rxPos);
+}
+
+int WiFiClient::read() {
+  simRelease();
+  if (_rxPos >= _rx.size()) return -1;
+  return (unsigned char)_rx[_rxPos++];
+}
+
+int WiFiClient::peek() {
+  simRelease();
+  if (_rxPos >= _rx.size()) return -1;
+  return (unsigned char)_rx[_rxPos];
+}
+
+int WiFiClient::read(uint8_t* buf, size_t len) {
+  simRelease();
+  size_t n = std::min(len, _rx.size() - _rxPos);
+  if (n == 0) return -1;
+  memcpy(buf, _rx.data() + _rxPos, n);
+  _rxPos += n;
+  return (int)n;
+}
+
+void WiFiClient::simFeed(const std::string& data, bool keepOpen) {
+  _rx.erase(0, _rxPos);
+  _rxPos = 0;
+  _rx += data;
+  _open = keepOpen;
+}
+
+void WiFiClient::simFeedAt(uint64_t atUs, const std::string& data) {
+  _rxLater.emplace_back(atUs, data);
+}
+
+// ============================================================
+// HTTP
+// ============================================================
+static uint32_t g_httpLatencyMs = 900;
+static uint32_t g_httpFirstTokenMs = 250;
+static std::string g_httpReply = "Hello from the simulator.";
+
+void sim_http_set_latency_ms(uint32_t ms) { g_httpLatencyMs = ms; }
+void sim_http_set_first_token_ms(uint32_t ms) { g_httpFirstTokenMs = ms; }
+void sim_http_set_response(const char* text) { g_httpReply = text ? text : ""; }
+
+static std::string jsonEscape(const std::string& s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') { out += '\\'; out += c; }
+    else if (c == '\n') out += "\\n";
+    else out += c;
+  }
+  return out;
+}
+
+bool HTTPClient::begin(WiFiClient& client, const String& url) {
+  _client = &client;
+  _url = url;
+  _size = -1;
+  _chunked = false;
+  return url.startsWith("http");
+}
+
+void HTTPClient::end() {
+  if (_client && !_reuse) _client->stop();
+}
+
+int HTTPClient::POST(const String& payload) {
+  return POST((const uint8_t*)payload.c_str(), payload.length());
+}
+
+int HTTPClient::POST(const uint8_t* payload, size_t len) {
+  if (!_client) return HTTPC_ERROR_CONNECTION_REFUSED;
+  if (!_client->connected() && !_client->connect("sim.workers.dev", 443)) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  _client->write(payload, len);
+
+  std::string req((const char*)payload, len);
+  _chunked = req.find("\"stream\":true") != std::string::npos;
+  if (_chunked) {
+    // Headers arrive with the first token; the remaining words are spread
+    // evenly over the rest of the generation time.
+    uint32_t ttft = std::min(g_httpFirstTokenMs, g_httpLatencyMs);
+    sim_block_us((uint64_t)ttft * 1000ULL);
+
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < g_httpReply.size()) {
+      size_t j = g_httpReply.find(' ', i + 1);
+      if (j == std::string::npos) j = g_httpReply.size();
+      words.push_back(g_httpReply.substr(i, j - i));
+      i = j;
+    }
+
+    uint64_t t0 = sim_clock_us();
+    uint64_t span = (uint64_t)(g_httpLatencyMs - ttft) * 1000ULL;
+    auto chunk = [](const std::string& data) {
+      char hex[16];
+      snprintf(hex, sizeof(hex), "%zx\r\n", data.size());
+      return std::string(hex) + data + "\r\n";
+    };
+    for (size_t k = 0; k < words.size(); k++) {
+      uint64_t at = t0 + (words.size() > 1 ? span * k / (words.size() - 1) : 0);
+      _client->simFeedAt(at, chunk("data: {\"response\":\"" + jsonEscape(words[k]) + "\"}\n\n"));
+    }
+    _client->simFeedAt(t0 + span, chunk("data: [DONE]\n\n") + "0\r\n\r\n");
+    _size = -1;
+    return 200;
+  }
+
+  sim_block_us((uint64_t)g_httpLatencyMs * 1000ULL);
+
+  std::string body = "{\"response\":\"" + jsonEscape(g_httpReply) + "\",\"stream\":false}";
+  _size = (int)body.size();
+  _client->simFeed(body, _reuse);
+  return 200;
+}
+
+int HTTPClient::GET() {
+  return POST((const uint8_t*)"", 0);
+}
+
+String HTTPClient::header(const char* name) {
+  if (strcasecmp(name, "Transfer-Encoding") == 0 && _chunked) return String("chunked");
+  return String();
+}
+
+String HTTPClient::getString() {
+  if (!_client) return String();
+  std::string out;
+  int c;
+  while ((c = _client->read()) >= 0) out += (char)c;
+  return String(out);
+}
+
+// ============================================================
+// UDP
+// ============================================================
+static std::deque<std::vector<uint8_t>> g_udpIn;
+
+void sim_udp_push(const uint8_t* data, size_t len) {
+  g_udpIn.emplace_back(data, data + len);
+}
+
+int WiFiUDP::parsePacket() {
+  if (!_bound || g_udpIn.empty()) return 0;
+  _cur = std::move(g_udpIn.front());
+  g_udpIn.pop_front();
+  _pos = 0;
+  return (int)_cur.size();
+}
+
+int WiFiUDP::read() {
+  if (_pos >= _cur.size()) return -1;
+  return _cur[_pos++];
+}
+
+int WiFiUDP::read(unsigned char* buf, size_t len) {
+  size_t n = std::min(len, _cur.size() - _pos);
+  memcpy(buf, _cur.data() + _pos, n);
+  _pos += n;
+  return (int)n;
+}
+
+static SimUdpStat g_udpStats;
+static FILE* g_udpCapture = nullptr;
+
+void sim_udp_capture(const char* path) {
+  if (g_udpCapture) fclose(g_udpCapture);
+  g_udpCapture = path ? fopen(path, "wb") : nullptr;
+}
+
+const SimUdpStat* sim_udp_stats() { return &g_udpStats; }
+void sim_udp_stats_reset() { g_udpStats = {}; }
+
+int WiFiUDP::endPacket() {
+  g_udpStats.sent++;
+  g_udpStats.bytes += _tx.size();
+  if (g_udpCapture) {
+    uint8_t len[2] = {(uint8_t)_tx.size(), (uint8_t)(_tx.size() >> 8)};
+    fwrite(len, 1, 2, g_udpCapture);
+    fwrite(_tx.data(), 1, _tx.size(), g_udpCapture);
+    fflush(g_udpCapture);
+  }
+  _tx.clear();
+  return 1;
+}
+
+// ============================================================
+// Touch controller
+// ============================================================
+static bool g_touchDown = false;
+static int  g_touchX = 0, g_touchY = 0;
+
+static SimTouchStat g_touchStats;
+
+const SimTouchStat* sim_touch_stats() { return &g_touchStats; }
+void sim_touch_stats_reset() { g_touchStats = SimTouchStat(); }
+
+void sim_touch_set(bool pressed, int x, int y) {
+  if (pressed == g_touchDown && x == g_touchX && y == g_touchY) return;
+  g_touchDown = pressed;
+  g_touchX = x;
+  g_touchY = y;
+  g_touchStats.irqs++;
+  sim_gpio_interrupt(SIM_TOUCH_INT_PIN);
+}
+
+TwoWire Wire;
+
+int BBCapTouch::init(int, int, int, int, uint32_t, TwoWire*) { return CT_SUCCESS; }
+
+int BBCapTouch::getSamples(TOUCHINFO* ti) {
+  if (!ti) return 0;
+  // One I2C register burst on the real part; it costs bus time too.
+  g_touchStats.reads++;
+  sim_block_us(120);
+  if (!g_touchDown) { ti->count = 0; return 0; }
+  ti->count = 1;
+  // Inverse of the mapping in touch_get(): panel x runs down the screen.
+  ti->x[0] = (uint16_t)(SIM_SCREEN_H - 1 - g_touchY);
+  ti->y[0] = (uint16_t)g_touchX;
+  ti->pressure[0] = 40;
+  ti->area[0] = 10;
+  return 1;
+}
+
+// ============================================================
+// JSON
+// ============================================================
+size_t serializeJson(const JsonDocument& doc, String& out) {
+  std::string s = "{";
+  bool first = true;
+  for (const auto& kv : doc._members) {
+    if (!first) s += ',';
+    first = false;
+    s += '"' + jsonEscape(kv.first) + "\":";
+    const JsonVariant& v = kv.second;
+    if (v._k == JsonVariant::STR) s += '"' + jsonEscape(v._s) + '"';
+    else if (v._k == JsonVariant::BOOL) s += v._n ? "true" : "false";
+    else if (v._k == JsonVariant::NUM) { char b[32]; snprintf(b, sizeof(b), "%g", v._n); s += b; }
+    else if (v._k == JsonVariant::RAW) s += v._s;
+    else s += "null";
+  }
+  s += '}';
+  out = String(s);
+  return s.size();
+}
+
+static void skipWs(const char*& p) { while (*p && isspace((unsigned char)*p)) p++; }
+
+static bool parseString(const char*& p, std::string& out) {
+  if (*p != '"') return false;
+  p++;
+  while (*p && *p != '"') {
+    if (*p == '\\' && p[1]) {
+      p++;
+      switch (*p) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'u': {
+          unsigned cp = (unsigned)strtoul(std::string(p + 1, 4).c_str(), nullptr, 16);
+          p += 4;
+          if (cp < 0x80) out += (char)cp;
+          else if (cp < 0x800) { out += (char)(0xC0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3F)); }
+          else { out += (char)(0xE0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+          break;
+        }
+        default: out += *p; break;
+      }
+      p++;
+    } else {
+      out += *p++;
+    }
+  }
+  if (*p != '"') return false;
+  p++;
+  return true;
+}
+
+static bool skipComposite(const char*& p) {
+  int depth = 0;
+  do {
+    if (*p == '"') { std::string tmp; if (!parseString(p, tmp)) return false; continue; }
+    if (*p == '{' || *p == '[') depth++;
+    else if (*p == '}' || *p == ']') depth--;
+    else if (!*p) return false;
+    p++;
+  } while (depth > 0);
+  return true;
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const char* in) {
+  doc.clear();
+  if (!in) return DeserializationError::InvalidInput;
+  const char* p = in;
+  skipWs(p);
+  if (*p != '{') return DeserializationError::InvalidInput;
+  p++;
+  for (;;) {
+    skipWs(p);
+    if (*p == '}') return DeserializationError::Ok;
+    std::string key;
+    if (!parseString(p, key)) return DeserializationError::InvalidInput;
+    skipWs(p);
+    if (*p++ != ':') return DeserializationError::InvalidInput;
+    skipWs(p);
+    JsonVariant& v = doc._members[key];
+    if (*p == '"') {
+      v._k = JsonVariant::STR;
+      if (!parseString(p, v._s)) return DeserializationError::InvalidInput;
+    } else if (*p == '{' || *p == '[') {
+      const char* start = p;
+      if (!skipComposite(p)) return DeserializationError::InvalidInput;
+      v._k = JsonVariant::RAW;
+      v._s.assign(start, p - start);
+    } else if (!strncmp(p, "true", 4)) { v = true; p += 4; }
+    else if (!strncmp(p, "false", 5)) { v = false; p += 5; }
+    else if (!strncmp(p, "null", 4)) { p += 4; }
+    else {
+      char* end = nullptr;
+      double d = strtod(p, &end);
+      if (end == p) return DeserializationError::InvalidInput;
+      v = d;
+      p = end;
+    }
+    skipWs(p);
+    if (*p == ',') { p++; continue; }
+    if (*p == '}') return DeserializationError::Ok;
+    return DeserializationError::InvalidInput;
+  }
+}
+
+DeserializationError deserializeJson(JsonDocument& doc, const String& in) {
+  return deserializeJson(doc, in.c_str());
+}
@@ -3,7 +3,7 @@
 #include <Arduino.h>
 #include <time.h>
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 
 static wl_status_t lastWifi = WL_DISCONNECTED;
 static uint32_t lastClockSec = 0;
@@ -17,33 +17,36 @@ static uint32_t manualSetMs = 0;
 static const int STATUS_W = 90;
 static const int STATUS_H = 16;
 
-static void drawBattery(int x, int y, uint16_t fg, uint16_t bg) {
+template <typename G>
+static void drawBattery(G* g, int x, int y, uint16_t fg, uint16_t bg) {
   int w = 22, h = 10;
-  tft->fillRect(x, y, w + 2, h, bg);
-  tft->drawRect(x, y, w, h, fg);
-  tft->fillRect(x + w, y + 3, 2, h - 6, fg);
+  g->fillRect(x, y, w + 2, h, bg);
+  g->drawRect(x, y, w, h, fg);
+  g->fillRect(x + w, y + 3, 2, h - 6, fg);
 
   int level = 3; // fake full
   int fillW = (w - 4) * level / 3;
-  tft->fillRect(x + 2, y + 2, fillW, h - 4, fg);
+  g->fillRect(x + 2, y + 2, fillW, h - 4, fg);
   if (fillW < w - 4) {
-    tft->fillRect(x + 2 + fillW, y + 2, (w - 4) - fillW, h - 4, bg);
+    g->fillRect(x + 2 + fillW, y + 2, (w - 4) - fillW, h - 4, bg);
   }
 }
 
-static void drawWifi(int x, int y, bool connected, uint16_t fg, uint16_t bg) {
-  tft->fillRect(x - 1, y - 1, 16, 16, bg);
+template <typename G>
+static void drawWifi(G* g, int x, int y, bool connected, uint16_t fg, uint16_t bg) {
+  g->fillRect(x - 1, y - 1, 16, 16, bg);
   uint16_t c = fg;
-  tft->drawPixel(x + 7, y + 7, c);
-  tft->drawCircle(x + 7, y + 7, 3, c);
-  tft->drawCircle(x + 7, y + 7, 5, c);
-  tft->drawCircle(x + 7, y + 7, 7, c);
+  g->drawPixel(x + 7, y + 7, c);
+  g->drawCircle(x + 7, y + 7, 3, c);
+  g->drawCircle(x + 7, y + 7, 5, c);
+  g->drawCircle(x + 7, y + 7, 7, c);
   if (!connected) {
-    tft->drawLine(x, y + 12, x + 14, y - 2, 0xF800);
+    g->drawLine(x, y + 12, x + 14, y - 2, 0xF800);
   }
 }
 
-static void drawClock(int x, int y, uint16_t fg, uint16_t bg) {
+template <typename G>
+static void drawClock(G* g, int x, int y, uint16_t fg, uint16_t bg) {
   char buf[6] = "--:--";
   if (manualTime) {
     uint32_t elapsedMin = (millis() - manualSetMs) / 60000;
@@ -60,15 +63,15 @@ static void drawClock(int x, int y, uint16_t fg, uint16_t bg) {
     }
   }
   // Overdraw previous time using the caller background, then draw new time
-  tft->setTextColor(bg, bg);
-  tft->drawString(lastClock, x, y, 2);
-  tft->setTextColor(fg, bg);
-  tft->drawString(buf, x, y, 2);
+  g->setTextColor(bg, bg);
+  g->drawString(lastClock, x, y, 2);
+  g->setTextColor(fg, bg);
+  g->drawString(buf, x, y, 2);
   strncpy(lastClock, buf, sizeof(lastClock) - 1);
   lastClock[sizeof(lastClock) - 1] = 0;
 }
 
-void system_ui_init(TFT_eSPI* display) {
+void system_ui_init(Display* display) {
   tft = display;
 }
 
@@ -113,25 +116,38 @@ void system_ui_time_get(int* hour, int* minute) {
   }
 }
 
-void system_ui_draw_status(int x, int y, uint16_t bg) {
-  if (!tft) return;
+// Templated so the status block keeps the Display draw accounting when it
+// goes straight to the screen, and can also be painted into a sprite.
+template <typename G>
+static void drawStatus(G* g, int x, int y, uint16_t bg) {
   // Clear a small status strip to avoid stale pixels.
-  tft->fillRect(x, y, STATUS_W, STATUS_H, bg);
+  g->fillRect(x, y, STATUS_W, STATUS_H, bg);
   bool connected = (WiFi.status() == WL_CONNECTED);
-  drawWifi(x + 2, y + 2, connected, TFT_WHITE, bg);
-  drawBattery(x + 22, y + 3, TFT_WHITE, bg);
-  drawClock(x + 48, y + 1, TFT_WHITE, bg);
+  drawWifi(g, x + 2, y + 2, connected, TFT_WHITE, bg);
+  drawBattery(g, x + 22, y + 3, TFT_WHITE, bg);
+  drawClock(g, x + 48, y + 1, TFT_WHITE, bg);
 
   lastWifi = WiFi.status();
   lastClockSec = millis() / 1000;
 }
 
-void system_ui_tick(int x, int y, uint16_t bg) {
+void system_ui_draw_status(int x, int y, uint16_t bg) {
   if (!tft) return;
-  uint32_t nowSec = millis() / 1000;
-  wl_status_t cur = WiFi.status();
+  drawStatus(tft, x, y, bg);
+}
 
-  if (cur != lastWifi || nowSec != lastClockSec) {
+void system_ui_draw_status_to(TFT_eSPI* target, int x, int y, uint16_t bg) {
+  if (!target) return;
+  drawStatus(target, x, y, bg);
+}
+
+bool system_ui_status_stale() {
+  return WiFi.status() != lastWifi || millis() / 1000 != lastClockSec;
+}
+
+void system_ui_tick(int x, int y, uint16_t bg) {
+  if (!tft) return;
+  if (system_ui_status_stale()) {
     system_ui_draw_status(x, y, bg);
   }
 }
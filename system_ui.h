@@ -1,8 +1,8 @@
 #pragma once
-#include <TFT_eSPI.h>
+#include "display.h"
 
 // Init once with display pointer
-void system_ui_init(TFT_eSPI* display);
+void system_ui_init(Display* display);
 void system_ui_time_begin();
 void system_ui_time_manual_sync();
 void system_ui_time_set_manual(int hour, int minute);
@@ -12,5 +12,11 @@ void system_ui_time_get(int* hour, int* minute);
 // x,y define the top-left of the status block.
 void system_ui_draw_status(int x, int y, uint16_t bg);
 
+// Same block drawn onto another target (e.g. a compositing sprite).
+void system_ui_draw_status_to(TFT_eSPI* target, int x, int y, uint16_t bg);
+
+// True when Wi-Fi state or the clock second changed since the last draw.
+bool system_ui_status_stale();
+
 // Redraw only when state changes or every second for clock.
 void system_ui_tick(int x, int y, uint16_t bg);
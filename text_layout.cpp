@@ -0,0 +1,206 @@
+#include "text_layout.h"
+#include "text_metrics.h"
+#include <string.h>
+
+// Byte `i` of a text with a gap of gapLen bytes at gapAt.
+static inline unsigned char byteAt(const char* s, int gapAt, int gapLen, int i) {
+  return (unsigned char)s[i < gapAt ? i : i + gapLen];
+}
+
+static inline unsigned char charAt(const TextLayout* L, int i) {
+  return byteAt(L->text, L->gapAt, L->gapLen, i);
+}
+
+static int nextBreak(const char* s, int len, int gapAt, int gapLen, int start,
+                     int maxW, uint8_t font) {
+  int w = 0;
+  int brk = -1;   // start of the word after the last space
+  for (int i = start; i < len; i++) {
+    unsigned char c = byteAt(s, gapAt, gapLen, i);
+    if (c == '\n') return i + 1;
+    int a = text_advance(font, c);
+    if (c == ' ') {
+      // Spaces hang past the edge; the next word decides the break.
+      w += a;
+      brk = i + 1;
+      continue;
+    }
+    if (w + a > maxW && i > start) return (brk > start) ? brk : i;
+    w += a;
+  }
+  return -1;
+}
+
+int text_layout_next(const char* s, int len, int start, int maxW, uint8_t font) {
+  return nextBreak(s, len, 0, 0, start, maxW, font);
+}
+
+static int layoutNext(const TextLayout* L, int start) {
+  return nextBreak(L->text, L->len, L->gapAt, L->gapLen, start, L->maxW, L->font);
+}
+
+int text_layout_trim(const char* s, int start, int end) {
+  while (end > start && (s[end - 1] == ' ' || s[end - 1] == '\n')) end--;
+  return end - start;
+}
+
+void text_layout_init(TextLayout* L, uint16_t* starts, int cap, int maxW, uint8_t font) {
+  L->text = "";
+  L->len = 0;
+  L->gapAt = 0;
+  L->gapLen = 0;
+  L->maxW = maxW;
+  L->font = font;
+  L->starts = starts;
+  L->cap = cap;
+  L->count = 1;
+  starts[0] = 0;
+}
+
+void text_layout_set(TextLayout* L, const char* text, int len) {
+  L->text = text;
+  L->len = len;
+  int n = 0;
+  int s = 0;
+  while (s >= 0 && n < L->cap) {
+    L->starts[n++] = (uint16_t)s;
+    s = layoutNext(L, s);
+  }
+  L->count = n;
+}
+
+void text_layout_set_gap(TextLayout* L, int gapAt, int gapLen) {
+  L->gapAt = gapAt;
+  L->gapLen = gapLen;
+}
+
+// Whether text[from..to) holds a space or newline, i.e. whether the word
+// starting at `from` ends before `to`.
+static bool wordEndsBefore(const TextLayout* L, int from, int to) {
+  for (int i = from; i < to; i++) {
+    unsigned char c = charAt(L, i);
+    if (c == ' ' || c == '\n') return true;
+  }
+  return false;
+}
+
+int text_layout_update(TextLayout* L, const char* text, int len, int from, int delta,
+                       int* changedEnd) {
+  L->text = text;
+  L->len = len;
+  uint16_t* starts = L->starts;
+
+  // Line k-1 only depends on line k through the word line k starts with,
+  // so walk back while that word reaches into the edit. A '\n' before a
+  // line start ends the walk: that is the start of the edited paragraph.
+  int first = text_layout_line_at(L, from);
+  while (first > 0) {
+    int s = starts[first];
+    if (charAt(L, s - 1) == '\n' || wordEndsBefore(L, s, from)) break;
+    first--;
+  }
+
+  // Park the old line starts after `first` at the end of the array; new
+  // starts are written from the front and compared with the old ones
+  // (shifted by delta) until the two layouts meet again.
+  bool full = L->count == L->cap;
+  int oldN = L->count - (first + 1);
+  int rd = L->cap - oldN;
+  memmove(starts + rd, starts + first + 1, oldN * sizeof(uint16_t));
+
+  int changeEnd = from + (delta > 0 ? delta : 0);
+  int n = first + 1;
+  int same = -1;   // first line that matched the old layout
+  int s = starts[first];
+  while (true) {
+    s = layoutNext(L, s);
+    if (s < 0) break;
+
+    if (s > changeEnd) {
+      while (rd < L->cap && starts[rd] + delta < s) rd++;
+      if (rd < L->cap && starts[rd] + delta == s) {
+        if (same < 0) same = n;
+        int rest = L->cap - rd;
+        for (int j = 0; j < rest; j++) starts[n + j] = (uint16_t)(starts[rd + j] + delta);
+        n += rest;
+        // A full table may have dropped lines that now fit.
+        if (!full) break;
+        s = starts[n - 1];
+        full = false;
+        rd = L->cap;
+        if (n >= L->cap) break;
+        continue;
+      }
+    }
+
+    if (n >= L->cap) break;
+    if (n >= rd) rd = L->cap;   // about to overwrite old starts: stop merging
+    starts[n++] = (uint16_t)s;
+  }
+  L->count = n;
+  if (changedEnd) *changedEnd = same < 0 ? n : same;
+  return first;
+}
+
+// End of line `line`, without its trailing spaces or '\n'.
+static int lineEnd(const TextLayout* L, int line) {
+  int start = L->starts[line];
+  int end = (line + 1 < L->count) ? L->starts[line + 1] : L->len;
+  while (end > start && (charAt(L, end - 1) == ' ' || charAt(L, end - 1) == '\n')) end--;
+  return end;
+}
+
+int text_layout_copy_line(const TextLayout* L, int line, char* buf, int size) {
+  int start = L->starts[line];
+  int n = lineEnd(L, line) - start;
+  if (n > size - 1) n = size - 1;
+  // Copy the parts before and after the gap separately.
+  int before = L->gapAt - start;
+  if (before < 0) before = 0;
+  if (before > n) before = n;
+  memcpy(buf, L->text + start, before);
+  memcpy(buf + before, L->text + start + before + L->gapLen, n - before);
+  buf[n] = 0;
+  return n;
+}
+
+int text_layout_line_at(const TextLayout* L, int offset) {
+  int lo = 0;
+  int hi = L->count - 1;
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (L->starts[mid] <= offset) lo = mid;
+    else hi = mid - 1;
+  }
+  return lo;
+}
+
+int text_layout_x_of(const TextLayout* L, int offset) {
+  int x = 0;
+  for (int i = L->starts[text_layout_line_at(L, offset)]; i < offset; i++) {
+    x += text_advance(L->font, charAt(L, i));
+  }
+  return x;
+}
+
+int text_layout_offset_at(const TextLayout* L, int line, int x) {
+  int end = lineEnd(L, line);
+  int w = 0;
+  for (int i = L->starts[line]; i < end; i++) {
+    int a = text_advance(L->font, charAt(L, i));
+    if (x < w + a / 2) return i;
+    w += a;
+  }
+  return end;
+}
+
+TextWindow text_layout_window(const TextLayout* L, int scroll, int rows) {
+  int maxScroll = L->count - rows;
+  if (maxScroll < 0) maxScroll = 0;
+  if (scroll > maxScroll) scroll = maxScroll;
+  if (scroll < 0) scroll = 0;
+  TextWindow w;
+  w.first = scroll;
+  w.last = scroll + rows < L->count ? scroll + rows : L->count;
+  return w;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+
+// Word-wrapped layout shared by chat, notes and the internet page.
+//
+// A layout stores only the offset each line starts at, in an array the
+// caller owns, never copies of the lines. Lines break after spaces, or
+// mid-word when a word is wider than the line; '\n' always ends a line
+// (so blank lines are kept). Glyph widths come from text_metrics.h.
+//
+// The text may be a gap buffer: bytes [gapAt, gapAt + gapLen) of the
+// array are skipped, and every offset here counts only the bytes around
+// the gap, so an editor can hand over its buffer without closing the gap.
+//
+// After an edit only the lines from the edited paragraph on are wrapped
+// again, and wrapping stops as soon as a new line start lines up with
+// the old layout; the rest is shifted instead of re-measured.
+
+struct TextLayout {
+  const char* text;
+  int len;            // bytes of text, not counting the gap
+  int gapAt;
+  int gapLen;
+  int maxW;
+  uint8_t font;
+  uint16_t* starts;   // caller-owned, cap entries
+  int cap;
+  int count;          // always >= 1; lines past cap are dropped
+};
+
+struct TextWindow {
+  int first;          // first visible line (the clamped scroll position)
+  int last;           // one past the last visible line
+};
+
+void text_layout_init(TextLayout* L, uint16_t* starts, int cap, int maxW, uint8_t font);
+
+// Lays out the whole text.
+void text_layout_set(TextLayout* L, const char* text, int len);
+
+// Where the gap is for the following set/update calls (none after init).
+void text_layout_set_gap(TextLayout* L, int gapAt, int gapLen);
+
+// The text now reads `text` (len bytes) and differs from the previous
+// one from byte `from` on, with `delta` bytes inserted (> 0) or removed
+// (< 0) there. Returns the first line whose content may have changed;
+// lines from *changedEnd on read exactly as before (they may have moved
+// if the line count changed).
+int text_layout_update(TextLayout* L, const char* text, int len, int from, int delta,
+                       int* changedEnd = nullptr);
+
+// Copies line `line` into buf as a C string without its trailing spaces
+// or '\n', cut to size - 1 bytes. Returns the copied length.
+int text_layout_copy_line(const TextLayout* L, int line, char* buf, int size);
+
+// Line that contains byte `offset`.
+int text_layout_line_at(const TextLayout* L, int offset);
+
+// Pixels from the start of its line to byte `offset` (a caret position).
+int text_layout_x_of(const TextLayout* L, int offset);
+
+// Caret position in line `line` closest to `x` pixels from its start.
+int text_layout_offset_at(const TextLayout* L, int line, int x);
+
+// Lines to show in `rows` rows when scrolled to `scroll` (clamped).
+TextWindow text_layout_window(const TextLayout* L, int scroll, int rows);
+
+// Building blocks for callers that keep line starts elsewhere (chat keeps
+// them in one ring for all messages).
+
+// Start of the line after the one starting at `start`, or -1 if the text
+// ends on this line.
+int text_layout_next(const char* s, int len, int start, int maxW, uint8_t font);
+
+// Length of s[start..end) without trailing spaces or '\n'.
+int text_layout_trim(const char* s, int start, int end);
@@ -0,0 +1,46 @@
+#include "text_metrics.h"
+
+int text_width(const char* s, int len, uint8_t font) {
+  int w = 0;
+  for (int i = 0; i < len && s[i]; i++) w += text_advance(font, (unsigned char)s[i]);
+  return w;
+}
+
+int text_prefix_widths(const char* s, int len, uint8_t font, uint16_t* out) {
+  int w = 0;
+  out[0] = 0;
+  for (int i = 0; i < len; i++) {
+    w += text_advance(font, (unsigned char)s[i]);
+    out[i + 1] = (uint16_t)w;
+  }
+  return w;
+}
+
+int text_fit_tail(const char* s, int len, uint8_t font, int maxW) {
+  int w = 0;
+  int start = len;
+  while (start > 0) {
+    int a = text_advance(font, (unsigned char)s[start - 1]);
+    if (w + a > maxW) break;
+    w += a;
+    start--;
+  }
+  return start;
+}
+
+int text_metrics_check(Display* tft) {
+  static const uint8_t FONTS[] = {1, 2, 4};
+  int bad = 0;
+  for (uint8_t font : FONTS) {
+    for (int ch = 32; ch <= 127; ch++) {
+      char s[2] = {(char)ch, 0};
+      int real = tft->textWidth(s, font);
+      int table = text_advance(font, (unsigned char)ch);
+      if (real == table) continue;
+      Serial.printf("text_metrics: font %u char %d is %d px, table says %d\n",
+                    (unsigned)font, ch, real, table);
+      bad++;
+    }
+  }
+  return bad;
+}
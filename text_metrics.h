@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include "display.h"
+
+// Text measurement without going through the display.
+//
+// TFT_eSPI::textWidth() walks the string and looks every glyph up in the
+// font; callers that measure growing strings (word wrapping, clipping the
+// input line) end up quadratic. These helpers use the same advance widths
+// from a constexpr table so a whole string can be measured once and any
+// span of it read back from the prefix widths.
+
+// Advance widths for chars 32..127 of TFT_eSPI font 2 (Font16) and
+// font 4 (Font32rle). Font 1 is the 6x8 GLCD font. They are copied from
+// the library's widtbl_f16 and Font32rle width data, and the simulator's
+// textWidth() reads them too, so only the board can tell if one is off:
+// text_metrics_check() compares them with the real fonts at boot.
+constexpr uint8_t FONT2_ADVANCE[96] = {
+  4, 2, 3, 8, 7, 9, 8, 2,   4, 4, 5, 7, 3, 4, 2, 4,
+  7, 7, 7, 7, 7, 7, 7, 7,   7, 7, 2, 3, 6, 7, 6, 7,
+  12, 8, 7, 7, 8, 7, 6, 8,  8, 3, 6, 7, 6, 10, 8, 8,
+  7, 8, 7, 7, 6, 8, 8, 10,  8, 8, 6, 3, 4, 3, 5, 8,
+  3, 6, 6, 6, 6, 6, 4, 6,   6, 2, 3, 6, 2, 8, 6, 6,
+  6, 6, 4, 5, 4, 6, 6, 8,   6, 6, 6, 4, 2, 4, 7, 4
+};
+
+constexpr uint8_t FONT4_ADVANCE[96] = {
+  5, 5, 7, 14, 12, 19, 15, 4,    7, 7, 9, 12, 5, 7, 5, 7,
+  12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 5, 5, 12, 12, 12, 11,
+  20, 14, 14, 15, 15, 13, 12, 16, 15, 5, 10, 14, 11, 17, 15, 16,
+  13, 16, 14, 13, 12, 15, 14, 20, 13, 13, 13, 6, 7, 6, 10, 12,
+  5, 11, 11, 10, 11, 11, 6, 11,  11, 4, 4, 10, 4, 16, 11, 11,
+  11, 11, 7, 10, 6, 11, 10, 14,  10, 10, 10, 7, 5, 7, 12, 5
+};
+
+// Pixels the cursor moves for one byte. Bytes outside 32..127 (UTF-8
+// sequences, control characters) have no glyph and take no space.
+constexpr int text_advance(uint8_t font, unsigned char ch) {
+  return (ch < 32 || ch > 127) ? 0
+       : font == 2 ? FONT2_ADVANCE[ch - 32]
+       : font == 4 ? FONT4_ADVANCE[ch - 32]
+       : 6;
+}
+
+// Width of the first len bytes of s (stops early at a NUL).
+int text_width(const char* s, int len, uint8_t font);
+
+// One pass over s: out[i] = width of s[0..i) for i = 0..len, so out needs
+// len + 1 entries and the width of s[a..b) is out[b] - out[a]. Returns the
+// width of the whole span.
+int text_prefix_widths(const char* s, int len, uint8_t font, uint16_t* out);
+
+// Start of the longest tail of s[0..len) that is at most maxW wide.
+int text_fit_tail(const char* s, int len, uint8_t font, int maxW);
+
+// Measures every glyph of fonts 1, 2 and 4 with tft->textWidth() and
+// prints any that differs from the tables on Serial. Returns the number
+// of mismatches. Call once at boot.
+int text_metrics_check(Display* tft);
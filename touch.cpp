@@ -9,24 +9,32 @@
 static BBCapTouch touch;
 static TOUCHINFO ti;
 
-void touch_init() {
+static TaskHandle_t notifyTask = nullptr;
+static volatile uint32_t irqMs = 0;
+
+static void IRAM_ATTR touchIsr() {
+  irqMs = millis();
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(notifyTask, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+void touch_init(TaskHandle_t notify) {
 
   touch.init(TOUCH_SDA, TOUCH_SCL, TOUCH_RST, TOUCH_INT, 400000, &Wire);
   touch.setOrientation(1, TOUCH_SCREEN_W, TOUCH_SCREEN_H);
-}
 
-bool touch_is_pressed() {
-  return (touch.getSamples(&ti) > 0) && (ti.count > 0);
+  notifyTask = notify;
+  pinMode(TOUCH_INT, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(TOUCH_INT), touchIsr, FALLING);
 }
 
-bool touch_get(int &x, int &y) {
+bool touch_read(int* x, int* y) {
   if (touch.getSamples(&ti) <= 0 || ti.count <= 0) return false;
 
-  x = ti.y[0];
-  y = (TOUCH_SCREEN_H - 1) - ti.x[0];
-
-  x = constrain(x, 0, TOUCH_SCREEN_W - 1);
-  y = constrain(y, 0, TOUCH_SCREEN_H - 1);
-
+  *x = constrain((int)ti.y[0], 0, TOUCH_SCREEN_W - 1);
+  *y = constrain((TOUCH_SCREEN_H - 1) - (int)ti.x[0], 0, TOUCH_SCREEN_H - 1);
   return true;
 }
+
+uint32_t touch_irq_ms() { return irqMs; }
@@ -5,8 +5,15 @@
 #define TOUCH_SCREEN_W 320
 #define TOUCH_SCREEN_H 240
 
-bool touch_is_pressed();
+// Panel driver. The controller pulls its INT line for every new report;
+// each edge notifies the task passed to touch_init(), which then calls
+// touch_read(). Nothing polls the panel over I2C otherwise.
 
-void touch_init();
+void touch_init(TaskHandle_t notify);
 
-bool touch_get(int &x, int &y);
\ No newline at end of file
+// One I2C read. Returns whether a finger is down and, if so, where in
+// screen coordinates.
+bool touch_read(int* x, int* y);
+
+// millis() at the last INT edge.
+uint32_t touch_irq_ms();
@@ -12,7 +12,7 @@
 #undef LIST_H
 #endif
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 static bool openState = false;
 
 static const int SCREEN_W = 320;
@@ -161,7 +161,7 @@ static void drawList() {
   }
 }
 
-void trash_app_init(TFT_eSPI* display) {
+void trash_app_init(Display* display) {
   tft = display;
 }
 
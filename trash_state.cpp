@@ -1,57 +1,24 @@
 #include "trash_state.h"
-#include <Preferences.h>
-
-static const char* NVS_NS = "trash";
-static const char* KEY_MASK = "mask";
-
-static bool inited = false;
-static uint8_t mask = 0;
-
-static void loadOnce() {
-  if (inited) return;
-  Preferences p;
-  p.begin(NVS_NS, true);
-  mask = (uint8_t)p.getUChar(KEY_MASK, 0);
-  p.end();
-  inited = true;
-}
-
-static void saveMask() {
-  Preferences p;
-  p.begin(NVS_NS, false);
-  p.putUChar(KEY_MASK, mask);
-  p.end();
-}
-
-void trash_state_init() {
-  loadOnce();
-}
+#include "config.h"
 
 bool trash_is_deleted(TrashIconId id) {
-  loadOnce();
-  return (mask & (1u << id)) != 0;
+  return (config_get_trash_mask() & (1u << id)) != 0;
 }
 
 void trash_delete_icon(TrashIconId id) {
-  loadOnce();
-  mask |= (1u << id);
-  saveMask();
+  config_set_trash_mask(config_get_trash_mask() | (1u << id));
 }
 
 void trash_restore_icon(TrashIconId id) {
-  loadOnce();
-  mask &= ~(1u << id);
-  saveMask();
+  config_set_trash_mask(config_get_trash_mask() & ~(1u << id));
 }
 
 void trash_restore_all() {
-  loadOnce();
-  mask = 0;
-  saveMask();
+  config_set_trash_mask(0);
 }
 
 uint8_t trash_deleted_count() {
-  loadOnce();
+  uint8_t mask = config_get_trash_mask();
   uint8_t c = 0;
   for (uint8_t i = 0; i < ICON_COUNT; i++) {
     if (mask & (1u << i)) c++;
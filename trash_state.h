@@ -10,7 +10,6 @@ enum TrashIconId : uint8_t {
   ICON_COUNT
 };
 
-void trash_state_init();
 bool trash_is_deleted(TrashIconId id);
 void trash_delete_icon(TrashIconId id);
 void trash_restore_icon(TrashIconId id);
@@ -1,15 +1,16 @@
 #include "wifi_app.h"
 #include "system_ui.h"
+#include "config.h"
+#include "input.h"
 #include <Arduino.h>
 #include <WiFi.h>
-#include <Preferences.h>
 #include <cstring>
 
 #ifdef LIST_H
 #undef LIST_H
 #endif
 
-static TFT_eSPI* tft = nullptr;
+static Display* tft = nullptr;
 
 static bool opened = false;
 
@@ -39,10 +40,6 @@ static int     countNet = 0;
 static int     selected = -1;
 static int     scroll = 0;
 
-static const char* WIFI_NS  = "wifi";
-static const char* KEY_SSID = "ssid";
-static const char* KEY_PASS = "pass";
-
 static const uint16_t XP_BG     = 0xC618;
 static const uint16_t XP_BORDER = 0x7BEF;
 static const uint16_t XP_WHITE  = 0xFFFF;
@@ -139,39 +136,26 @@ static int kbRowH() {
 }
 
 // ============================================================
-// NVS helpers
+// Saved network (config.h)
 // ============================================================
-static void nvsSaveWifi(const String& ssid, const String& pass) {
-  Preferences p;
-  p.begin(WIFI_NS, false);
-  p.putString(KEY_SSID, ssid);
-  p.putString(KEY_PASS, pass);
-  p.end();
+static bool saveWifi(const String& ssid, const String& pass) {
+  return config_set_wifi(ssid.c_str(), pass.c_str());
 }
 
-static bool nvsLoadWifi(String& ssidOut, String& passOut) {
-  Preferences p;
-  p.begin(WIFI_NS, true);
-  ssidOut = p.getString(KEY_SSID, "");
-  passOut = p.getString(KEY_PASS, "");
-  p.end();
-  ssidOut.trim();
-  passOut.trim();
+static bool loadSavedWifi(String& ssidOut, String& passOut) {
+  ssidOut = config_get_wifi_ssid();
+  passOut = config_get_wifi_pass();
   return (ssidOut.length() > 0);
 }
 
-static void nvsClearWifi() {
-  Preferences p;
-  p.begin(WIFI_NS, false);
-  p.remove(KEY_SSID);
-  p.remove(KEY_PASS);
-  p.end();
+static void clearSavedWifi() {
+  config_set_wifi("", "");
 
   WiFi.disconnect(true);
 }
 
 void wifi_app_forget_saved() {
-  nvsClearWifi();
+  clearSavedWifi();
 }
 
 // ============================================================
@@ -698,7 +682,7 @@ static void backspace() {
 static void clearPass() {
   {
   String ss, pw;
-  if (nvsLoadWifi(ss, pw) && ss == selectedSSID) passInput = pw;
+  if (loadSavedWifi(ss, pw) && ss == selectedSSID) passInput = pw;
   else passInput = "";
 }
 
@@ -731,6 +715,20 @@ static bool doConnect() {
   return true;
 }
 
+// OK: connect and go back to the list.
+static void submitPassword() {
+  if (doConnect()) {
+    mode = WIFI_MODE_LIST;
+    drawWindowFrame("Wireless Networks");
+    drawListBox();
+    drawButton(BTN_REFRESH_X, BTN_Y, BTN_W, BTN_H, "Refresh");
+    drawButton(BTN_CONNECT_X, BTN_Y, BTN_W, BTN_H, "Connect");
+    drawButton(BTN_BACK_X,    BTN_Y, BTN_W, BTN_H, "Back");
+    drawStatus("Connecting...");
+    drawList();
+  }
+}
+
 static bool handleKeyboardTouch(bool pressed, bool lastPressed, int x, int y) {
   if (mode != WIFI_MODE_CONNECT) return false;
 
@@ -761,18 +759,7 @@ static bool handleKeyboardTouch(bool pressed, bool lastPressed, int x, int y) {
       case KB_TOGGLE: kbNumbers = !kbNumbers; drawKeyboard(); break;
       case KB_SPACE:  addChar(' '); break;
       case KB_CLR:    clearPass(); break;
-      case KB_OK:
-        if (doConnect()) {
-          mode = WIFI_MODE_LIST;
-          drawWindowFrame("Wireless Networks");
-          drawListBox();
-          drawButton(BTN_REFRESH_X, BTN_Y, BTN_W, BTN_H, "Refresh");
-          drawButton(BTN_CONNECT_X, BTN_Y, BTN_W, BTN_H, "Connect");
-          drawButton(BTN_BACK_X,    BTN_Y, BTN_W, BTN_H, "Back");
-          drawStatus("Connecting...");
-          drawList();
-        }
-        break;
+      case KB_OK:     submitPassword(); break;
       default: break;
     }
 
@@ -815,17 +802,17 @@ static void drawConnectScreen() {
   drawButton(BTN_BACK_X,    BTN_Y, BTN_W, BTN_H, "Back");
 }
 
-void wifi_app_init(TFT_eSPI* display) {
+void wifi_app_init(Display* display) {
   tft = display;
 
   String ss, pw;
-  if (nvsLoadWifi(ss, pw)) savedSSID = ss;
+  if (loadSavedWifi(ss, pw)) savedSSID = ss;
   else savedSSID = "";
 }
 
 bool wifi_app_autoconnect(uint32_t timeoutMs) {
   String ss, pw;
-  if (!nvsLoadWifi(ss, pw)) return false;
+  if (!loadSavedWifi(ss, pw)) return false;
 
   savedSSID = ss;
 
@@ -853,7 +840,7 @@ void wifi_app_open() {
 
   {
     String ss, pw;
-    if (nvsLoadWifi(ss, pw)) savedSSID = ss;
+    if (loadSavedWifi(ss, pw)) savedSSID = ss;
     else savedSSID = "";
   }
 
@@ -876,6 +863,27 @@ void wifi_app_open() {
   startScanAsync();
 }
 
+void wifi_app_keys(const char* keys, int n) {
+  if (!opened || mode != WIFI_MODE_CONNECT) return;
+  // The field is repainted once for the whole batch.
+  bool changed = false;
+  for (int i = 0; i < n; i++) {
+    char c = keys[i];
+    if (c == INPUT_KEY_ENTER) {
+      if (changed) redrawPassFieldOnly();
+      submitPassword();
+      return;
+    }
+    if (c == INPUT_KEY_BACKSPACE) {
+      if (passInput.length() > 0) passInput.remove(passInput.length() - 1);
+    } else if (c >= ' ' && c <= '~' && passInput.length() < 64) {
+      passInput += c;
+    }
+    changed = true;
+  }
+  if (changed) redrawPassFieldOnly();
+}
+
 void wifi_app_tick() {
   if (opened) {
     uint32_t now = millis();
@@ -917,10 +925,10 @@ void wifi_app_tick() {
   if (st == WL_CONNECTED) {
     connecting = false;
 
- nvsSaveWifi(connectSSID, connectPASS);
+ bool saved = saveWifi(connectSSID, connectPASS);
 savedSSID = connectSSID;
 
-    if (opened) drawStatus("Connected. Saved");
+    if (opened) drawStatus(saved ? "Connected. Saved" : "Connected (not saved)");
   }
   else if (st == WL_CONNECT_FAILED || st == WL_NO_SSID_AVAIL) {
     connecting = false;
@@ -1004,7 +1012,7 @@ bool wifi_app_handleTouch(bool pressed, bool lastPressed, int x, int y) {
   // ===================== CONNECT MODE =====================
   if (mode == WIFI_MODE_CONNECT) {
     if (inRect(x,y,BTN_REFRESH_X,BTN_Y,BTN_W,BTN_H)) {
-      nvsClearWifi();
+      clearSavedWifi();
       savedSSID = "";
       drawStatus("Saved WiFi cleared");
       return true;
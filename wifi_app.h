@@ -1,9 +1,9 @@
 #pragma once
 #include <stdint.h>
-#include <TFT_eSPI.h>
+#include "display.h"
 
 // Init with display pointer
-void wifi_app_init(TFT_eSPI* display);
+void wifi_app_init(Display* display);
 
 // Open WiFi window (draws UI)
 void wifi_app_open();
@@ -11,6 +11,9 @@ void wifi_app_open();
 // Call frequently from loop()
 void wifi_app_tick();
 
+// Keys typed on the bridge go into the password field; Enter connects.
+void wifi_app_keys(const char* keys, int n);
+
 // Touch handler:
 // returns true  -> still open (keep routing touch to wifi app)
 // returns false -> closed (caller should return to desktop)